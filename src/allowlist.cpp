@@ -0,0 +1,413 @@
+// src/allowlist.cpp
+
+#include "allowlist.h"
+#include "manifest.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Formato del índice (enteros en little-endian):
+//   0  "HNSALLOW"        8  versión (u32)     12 ancho del digest (u32)
+//   16 registros (u64)   24 bloques de Bloom (u64, potencia de 2)
+//   32 offset del filtro 40 offset de la tabla   48..63 ceros
+static constexpr char kMagic[8] = { 'H', 'N', 'S', 'A', 'L', 'L', 'O', 'W' };
+static constexpr uint32_t kVersion = 1;
+static constexpr size_t kHeaderSize = 64;
+static constexpr size_t kBlockSize = 64;       // bytes por bloque: una línea de caché
+static constexpr uint64_t kBitsPerEntry = 12;  // antes de redondear a potencia de 2
+static constexpr int kBloomK = 7;              // 7 posiciones de 9 bits por digest
+
+static uint64_t load_le64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+static uint64_t load_be64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v = (v << 8) | p[i];
+    return v;
+}
+
+static void store_le(uint8_t* p, uint64_t v, int n) {
+    for (int i = 0; i < n; ++i, v >>= 8) p[i] = (uint8_t)v;
+}
+
+// Los digests ya son uniformes: el bloque sale de los 8 primeros bytes y los
+// bits dentro de él de los 8 siguientes, sin volver a hashear
+static uint64_t bloom_block(const uint8_t* d, uint64_t blocks) {
+    return load_le64(d) & (blocks - 1);
+}
+
+static unsigned bloom_bit(const uint8_t* d, int i) {
+    return (unsigned)(load_le64(d + 8) >> (9 * i)) & (kBlockSize * 8 - 1);
+}
+
+static uint64_t bloom_blocks_for(uint64_t n) {
+    uint64_t want = (n * kBitsPerEntry + kBlockSize * 8 - 1) / (kBlockSize * 8);
+    uint64_t blocks = 1;
+    while (blocks < want) blocks <<= 1;
+    return blocks;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// 32 o 64 dígitos hex -> bytes; 0 si no es un digest MD5/SHA-256
+static size_t parse_hex_digest(const char* s, size_t len, uint8_t* out) {
+    if (len != 32 && len != 64) return 0;
+    for (size_t i = 0; i < len; i += 2) {
+        int hi = hex_value(s[i]), lo = hex_value(s[i + 1]);
+        if (hi < 0 || lo < 0) return 0;
+        out[i / 2] = (uint8_t)(hi << 4 | lo);
+    }
+    return len / 2;
+}
+
+// ------------------------------------------------------------- compilación
+
+namespace {
+
+template <size_t W>
+struct Record {
+    uint8_t b[W];
+    bool operator<(const Record& o) const { return std::memcmp(b, o.b, W) < 0; }
+    bool operator==(const Record& o) const { return std::memcmp(b, o.b, W) == 0; }
+};
+
+template <size_t W>
+uint64_t sort_unique_impl(uint8_t* recs, uint64_t n) {
+    auto* r = reinterpret_cast<Record<W>*>(recs);
+    std::sort(r, r + n);
+    return (uint64_t)(std::unique(r, r + n) - r);
+}
+
+} // namespace
+
+static uint64_t sort_unique(uint8_t* recs, uint64_t n, size_t width) {
+    return width == 16 ? sort_unique_impl<16>(recs, n) : sort_unique_impl<32>(recs, n);
+}
+
+static uint64_t index_size(uint64_t n, size_t width) {
+    return kHeaderSize + bloom_blocks_for(n) * kBlockSize + n * width;
+}
+
+// Escribe el índice completo en 'out' (index_size bytes, a cero)
+static void fill_index(uint8_t* out, const uint8_t* recs, uint64_t n, size_t width) {
+    uint64_t blocks = bloom_blocks_for(n);
+    uint64_t bloom_off = kHeaderSize, table_off = kHeaderSize + blocks * kBlockSize;
+    std::memcpy(out, kMagic, sizeof(kMagic));
+    store_le(out + 8, kVersion, 4);
+    store_le(out + 12, width, 4);
+    store_le(out + 16, n, 8);
+    store_le(out + 24, blocks, 8);
+    store_le(out + 32, bloom_off, 8);
+    store_le(out + 40, table_off, 8);
+    uint8_t* bloom = out + bloom_off;
+    for (uint64_t i = 0; i < n; ++i) {
+        const uint8_t* d = recs + i * width;
+        uint8_t* block = bloom + bloom_block(d, blocks) * kBlockSize;
+        for (int k = 0; k < kBloomK; ++k) {
+            unsigned bit = bloom_bit(d, k);
+            block[bit >> 3] |= (uint8_t)(1u << (bit & 7));
+        }
+    }
+    if (n) std::memcpy(out + table_off, recs, n * width);
+}
+
+// Lee la lista y llama a 'emit' por digest válido. Todos deben tener el mismo
+// ancho (el del primero).
+template <class Emit>
+static bool parse_list(const fs::path& list, size_t& width, uint64_t& bad, Emit emit, std::string& out_log) {
+    std::ifstream ifs(list);
+    if (!ifs.is_open()) {
+        out_log += "No se puede abrir " + list.string() + "\n";
+        return false;
+    }
+    width = 0;
+    bad = 0;
+    std::string line;
+    uint8_t d[32];
+    while (std::getline(ifs, line)) {
+        size_t a = line.find_first_not_of(" \t\r");
+        if (a == std::string::npos || line[a] == '#') continue;
+        size_t b = line.find_first_of(" \t\r", a);
+        size_t w = parse_hex_digest(line.data() + a, (b == std::string::npos ? line.size() : b) - a, d);
+        if (w == 0 || (width && w != width)) {
+            ++bad;
+            continue;
+        }
+        width = w;
+        if (!emit(d)) {
+            out_log += "Error de escritura compilando " + list.string() + "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool allowlist_build(const fs::path& list, const fs::path& index, std::string& out_log) {
+    size_t width = 0;
+    uint64_t bad = 0, n = 0;
+    fs::path tmp = index;
+    std::error_code ec;
+#ifndef _WIN32
+    tmp += ".tmp" + std::to_string((long)getpid());
+    // Registros sin ordenar a un temporal, que luego se ordena mapeado
+    fs::path raw = tmp;
+    raw += ".raw";
+    {
+        std::ofstream ofs(raw, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) {
+            out_log += "Error: no se puede crear " + raw.string() + "\n";
+            return false;
+        }
+        bool ok = parse_list(list, width, bad, [&](const uint8_t* d) {
+            ofs.write(reinterpret_cast<const char*>(d), (std::streamsize)width);
+            ++n;
+            return (bool)ofs;
+        }, out_log);
+        ofs.close();
+        if (!ok || !ofs) {
+            fs::remove(raw, ec);
+            return false;
+        }
+    }
+    if (width == 0) width = 16;
+
+    bool ok = false;
+    int rfd = ::open(raw.c_str(), O_RDWR | O_CLOEXEC);
+    int ofd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    uint64_t total = 0;
+    if (rfd >= 0 && ofd >= 0) {
+        uint64_t raw_size = n * width;
+        void* recs = n ? mmap(nullptr, raw_size, PROT_READ | PROT_WRITE, MAP_SHARED, rfd, 0) : nullptr;
+        if (n == 0 || recs != MAP_FAILED) {
+            n = n ? sort_unique(static_cast<uint8_t*>(recs), n, width) : 0;
+            total = index_size(n, width);
+            void* out = ftruncate(ofd, (off_t)total) == 0
+                            ? mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, ofd, 0)
+                            : MAP_FAILED;
+            if (out != MAP_FAILED) {
+                fill_index(static_cast<uint8_t*>(out), static_cast<uint8_t*>(recs), n, width);
+                ok = msync(out, total, MS_SYNC) == 0;
+                munmap(out, total);
+            }
+            if (recs) munmap(recs, raw_size);
+        }
+    }
+    if (rfd >= 0) ::close(rfd);
+    if (ofd >= 0) ::close(ofd);
+    fs::remove(raw, ec);
+#else
+    tmp += ".tmp";
+    std::vector<uint8_t> recs;
+    if (!parse_list(list, width, bad, [&](const uint8_t* d) {
+            recs.insert(recs.end(), d, d + width);
+            return true;
+        }, out_log))
+        return false;
+    if (width == 0) width = 16;
+    n = sort_unique(recs.data(), recs.size() / width, width);
+    uint64_t total = index_size(n, width);
+    std::vector<uint8_t> out(total);
+    fill_index(out.data(), recs.data(), n, width);
+    std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char*>(out.data()), (std::streamsize)out.size());
+    ofs.close();
+    bool ok = (bool)ofs;
+#endif
+    if (!ok) {
+        out_log += "Error compilando " + list.string() + " en " + index.string() + "\n";
+        fs::remove(tmp, ec);
+        return false;
+    }
+    fs::rename(tmp, index, ec);
+    if (ec) {
+        out_log += "Error: no se puede reemplazar " + index.string() + ": " + ec.message() + "\n";
+        fs::remove(tmp, ec);
+        return false;
+    }
+    out_log += "Allowlist compilada: " + index.string() + " (" + std::to_string(n) + " digests de " +
+               std::to_string(width * 8) + " bits, " + std::to_string(total >> 20) + " MiB";
+    if (bad) out_log += ", " + std::to_string(bad) + " líneas ignoradas";
+    out_log += ")\n";
+    return true;
+}
+
+// ------------------------------------------------------------------ consulta
+
+Allowlist::~Allowlist() {
+    close();
+}
+
+void Allowlist::close() {
+#ifndef _WIN32
+    if (base_ && heap_.empty()) munmap(const_cast<uint8_t*>(base_), mapped_);
+#endif
+    heap_.clear();
+    heap_.shrink_to_fit();
+    base_ = bloom_ = table_ = nullptr;
+    mapped_ = 0;
+    blocks_ = count_ = 0;
+    width_ = 0;
+}
+
+bool Allowlist::map(const fs::path& index, std::string& out_log) {
+    close();
+#ifndef _WIN32
+    int fd = ::open(index.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) ::close(fd);
+        out_log += "No se puede abrir " + index.string() + "\n";
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    void* m = size ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (m == MAP_FAILED) {
+        out_log += "mmap falló para " + index.string() + "\n";
+        return false;
+    }
+    // Consultas dispersas: sin lectura anticipada
+    madvise(m, size, MADV_RANDOM);
+    base_ = static_cast<const uint8_t*>(m);
+    mapped_ = size;
+#else
+    std::ifstream ifs(index, std::ios::binary);
+    heap_.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    if (heap_.empty()) {
+        out_log += "No se puede abrir " + index.string() + "\n";
+        return false;
+    }
+    base_ = heap_.data();
+    mapped_ = heap_.size();
+#endif
+    uint64_t width = 0, blocks = 0, bloom_off = 0, table_off = 0, count = 0;
+    bool ok = mapped_ >= kHeaderSize && std::memcmp(base_, kMagic, sizeof(kMagic)) == 0 &&
+              (load_le64(base_ + 8) & 0xffffffffu) == kVersion;
+    if (ok) {
+        width = load_le64(base_ + 8) >> 32;
+        count = load_le64(base_ + 16);
+        blocks = load_le64(base_ + 24);
+        bloom_off = load_le64(base_ + 32);
+        table_off = load_le64(base_ + 40);
+        ok = (width == 16 || width == 32) && blocks && (blocks & (blocks - 1)) == 0 &&
+             blocks <= mapped_ / kBlockSize && bloom_off >= kHeaderSize &&
+             bloom_off + blocks * kBlockSize <= table_off && table_off <= mapped_ &&
+             count <= (mapped_ - table_off) / width;
+    }
+    if (!ok) {
+        out_log += index.string() + " no es un índice de allowlist válido\n";
+        close();
+        return false;
+    }
+    width_ = (size_t)width;
+    count_ = count;
+    blocks_ = blocks;
+    bloom_ = base_ + bloom_off;
+    table_ = base_ + table_off;
+    return true;
+}
+
+bool Allowlist::open(const fs::path& path, std::string& out_log) {
+    char head[sizeof(kMagic)] = {};
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs.is_open()) {
+            out_log += "No se puede abrir " + path.string() + "\n";
+            return false;
+        }
+        ifs.read(head, sizeof(head));
+    }
+    if (std::memcmp(head, kMagic, sizeof(kMagic)) == 0) return map(path, out_log);
+
+    fs::path index = path;
+    index += ".idx";
+    std::error_code ec;
+    auto list_time = fs::last_write_time(path, ec);
+    auto index_time = fs::last_write_time(index, ec);
+    if (ec || index_time < list_time) {
+        if (!allowlist_build(path, index, out_log)) return false;
+    }
+    if (!map(index, out_log)) return false;
+    out_log += "Allowlist: " + std::to_string(count_) + " digests (" + index.string() + ")\n";
+    return true;
+}
+
+bool Allowlist::contains(const uint8_t* d) const {
+    if (count_ == 0) return false;
+    const uint8_t* block = bloom_ + bloom_block(d, blocks_) * kBlockSize;
+    for (int k = 0; k < kBloomK; ++k) {
+        unsigned bit = bloom_bit(d, k);
+        if (!(block[bit >> 3] & (1u << (bit & 7)))) return false;
+    }
+    // Búsqueda por interpolación sobre los 8 primeros bytes (el orden de la
+    // tabla es el de memcmp, es decir big-endian); si a los pocos pasos no ha
+    // acotado, bisección, por si la lista no es uniforme
+    uint64_t key = load_be64(d);
+    uint64_t lo = 0, hi = count_; // [lo, hi)
+    for (int step = 0; hi - lo > 8; ++step) {
+        uint64_t mid;
+        if (step < 4) {
+            uint64_t klo = load_be64(table_ + lo * width_), khi = load_be64(table_ + (hi - 1) * width_);
+            if (key < klo || key > khi) return false;
+            long double frac = khi == klo ? 0.5L : (long double)(key - klo) / (long double)(khi - klo);
+            mid = lo + (uint64_t)(frac * (long double)(hi - 1 - lo));
+        } else {
+            mid = lo + (hi - lo) / 2;
+        }
+        int c = std::memcmp(table_ + mid * width_, d, width_);
+        if (c == 0) return true;
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    for (; lo < hi; ++lo)
+        if (std::memcmp(table_ + lo * width_, d, width_) == 0) return true;
+    return false;
+}
+
+bool Allowlist::contains_hex(const std::string& hex) const {
+    uint8_t d[32];
+    return parse_hex_digest(hex.data(), hex.size(), d) == width_ && contains(d);
+}
+
+bool allowlist_check_manifest(const Allowlist& allow, const fs::path& manifest, std::string& out_log) {
+    uint64_t total = 0, missing = 0;
+    bool wrong_width = false;
+    bool ok = for_each_manifest_entry(manifest, [&](ManifestEntry&& e) {
+        if (e.path.rfind("./", 0) == 0 && is_manifest_artifact(e.path.substr(2))) return;
+        ++total;
+        if (e.digest.size() != allow.digest_size() * 2) wrong_width = true;
+        else if (allow.contains_hex(e.digest)) return;
+        ++missing;
+        if (!wrong_width) out_log += e.path + ": NO APROBADO\n";
+    }, out_log);
+    if (!ok) return false;
+    if (wrong_width) {
+        out_log += "La allowlist es de digests de " + std::to_string(allow.digest_size() * 8) + " bits y " +
+                   manifest.string() + " no\n";
+        return false;
+    }
+    if (missing) {
+        out_log += "Allowlist: " + std::to_string(missing) + " de " + std::to_string(total) +
+                   " archivos no aprobados en " + manifest.string() + "\n";
+        return false;
+    }
+    out_log += "Allowlist: los " + std::to_string(total) + " archivos están aprobados\n";
+    return true;
+}
@@ -0,0 +1,66 @@
+// src/allowlist.h
+// Lista de digests aprobados (p.ej. los de terceros validados por la empresa,
+// decenas de millones): los archivos cuyo digest no esté en ella se señalan
+// al generar y al verificar.
+//
+// La lista de texto (un digest hex por línea; vale la salida de md5sum o
+// sha256sum) se compila una vez a un índice binario <lista>.idx que se abre
+// con mmap, sin cargarlo en el heap:
+//   cabecera de 64 bytes | filtro de Bloom por bloques | tabla ordenada
+// El filtro (bloques de 64 bytes, una línea de caché por consulta) descarta
+// casi todos los digests ausentes; los que pasan se buscan en la tabla de
+// registros de ancho fijo por interpolación, que con digests uniformes toca
+// un par de páginas.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class Allowlist {
+public:
+    Allowlist() = default;
+    ~Allowlist();
+    Allowlist(const Allowlist&) = delete;
+    Allowlist& operator=(const Allowlist&) = delete;
+
+    // Abre 'path': un índice ya compilado, o una lista de texto cuyo
+    // <path>.idx se (re)compila si falta o es más antiguo que ella.
+    bool open(const fs::path& path, std::string& out_log);
+    void close();
+
+    bool is_open() const { return base_ != nullptr; }
+    size_t digest_size() const { return width_; }
+    uint64_t size() const { return count_; }
+
+    // 'digest' tiene digest_size() bytes
+    bool contains(const uint8_t* digest) const;
+    // Hex en minúsculas o mayúsculas; false si no tiene el ancho de la lista
+    bool contains_hex(const std::string& hex) const;
+
+private:
+    bool map(const fs::path& index, std::string& out_log);
+
+    const uint8_t* base_ = nullptr;
+    size_t mapped_ = 0;
+    std::vector<uint8_t> heap_; // donde no hay mmap
+    const uint8_t* bloom_ = nullptr;
+    uint64_t blocks_ = 0;
+    const uint8_t* table_ = nullptr;
+    uint64_t count_ = 0;
+    size_t width_ = 0;
+};
+
+// Compila la lista de texto 'list' en el índice 'index' (ordena y quita
+// duplicados sobre un archivo temporal mapeado, no en el heap).
+bool allowlist_build(const fs::path& list, const fs::path& index, std::string& out_log);
+
+// Comprueba las entradas de un manifiesto (hashes.md5) contra la lista y
+// anota "./ruta: NO APROBADO" por cada digest que no está. Los propios
+// artefactos de hashnsign no cuentan.
+bool allowlist_check_manifest(const Allowlist& allow, const fs::path& manifest, std::string& out_log);
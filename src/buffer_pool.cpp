@@ -0,0 +1,190 @@
+// src/buffer_pool.cpp
+
+#include "buffer_pool.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// "0-3,8-11" -> {0,1,2,3,8,9,10,11}
+static std::vector<int> parse_cpulist(const std::string& s) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < s.size()) {
+        size_t comma = s.find(',', pos);
+        std::string part = s.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        pos = (comma == std::string::npos) ? s.size() : comma + 1;
+        if (part.empty() || part[0] == '\n') continue;
+        size_t dash = part.find('-');
+        int lo = std::atoi(part.c_str());
+        int hi = (dash == std::string::npos) ? lo : std::atoi(part.c_str() + dash + 1);
+        for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+const NumaTopology& NumaTopology::get() {
+    static const NumaTopology topo = [] {
+        NumaTopology t;
+#ifdef __linux__
+        std::error_code ec;
+        std::set<int> ids;
+        for (auto& p : fs::directory_iterator("/sys/devices/system/node", ec)) {
+            std::string name = p.path().filename().string();
+            if (name.rfind("node", 0) == 0 && name.size() > 4 && std::isdigit((unsigned char)name[4]))
+                ids.insert(std::atoi(name.c_str() + 4));
+        }
+        for (int id : ids) {
+            std::ifstream ifs("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+            std::string line;
+            std::getline(ifs, line);
+            auto cpus = parse_cpulist(line);
+            if (cpus.empty()) continue;
+            t.ids.push_back(id);
+            t.cpus.push_back(std::move(cpus));
+        }
+#endif
+        return t;
+    }();
+    return topo;
+}
+
+bool pin_thread_to_node(int node) {
+#ifdef __linux__
+    const auto& topo = NumaTopology::get();
+    for (size_t i = 0; i < topo.ids.size(); ++i) {
+        if (topo.ids[i] != node) continue;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : topo.cpus[i]) if (c < CPU_SETSIZE) CPU_SET(c, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+    return false;
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+BufferPool::BufferPool(size_t buffer_size)
+    : buffer_size_((buffer_size + kHugePage - 1) / kHugePage * kHugePage) {}
+
+BufferPool::~BufferPool() {
+    for (auto& b : all_) {
+#ifdef __linux__
+        munmap(b.data, b.size);
+#else
+        std::free(b.data);
+#endif
+    }
+}
+
+BufferPool& BufferPool::shared() {
+    static BufferPool pool;
+    return pool;
+}
+
+IoBuffer BufferPool::allocate(int node, bool huge_pages) {
+    IoBuffer b;
+    b.size = buffer_size_;
+    b.node = node;
+    b.want_huge = huge_pages;
+#ifdef __linux__
+    void* p = MAP_FAILED;
+    if (huge_pages) {
+        // Solo funciona si hay páginas reservadas en vm.nr_hugepages
+        p = mmap(nullptr, b.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        b.huge = (p != MAP_FAILED);
+    }
+    if (p == MAP_FAILED) {
+        p = mmap(nullptr, b.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return IoBuffer{};
+        // Transparent huge pages como alternativa
+        if (huge_pages) madvise(p, b.size, MADV_HUGEPAGE);
+    }
+    if (node >= 0) {
+        // mbind sin depender de libnuma: la máscara es un bitmap de nodos. La
+        // reserva de hugetlb no es por nodo: con MPOL_BIND el primer toque da
+        // SIGBUS si el nodo no tiene páginas grandes libres, así que esas solo
+        // prefieren el nodo y caen a otro si hace falta.
+        const int MPOL_PREFERRED_ = 1, MPOL_BIND_ = 2;
+        unsigned long mask[16] = {};
+        if (node < (int)(sizeof(mask) * 8)) {
+            mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+            b.bound = syscall(SYS_mbind, p, b.size, b.huge ? MPOL_PREFERRED_ : MPOL_BIND_, mask, sizeof(mask) * 8,
+                              0) == 0;
+        }
+    }
+    // Primer toque desde el hilo ya fijado: las páginas quedan en el nodo local
+    std::memset(p, 0, b.size);
+    b.data = static_cast<char*>(p);
+#else
+    (void)huge_pages;
+    b.data = static_cast<char*>(std::malloc(b.size));
+    if (!b.data) return IoBuffer{};
+#endif
+    return b;
+}
+
+IoBuffer BufferPool::acquire(int node, bool huge_pages) {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        size_t slot = 2 * (size_t)(node + 1) + (huge_pages ? 1 : 0);
+        if (slot < free_.size() && !free_[slot].empty()) {
+            IoBuffer b = free_[slot].back();
+            free_[slot].pop_back();
+            return b;
+        }
+    }
+    IoBuffer b = allocate(node, huge_pages);
+    if (b.data) {
+        std::lock_guard<std::mutex> lk(mu_);
+        all_.push_back(b);
+    }
+    return b;
+}
+
+void BufferPool::release(const IoBuffer& b) {
+    if (!b.data) return;
+    std::lock_guard<std::mutex> lk(mu_);
+    size_t slot = 2 * (size_t)(b.node + 1) + (b.want_huge ? 1 : 0);
+    if (free_.size() <= slot) free_.resize(slot + 1);
+    free_[slot].push_back(b);
+}
+
+uint64_t BufferPool::bytes() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    uint64_t n = 0;
+    for (auto& b : all_) n += b.size;
+    return n;
+}
+
+std::string BufferPool::describe() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    size_t huge = 0;
+    std::set<int> nodes;
+    for (auto& b : all_) {
+        if (b.huge) ++huge;
+        if (b.bound) nodes.insert(b.node);
+    }
+    std::string s = std::to_string(all_.size()) + " buffers (" + std::to_string(huge) + " huge)";
+    if (!nodes.empty()) {
+        s += ", nodos ";
+        bool first = true;
+        for (int n : nodes) { s += (first ? "" : ",") + std::to_string(n); first = false; }
+    }
+    return s;
+}
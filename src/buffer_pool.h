@@ -0,0 +1,68 @@
+// src/buffer_pool.h
+// Pool de buffers de E/S para el motor de hashing: páginas grandes (2 MiB)
+// y memoria ligada al nodo NUMA del worker que la usa.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Nodos NUMA con CPUs según /sys/devices/system/node. Vacío en máquinas sin
+// NUMA o fuera de Linux; los nodos solo de memoria no se listan.
+struct NumaTopology {
+    std::vector<int> ids;                 // id real del nodo (para mbind)
+    std::vector<std::vector<int>> cpus;   // CPUs de ids[i]
+
+    static const NumaTopology& get();
+    size_t nodes() const { return ids.empty() ? 1 : ids.size(); }
+    // Nodo para el worker i (reparto round-robin), -1 sin topología
+    int node_for_worker(size_t i) const { return ids.empty() ? -1 : ids[i % ids.size()]; }
+};
+
+struct IoBuffer {
+    char* data = nullptr;
+    size_t size = 0;
+    int node = -1;          // nodo NUMA pedido (-1 = sin preferencia)
+    bool bound = false;     // mbind aceptado por el kernel (MPOL_PREFERRED con MAP_HUGETLB)
+    bool huge = false;      // MAP_HUGETLB concedido (si no, solo MADV_HUGEPAGE)
+    bool want_huge = false; // huge_pages pedido en acquire: el pool no los mezcla
+};
+
+class BufferPool {
+public:
+    static constexpr size_t kHugePage = 2u << 20;
+
+    explicit BufferPool(size_t buffer_size = kHugePage);
+    ~BufferPool();
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Devuelve un buffer del nodo indicado, reutilizando los liberados. Debe
+    // llamarse desde el hilo ya fijado a ese nodo: la memoria nueva se toca
+    // en el acto para que la primera escritura la sitúe en el nodo local.
+    IoBuffer acquire(int node, bool huge_pages);
+    void release(const IoBuffer& b);
+
+    // "3 buffers (2 huge), nodos 0,1" para el log
+    std::string describe() const;
+    // Bytes reservados entre todos los buffers
+    uint64_t bytes() const;
+
+    // Pool compartido por generar y verificar: los buffers sobreviven entre
+    // pasadas para no pagar mmap/fallos de página en cada repo.
+    static BufferPool& shared();
+
+private:
+    IoBuffer allocate(int node, bool huge_pages);
+
+    size_t buffer_size_;
+    mutable std::mutex mu_;
+    std::vector<std::vector<IoBuffer>> free_;  // por nodo y huge_pages (índice 2*(node+1)+huge)
+    std::vector<IoBuffer> all_;
+};
+
+// Fija el hilo actual a las CPUs del nodo. No hace nada si no hay topología.
+bool pin_thread_to_node(int node);
@@ -0,0 +1,270 @@
+// src/digest_cache.cpp
+
+#include "digest_cache.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/xattr.h>
+#endif
+
+static int64_t mtime_ns(const struct stat& st) {
+    return (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+static int64_t ctime_ns(const struct stat& st) {
+    return (int64_t)st.st_ctim.tv_sec * 1000000000 + st.st_ctim.tv_nsec;
+}
+
+// ------------------------------------------------------------------- xattrs
+
+static std::string xattr_name(HashAlgo algo) {
+    return std::string("user.hashnsign.") + algo_name(algo);
+}
+
+static bool xattr_lookup(int fd, const struct stat& st, HashAlgo algo, std::string& hex) {
+#ifdef __linux__
+    char val[256];
+    ssize_t n = fgetxattr(fd, xattr_name(algo).c_str(), val, sizeof(val) - 1);
+    if (n < 0) return false; // ENODATA, o ENOTSUP si el sistema de ficheros no los admite
+    val[n] = '\0';
+    std::istringstream iss(val);
+    std::string ver, digest;
+    uint64_t size = 0;
+    int64_t mt = 0;
+    if (!(iss >> ver >> size >> mt >> digest) || ver != "v1") return false;
+    if (size != (uint64_t)st.st_size || mt != mtime_ns(st)) return false;
+    hex = digest;
+    return true;
+#else
+    (void)fd; (void)st; (void)algo; (void)hex;
+    return false;
+#endif
+}
+
+static bool xattr_store(int fd, const struct stat& st, HashAlgo algo, const std::string& hex) {
+#ifdef __linux__
+    std::string val = "v1 " + std::to_string((uint64_t)st.st_size) + " " + std::to_string(mtime_ns(st)) + " " + hex;
+    return fsetxattr(fd, xattr_name(algo).c_str(), val.data(), val.size(), 0) == 0;
+#else
+    (void)fd; (void)st; (void)algo; (void)hex;
+    return false;
+#endif
+}
+
+// ------------------------------------------------------------ caché central
+
+namespace {
+
+struct CentralEntry {
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    int64_t ctime_ns = 0;
+    uint64_t ino = 0;
+    std::string digest;
+};
+
+// Una línea por archivo y algoritmo:
+//   <algo>\t<tamaño>\t<mtime_ns>\t<ctime_ns>\t<inodo>\t<digest>\t<ruta absoluta>
+class CentralCache {
+public:
+    static CentralCache& shared() {
+        static CentralCache c;
+        return c;
+    }
+
+    bool lookup(const std::string& key, const struct stat& st, std::string& hex) {
+        std::lock_guard<std::mutex> lk(mu_);
+        load_locked();
+        auto it = map_.find(key);
+        if (it == map_.end()) return false;
+        const CentralEntry& e = it->second;
+        if (e.size != (uint64_t)st.st_size || e.mtime_ns != mtime_ns(st) || e.ctime_ns != ctime_ns(st) ||
+            e.ino != (uint64_t)st.st_ino)
+            return false;
+        hex = e.digest;
+        return true;
+    }
+
+    void store(const std::string& key, const struct stat& st, const std::string& hex) {
+        std::lock_guard<std::mutex> lk(mu_);
+        load_locked();
+        CentralEntry& e = map_[key];
+        e.size = (uint64_t)st.st_size;
+        e.mtime_ns = mtime_ns(st);
+        e.ctime_ns = ctime_ns(st);
+        e.ino = (uint64_t)st.st_ino;
+        e.digest = hex;
+        dirty_ = true;
+    }
+
+    // Sin comprobar tamaño ni tiempos (puntos de reanudación: el archivo creció)
+    bool get(const std::string& key, CentralEntry& out) {
+        std::lock_guard<std::mutex> lk(mu_);
+        load_locked();
+        auto it = map_.find(key);
+        if (it == map_.end()) return false;
+        out = it->second;
+        return true;
+    }
+
+    void put(const std::string& key, CentralEntry e) {
+        std::lock_guard<std::mutex> lk(mu_);
+        load_locked();
+        map_[key] = std::move(e);
+        dirty_ = true;
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (!dirty_ || file_.empty()) return;
+        std::error_code ec;
+        fs::create_directories(file_.parent_path(), ec);
+        // Escritura atómica: otra instancia puede estar leyéndola
+        fs::path tmp = file_;
+        tmp += ".tmp" + std::to_string((long)getpid());
+        {
+            std::ofstream ofs(tmp, std::ios::trunc);
+            if (!ofs.is_open()) return;
+            for (auto& [key, e] : map_) {
+                size_t tab = key.find('\t');
+                ofs << key.substr(0, tab) << '\t' << e.size << '\t' << e.mtime_ns << '\t' << e.ctime_ns << '\t'
+                    << e.ino << '\t' << e.digest << '\t' << key.substr(tab + 1) << '\n';
+            }
+            if (!ofs) return;
+        }
+        fs::rename(tmp, file_, ec);
+        if (!ec) dirty_ = false;
+    }
+
+private:
+    static fs::path default_file() {
+        if (const char* x = std::getenv("XDG_CACHE_HOME"); x && *x) return fs::path(x) / "hashnsign" / "digests";
+        if (const char* h = std::getenv("HOME"); h && *h) return fs::path(h) / ".cache" / "hashnsign" / "digests";
+        return {};
+    }
+
+    void load_locked() {
+        if (loaded_) return;
+        loaded_ = true;
+        file_ = default_file();
+        std::ifstream ifs(file_);
+        std::string line;
+        while (std::getline(ifs, line)) {
+            std::istringstream iss(line);
+            std::string algo, digest, path;
+            CentralEntry e;
+            if (!std::getline(iss, algo, '\t')) continue;
+            if (!(iss >> e.size >> e.mtime_ns >> e.ctime_ns >> e.ino >> digest)) continue;
+            iss.get(); // '\t'
+            if (!std::getline(iss, path) || path.empty()) continue;
+            e.digest = digest;
+            map_[algo + '\t' + path] = std::move(e);
+        }
+    }
+
+    std::mutex mu_;
+    bool loaded_ = false;
+    bool dirty_ = false;
+    fs::path file_;
+    std::unordered_map<std::string, CentralEntry> map_;
+};
+
+} // namespace
+
+static std::string central_key(const fs::path& file, const std::string& kind) {
+    std::error_code ec;
+    fs::path abs = fs::absolute(file, ec);
+    if (ec) return {};
+    std::string p = abs.lexically_normal().string();
+    // Rutas con separadores del formato no se guardan
+    if (p.find_first_of("\t\n") != std::string::npos) return {};
+    return kind + '\t' + p;
+}
+
+// -------------------------------------------------------------------- API
+
+bool digest_cache_lookup(int fd, const fs::path& file, const struct stat& st, HashAlgo algo, std::string& hex) {
+    if (xattr_lookup(fd, st, algo, hex)) return true;
+    // Sin xattr válido se mira la central: puede que no se pudiera escribir
+    // (ENOTSUP, EACCES, EPERM) y el digest se guardara allí
+    std::string key = central_key(file, algo_name(algo));
+    return !key.empty() && CentralCache::shared().lookup(key, st, hex);
+}
+
+void digest_cache_store(int fd, const fs::path& file, const struct stat& st, HashAlgo algo, const std::string& hex) {
+    // Un mtime del último par de segundos puede repetirse tras otra escritura
+    // con la granularidad del sistema de ficheros ("racy git")
+    if ((int64_t)std::time(nullptr) - (int64_t)st.st_mtim.tv_sec < 2) return;
+    if (xattr_store(fd, st, algo, hex)) return;
+    std::string key = central_key(file, algo_name(algo));
+    if (!key.empty()) CentralCache::shared().store(key, st, hex);
+}
+
+// ------------------------------------------------------ puntos de reanudación
+
+// Valor (xattr) o campo digest (central): "<tail>/<estado>"
+static bool parse_resume(const std::string& v, ResumePoint& rp) {
+    size_t slash = v.find('/');
+    if (slash == std::string::npos || slash == 0) return false;
+    rp.tail = v.substr(0, slash);
+    rp.state = v.substr(slash + 1);
+    return !rp.state.empty();
+}
+
+bool resume_point_lookup(int fd, const fs::path& file, const struct stat& st, HashAlgo algo, ResumePoint& rp) {
+#ifdef __linux__
+    // El estado de SHA-256 más el bloque a medias cabe de sobra
+    char val[512];
+    std::string name = xattr_name(algo) + ".resume";
+    ssize_t n = fgetxattr(fd, name.c_str(), val, sizeof(val) - 1);
+    if (n > 0) {
+        val[n] = '\0';
+        std::istringstream iss(val);
+        std::string ver, rest;
+        if (iss >> ver >> rp.offset >> rest && ver == "v1" && parse_resume(rest, rp)) return true;
+    }
+#endif
+    std::string key = central_key(file, std::string(algo_name(algo)) + ".resume");
+    CentralEntry e;
+    if (key.empty() || !CentralCache::shared().get(key, e)) return false;
+    // Mismo archivo: un reemplazo con el mismo nombre no se reanuda
+    if (e.ino != (uint64_t)st.st_ino) return false;
+    rp.offset = e.size;
+    return parse_resume(e.digest, rp);
+}
+
+void resume_point_store(int fd, const fs::path& file, const struct stat& st, HashAlgo algo, const ResumePoint& rp) {
+    std::string v = rp.tail + "/" + rp.state;
+#ifdef __linux__
+    std::string name = xattr_name(algo) + ".resume";
+    std::string val = "v1 " + std::to_string(rp.offset) + " " + v;
+    if (fsetxattr(fd, name.c_str(), val.data(), val.size(), 0) == 0) return;
+#endif
+    std::string key = central_key(file, std::string(algo_name(algo)) + ".resume");
+    if (key.empty()) return;
+    CentralEntry e;
+    e.size = rp.offset;
+    e.ino = (uint64_t)st.st_ino;
+    e.digest = v;
+    CentralCache::shared().put(key, std::move(e));
+}
+
+void digest_cache_flush() {
+    CentralCache::shared().flush();
+}
+
+#else
+
+void digest_cache_flush() {}
+
+#endif
@@ -0,0 +1,53 @@
+// src/digest_cache.h
+// Caché de digests por archivo, para no releer lo que no ha cambiado.
+//
+// Primero en xattrs del propio archivo (user.hashnsign.<algo> = "v1 <tamaño>
+// <mtime_ns> <digest>"): viaja con él en copias que conservan xattrs (cp -a,
+// rsync -X, tar --xattrs) y la consulta no cuesta más E/S que un getxattr.
+// No se guarda ctime ahí: escribir el propio xattr la cambia, y cualquier copia
+// también. Donde no hay xattrs de usuario (tmpfs antiguos, vfat, NFS, archivos
+// sin permiso de escritura) se usa una caché central en
+// $XDG_CACHE_HOME/hashnsign/digests, que además exige inodo y ctime iguales.
+//
+// Solo sirve para generar: cualquiera que pueda escribir el archivo puede
+// cambiar el contenido y restaurar el mtime, o plantar el xattr, así que
+// verificar nunca la consulta (verify_hash_options).
+//
+// Escribir el xattr cambia el ctime del archivo: git (core.trustctime) y
+// fsmonitor/Watchman lo ven como modificado y lo vuelven a mirar una vez tras
+// cada generación con la caché activa.
+
+#pragma once
+
+#include "hash_engine.h"
+
+#include <string>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+
+// Digest guardado para el archivo abierto en 'fd' si 'st' (su fstat) coincide
+// con lo guardado.
+bool digest_cache_lookup(int fd, const fs::path& file, const struct stat& st, HashAlgo algo, std::string& hex);
+
+// Guarda 'hex' calculado con el archivo en el estado 'st'. No guarda nada si el
+// mtime es demasiado reciente para distinguir una escritura posterior en el
+// mismo tick del sistema de ficheros.
+void digest_cache_store(int fd, const fs::path& file, const struct stat& st, HashAlgo algo, const std::string& hex);
+
+// Punto de reanudación de un archivo que solo crece, guardado igual que el
+// digest (user.hashnsign.<algo>.resume o la caché central): el estado
+// intermedio del digest tras 'offset' bytes y un MD5 de la ventana final de
+// ese prefijo para comprobar que no ha cambiado.
+struct ResumePoint {
+    uint64_t offset = 0;
+    std::string tail;  // MD5 hex de [offset - ventana, offset)
+    std::string state; // save_state() del algoritmo
+};
+
+bool resume_point_lookup(int fd, const fs::path& file, const struct stat& st, HashAlgo algo, ResumePoint& rp);
+void resume_point_store(int fd, const fs::path& file, const struct stat& st, HashAlgo algo, const ResumePoint& rp);
+#endif
+
+// Escribe la caché central si hubo cambios (al final de hash_files/hash_file)
+void digest_cache_flush();
@@ -0,0 +1,389 @@
+// src/dup_report.cpp
+
+#include "dup_report.h"
+#include "hash_engine.h"
+#include "manifest.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <string_view>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+static constexpr int kFanout = 256;      // particiones por nivel: un byte del digest
+static constexpr size_t kMaxDigest = 32; // SHA-256
+
+// Registro en una partición: [largo del digest u8][digest][repo u32][largo
+// de la ruta u32][ruta], enteros en little-endian
+namespace {
+
+struct Record {
+    const uint8_t* digest = nullptr;
+    uint8_t dlen = 0;
+    uint32_t repo = 0;
+    std::string_view path;
+};
+
+bool record_less(const Record& a, const Record& b) {
+    if (a.dlen != b.dlen) return a.dlen < b.dlen;
+    return std::memcmp(a.digest, b.digest, a.dlen) < 0;
+}
+
+bool same_digest(const Record& a, const Record& b) {
+    return a.dlen == b.dlen && std::memcmp(a.digest, b.digest, a.dlen) == 0;
+}
+
+void put_u32(std::ostream& os, uint32_t v) {
+    char b[4] = { (char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24) };
+    os.write(b, 4);
+}
+
+uint32_t get_u32(const char* p) {
+    const auto* u = reinterpret_cast<const uint8_t*>(p);
+    return (uint32_t)u[0] | (uint32_t)u[1] << 8 | (uint32_t)u[2] << 16 | (uint32_t)u[3] << 24;
+}
+
+void put_record(std::ostream& os, const Record& r) {
+    os.put((char)r.dlen);
+    os.write(reinterpret_cast<const char*>(r.digest), r.dlen);
+    put_u32(os, r.repo);
+    put_u32(os, (uint32_t)r.path.size());
+    os.write(r.path.data(), (std::streamsize)r.path.size());
+}
+
+bool next_record(const char*& p, const char* end, Record& r) {
+    if (end - p < 1) return false;
+    r.dlen = (uint8_t)*p;
+    if (r.dlen == 0 || r.dlen > kMaxDigest || (size_t)(end - p) < 1u + r.dlen + 8) return false;
+    r.digest = reinterpret_cast<const uint8_t*>(p + 1);
+    r.repo = get_u32(p + 1 + r.dlen);
+    uint32_t plen = get_u32(p + 5 + r.dlen);
+    if ((size_t)(end - p) < 9u + r.dlen + plen) return false;
+    r.path = std::string_view(p + 9 + r.dlen, plen);
+    p += 9 + r.dlen + plen;
+    return true;
+}
+
+// 256 archivos "<base>.<i>", abiertos según hacen falta
+class Partitions {
+public:
+    explicit Partitions(fs::path base) : base_(std::move(base)) {}
+
+    fs::path path(int i) const { return base_.string() + "." + std::to_string(i); }
+
+    bool write(int i, const Record& r) {
+        if (!out_[i]) out_[i] = std::make_unique<std::ofstream>(path(i), std::ios::binary | std::ios::trunc);
+        put_record(*out_[i], r);
+        return (bool)*out_[i];
+    }
+
+    bool close() {
+        bool ok = true;
+        for (auto& o : out_)
+            if (o) {
+                o->close();
+                ok = ok && !o->fail();
+                o.reset();
+            }
+        return ok;
+    }
+
+private:
+    fs::path base_;
+    std::unique_ptr<std::ofstream> out_[kFanout];
+};
+
+struct TopGroup {
+    uint64_t wasted;
+    std::string digest;
+    uint64_t size;
+    uint64_t copies;
+    bool operator>(const TopGroup& o) const { return wasted > o.wasted; }
+};
+
+class Joiner {
+public:
+    Joiner(const std::vector<fs::path>& repos, std::ofstream& report, const DupOptions& opts, DupStats& stats)
+        : repos_(repos), report_(report), opts_(opts), stats_(stats) {}
+
+    // 'max_dlen': el digest más largo en 'part'; a partir de ahí partir por
+    // un byte más ya no separa nada
+    bool process(const fs::path& part, size_t depth, std::string& out_log, size_t max_dlen = kMaxDigest);
+
+    std::vector<TopGroup> top() {
+        std::vector<TopGroup> v;
+        for (; !top_.empty(); top_.pop()) v.push_back(top_.top());
+        std::reverse(v.begin(), v.end());
+        return v;
+    }
+
+private:
+    bool split(const fs::path& part, size_t depth, std::string& out_log);
+    bool process_single_digest(const fs::path& part, std::string& out_log);
+    void emit(const Record* first, const Record* last);
+    template <class ForEach>
+    void emit_group(const Record& head, uint64_t copies, ForEach for_each_member);
+
+    const std::vector<fs::path>& repos_;
+    std::ofstream& report_;
+    const DupOptions& opts_;
+    DupStats& stats_;
+    std::priority_queue<TopGroup, std::vector<TopGroup>, std::greater<TopGroup>> top_;
+};
+
+} // namespace
+
+static std::string hex_of(const uint8_t* d, size_t n) {
+    static const char* digits = "0123456789abcdef";
+    std::string s(n * 2, '0');
+    for (size_t i = 0; i < n; ++i) {
+        s[2 * i] = digits[d[i] >> 4];
+        s[2 * i + 1] = digits[d[i] & 15];
+    }
+    return s;
+}
+
+static bool parse_digest(const std::string& hex, uint8_t* out, uint8_t& len) {
+    if (hex.size() % 2 || hex.empty() || hex.size() > kMaxDigest * 2) return false;
+    auto nib = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i < hex.size(); i += 2) {
+        int hi = nib(hex[i]), lo = nib(hex[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i / 2] = (uint8_t)(hi << 4 | lo);
+    }
+    len = (uint8_t)(hex.size() / 2);
+    return true;
+}
+
+// Mismo digest, mismo tamaño: basta con el primer miembro que siga en disco
+template <class ForEach>
+void Joiner::emit_group(const Record& head, uint64_t copies, ForEach for_each_member) {
+    uint64_t size = 0;
+    bool known = false;
+    for_each_member([&](const Record& r) {
+        if (known) return;
+        std::error_code ec;
+        uint64_t s = fs::file_size(repos_[r.repo] / std::string(r.path), ec);
+        if (!ec) {
+            size = s;
+            known = true;
+        }
+    });
+    if (size == 0) return;
+    std::string digest = hex_of(head.digest, head.dlen);
+    uint64_t wasted = size * (copies - 1);
+    stats_.groups += 1;
+    stats_.duplicates += copies - 1;
+    stats_.wasted_bytes += wasted;
+    report_ << "# " << digest << "  " << size << " bytes x " << copies << " = " << wasted << "\n";
+    for_each_member([&](const Record& r) { report_ << (repos_[r.repo] / std::string(r.path)).string() << "\n"; });
+    report_ << "\n";
+    if (opts_.top == 0) return;
+    top_.push(TopGroup{ wasted, digest, size, copies });
+    if (top_.size() > opts_.top) top_.pop();
+}
+
+void Joiner::emit(const Record* first, const Record* last) {
+    emit_group(*first, (uint64_t)(last - first), [&](auto&& fn) {
+        for (const Record* r = first; r != last; ++r) fn(*r);
+    });
+}
+
+// Reparte 'part' por el byte 'depth' del digest
+bool Joiner::split(const fs::path& part, size_t depth, std::string& out_log) {
+    Partitions sub(part);
+    size_t max_dlen = 0;
+    {
+        std::ifstream ifs(part, std::ios::binary);
+        std::string chunk;
+        char head[1 + kMaxDigest + 8];
+        while (ifs.read(head, 1)) {
+            uint8_t dlen = (uint8_t)head[0];
+            if (dlen == 0 || dlen > kMaxDigest || !ifs.read(head + 1, dlen + 8)) break;
+            max_dlen = std::max(max_dlen, (size_t)dlen);
+            uint32_t plen = get_u32(head + 5 + dlen);
+            chunk.resize(plen);
+            if (!ifs.read(&chunk[0], plen)) break;
+            Record r;
+            r.dlen = dlen;
+            r.digest = reinterpret_cast<const uint8_t*>(head + 1);
+            r.repo = get_u32(head + 1 + dlen);
+            r.path = chunk;
+            if (!sub.write(depth < dlen ? r.digest[depth] : 0, r)) {
+                out_log += "Duplicados: error escribiendo en " + part.parent_path().string() + "\n";
+                return false;
+            }
+        }
+    }
+    if (!sub.close()) {
+        out_log += "Duplicados: error escribiendo en " + part.parent_path().string() + "\n";
+        return false;
+    }
+    std::error_code ec;
+    fs::remove(part, ec);
+    for (int i = 0; i < kFanout; ++i)
+        if (!process(sub.path(i), depth + 1, out_log, max_dlen)) return false;
+    return true;
+}
+
+// Una partición que sigue sin caber tras partir por todo el digest es un solo
+// grupo enorme (millones de copias del mismo archivo): se recorre sin cargarla
+bool Joiner::process_single_digest(const fs::path& part, std::string& out_log) {
+    auto for_each = [&](auto&& fn) {
+        std::ifstream ifs(part, std::ios::binary);
+        std::string buf;
+        char head[1 + kMaxDigest + 8];
+        while (ifs.read(head, 1)) {
+            uint8_t dlen = (uint8_t)head[0];
+            if (dlen == 0 || dlen > kMaxDigest || !ifs.read(head + 1, dlen + 8)) break;
+            buf.resize(get_u32(head + 5 + dlen));
+            if (!ifs.read(&buf[0], (std::streamsize)buf.size())) break;
+            Record r;
+            r.dlen = dlen;
+            r.digest = reinterpret_cast<const uint8_t*>(head + 1);
+            r.repo = get_u32(head + 1 + dlen);
+            r.path = buf;
+            fn(r);
+        }
+    };
+    uint64_t copies = 0;
+    Record head;
+    uint8_t digest[kMaxDigest];
+    for_each([&](const Record& r) {
+        if (copies++ == 0) {
+            std::memcpy(digest, r.digest, r.dlen);
+            head.dlen = r.dlen;
+        }
+    });
+    head.digest = digest;
+    if (copies > 1) emit_group(head, copies, for_each);
+    std::error_code ec;
+    fs::remove(part, ec);
+    (void)out_log;
+    return true;
+}
+
+bool Joiner::process(const fs::path& part, size_t depth, std::string& out_log, size_t max_dlen) {
+    std::error_code ec;
+    uint64_t size = fs::file_size(part, ec);
+    if (ec) return true; // partición vacía: nunca se creó
+    // Cargada ocupa su tamaño más un Record por entrada (del mismo orden)
+    if (size * 2 > opts_.memory_budget) {
+        // Un MD5 (16 bytes) queda entero en 16 niveles: más sería reescribir
+        // la misma partición sin separar nada
+        if (depth < max_dlen) return split(part, depth, out_log);
+        return process_single_digest(part, out_log);
+    }
+    std::string buf((size_t)size, '\0');
+    {
+        std::ifstream ifs(part, std::ios::binary);
+        if (!ifs.read(&buf[0], (std::streamsize)size)) {
+            out_log += "Duplicados: no se puede leer " + part.string() + "\n";
+            return false;
+        }
+    }
+    fs::remove(part, ec);
+    std::vector<Record> recs;
+    const char* p = buf.data();
+    const char* end = p + buf.size();
+    Record r;
+    while (next_record(p, end, r)) recs.push_back(r);
+    std::sort(recs.begin(), recs.end(), record_less);
+    for (size_t i = 0; i < recs.size();) {
+        size_t j = i + 1;
+        while (j < recs.size() && same_digest(recs[i], recs[j])) ++j;
+        if (j - i > 1) emit(recs.data() + i, recs.data() + j);
+        i = j;
+    }
+    return true;
+}
+
+bool duplicate_report(const std::vector<fs::path>& repos, const fs::path& report, const DupOptions& opts,
+                      DupStats& stats, std::string& out_log) {
+    stats = DupStats{};
+    std::error_code ec;
+    fs::path tmp = opts.temp_dir.empty() ? fs::temp_directory_path(ec) : opts.temp_dir;
+#ifndef _WIN32
+    tmp /= "hashnsign-dup-" + std::to_string((long)getpid());
+#else
+    tmp /= "hashnsign-dup";
+#endif
+    fs::remove_all(tmp, ec);
+    fs::create_directories(tmp, ec);
+    if (ec) {
+        out_log += "Duplicados: no se puede crear " + tmp.string() + ": " + ec.message() + "\n";
+        return false;
+    }
+    struct Cleanup {
+        fs::path dir;
+        ~Cleanup() {
+            std::error_code e;
+            fs::remove_all(dir, e);
+        }
+    } cleanup{ tmp };
+
+    // Fase 1: todas las entradas a 256 particiones por el primer byte
+    Partitions parts(tmp / "p");
+    bool write_ok = true;
+    for (size_t i = 0; i < repos.size() && write_ok; ++i) {
+        fs::path manifest = repos[i] / "hashes.md5";
+        if (fs::exists(repos[i] / "hashes.tree") || !fs::exists(manifest)) {
+            out_log += "Duplicados: " + repos[i].string() + " no tiene hashes.md5, se salta\n";
+            continue;
+        }
+        bool read_ok = for_each_manifest_entry(manifest, [&](ManifestEntry&& e) {
+            std::string rel = e.path.rfind("./", 0) == 0 ? e.path.substr(2) : e.path;
+            uint8_t d[kMaxDigest];
+            Record r;
+            if (!write_ok || is_manifest_artifact(rel) || !parse_digest(e.digest, d, r.dlen)) return;
+            r.digest = d;
+            r.repo = (uint32_t)i;
+            r.path = rel;
+            write_ok = parts.write(d[0], r);
+            ++stats.entries;
+        }, out_log);
+        // Sus entradas ya están a medias en las particiones: el informe sería
+        // incompleto sin que nada lo dijera
+        if (!read_ok) {
+            out_log += "Duplicados: no se puede leer " + manifest.string() + " entero, no se genera el informe\n";
+            return false;
+        }
+    }
+    if (!parts.close() || !write_ok) {
+        out_log += "Duplicados: error escribiendo en " + tmp.string() + "\n";
+        return false;
+    }
+
+    // Fase 2: cada partición, ordenada, da sus grupos
+    std::ofstream ofs(report, std::ios::trunc);
+    if (!ofs.is_open()) {
+        out_log += "Error: no se puede crear " + report.string() + "\n";
+        return false;
+    }
+    Joiner join(repos, ofs, opts, stats);
+    for (int i = 0; i < kFanout; ++i)
+        if (!join.process(parts.path(i), 1, out_log)) return false;
+    ofs.close();
+    if (ofs.fail()) {
+        out_log += "Error: no se puede escribir " + report.string() + "\n";
+        return false;
+    }
+
+    out_log += "Duplicados: " + std::to_string(stats.entries) + " entradas, " + std::to_string(stats.groups) +
+               " grupos, " + std::to_string(stats.duplicates) + " copias de sobra, " +
+               format_bytes(stats.wasted_bytes) + " desperdiciados (" + report.string() + ")\n";
+    for (const TopGroup& g : join.top())
+        out_log += "  " + format_bytes(g.wasted) + "  " + std::to_string(g.copies) + " x " + format_bytes(g.size) +
+                   "  " + g.digest + "\n";
+    return true;
+}
@@ -0,0 +1,42 @@
+// src/dup_report.h
+// Informe de contenido duplicado en toda la flota a partir de los hashes.md5
+// ya generados: archivos con el mismo digest en cualquier repo, agrupados,
+// con los bytes que sobran en cada grupo (tamaño × (copias - 1)).
+//
+// Es un hash join en memoria externa: las entradas de todos los manifiestos
+// se reparten en 256 particiones en disco por el primer byte del digest (los
+// digests ya son uniformes); cada partición se ordena en memoria y se recorre
+// por grupos. Una partición que no cabe en el presupuesto se vuelve a partir
+// por el byte siguiente. La memoria no depende del número de entradas.
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct DupOptions {
+    uint64_t memory_budget = 256ull << 20; // bytes de una partición cargada
+    fs::path temp_dir;                     // vacío = temp_directory_path()
+    size_t top = 20;                       // grupos que se resumen en el log
+};
+
+struct DupStats {
+    uint64_t entries = 0;      // entradas leídas de los manifiestos
+    uint64_t groups = 0;       // digests con más de una copia
+    uint64_t duplicates = 0;   // copias de sobra (suma de copias - 1)
+    uint64_t wasted_bytes = 0;
+};
+
+// Escribe en 'report' un bloque por grupo (en orden de digest):
+//   # <digest>  <tamaño> bytes x <copias> = <bytes de sobra>
+//   <repo>/<ruta>
+//   ...
+// y en out_log el resumen con los 'top' grupos que más desperdician. Los
+// repos en modo árbol (sin hashes.md5) se saltan; los archivos vacíos no
+// cuentan.
+bool duplicate_report(const std::vector<fs::path>& repos, const fs::path& report, const DupOptions& opts,
+                      DupStats& stats, std::string& out_log);
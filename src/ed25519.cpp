@@ -0,0 +1,671 @@
+// src/ed25519.cpp
+
+#include "ed25519.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <random>
+
+namespace {
+
+// ------------------------------------------------------ SHA-512 (FIPS 180-4)
+// Solo para Ed25519: el bloque de 128 bytes y la longitud de 128 bits no
+// encajan en hash_detail::BlockHash, y aquí los mensajes son cortos.
+
+constexpr uint64_t kSha512K[80] = {
+    0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f, 0xe9b5dba58189dbbc, 0x3956c25bf348b538,
+    0x59f111f1b605d019, 0x923f82a4af194f9b, 0xab1c5ed5da6d8118, 0xd807aa98a3030242, 0x12835b0145706fbe,
+    0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2, 0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235,
+    0xc19bf174cf692694, 0xe49b69c19ef14ad2, 0xefbe4786384f25e3, 0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65,
+    0x2de92c6f592b0275, 0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5, 0x983e5152ee66dfab,
+    0xa831c66d2db43210, 0xb00327c898fb213f, 0xbf597fc7beef0ee4, 0xc6e00bf33da88fc2, 0xd5a79147930aa725,
+    0x06ca6351e003826f, 0x142929670a0e6e70, 0x27b70a8546d22ffc, 0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed,
+    0x53380d139d95b3df, 0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6, 0x92722c851482353b,
+    0xa2bfe8a14cf10364, 0xa81a664bbc423001, 0xc24b8b70d0f89791, 0xc76c51a30654be30, 0xd192e819d6ef5218,
+    0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8, 0x19a4c116b8d2d0c8, 0x1e376c085141ab53,
+    0x2748774cdf8eeb99, 0x34b0bcb5e19b48a8, 0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb, 0x5b9cca4f7763e373,
+    0x682e6ff3d6b2b8a3, 0x748f82ee5defb2fc, 0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
+    0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915, 0xc67178f2e372532b, 0xca273eceea26619c,
+    0xd186b8c721c0c207, 0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178, 0x06f067aa72176fba, 0x0a637dc5a2c898a6,
+    0x113f9804bef90dae, 0x1b710b35131c471b, 0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc,
+    0x431d67c49c100d4c, 0x4cc5d4becb3e42b6, 0x597f299cfc657e2a, 0x5fcb6fab3ad6faec, 0x6c44198c4a475817,
+};
+
+class Sha512 {
+public:
+    void update(const uint8_t* p, size_t len) {
+        size_t have = (size_t)(length_ % 128);
+        length_ += len;
+        while (len > 0) {
+            size_t take = std::min(len, 128 - have);
+            std::memcpy(buffer_ + have, p, take);
+            have += take;
+            p += take;
+            len -= take;
+            if (have == 128) {
+                compress(buffer_);
+                have = 0;
+            }
+        }
+    }
+
+    std::array<uint8_t, 64> final() {
+        uint64_t bit_len = length_ * 8;
+        uint8_t pad[128 + 16] = { 0x80 };
+        size_t have = (size_t)(length_ % 128);
+        size_t pad_len = have < 112 ? 112 - have : 240 - have;
+        update(pad, pad_len);
+        uint8_t len_bytes[16] = {};
+        for (int i = 0; i < 8; ++i) len_bytes[15 - i] = (uint8_t)(bit_len >> (8 * i));
+        update(len_bytes, 16);
+        std::array<uint8_t, 64> out{};
+        for (int i = 0; i < 8; ++i)
+            for (int j = 0; j < 8; ++j) out[i * 8 + j] = (uint8_t)(state_[i] >> (56 - 8 * j));
+        return out;
+    }
+
+private:
+    static uint64_t rotr(uint64_t x, int c) { return (x >> c) | (x << (64 - c)); }
+
+    void compress(const uint8_t* block) {
+        uint64_t W[80];
+        for (int i = 0; i < 16; ++i) {
+            W[i] = 0;
+            for (int j = 0; j < 8; ++j) W[i] = (W[i] << 8) | block[i * 8 + j];
+        }
+        for (int i = 16; i < 80; ++i) {
+            uint64_t s0 = rotr(W[i - 15], 1) ^ rotr(W[i - 15], 8) ^ (W[i - 15] >> 7);
+            uint64_t s1 = rotr(W[i - 2], 19) ^ rotr(W[i - 2], 61) ^ (W[i - 2] >> 6);
+            W[i] = W[i - 16] + s0 + W[i - 7] + s1;
+        }
+        uint64_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+        uint64_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+        for (int i = 0; i < 80; ++i) {
+            uint64_t S1 = rotr(e, 14) ^ rotr(e, 18) ^ rotr(e, 41);
+            uint64_t ch = (e & f) ^ (~e & g);
+            uint64_t t1 = h + S1 + ch + kSha512K[i] + W[i];
+            uint64_t S0 = rotr(a, 28) ^ rotr(a, 34) ^ rotr(a, 39);
+            uint64_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint64_t t2 = S0 + maj;
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state_[0] += a; state_[1] += b; state_[2] += c; state_[3] += d;
+        state_[4] += e; state_[5] += f; state_[6] += g; state_[7] += h;
+    }
+
+    uint64_t state_[8] = { 0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
+                           0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179 };
+    uint64_t length_ = 0;
+    uint8_t buffer_[128] = {};
+};
+
+// ------------------------------------------------- campo GF(2^255 - 19)
+// h = sum h[i] * 2^ceil(25.5 i); limbs pares de 26 bits y impares de 25. Tras
+// fe_carry cada limb cabe en ~2^25 con signo, así que en fe_mul cada producto
+// (por 2 y por 19 en el peor caso) y la suma de 10 caben de sobra en 63 bits.
+
+using Fe = std::array<int64_t, 10>;
+
+constexpr int kLimbBits[10] = { 26, 25, 26, 25, 26, 25, 26, 25, 26, 25 };
+
+// Una vuelta completa más el arrastre de h[9] a h[0] y de h[0] a h[1]: deja
+// cada limb en [-2^(b-1), 2^(b-1)] salvo h[1], que puede pasarse en ~2^14.
+void fe_carry(Fe& h) {
+    auto step = [&h](int i) {
+        int b = kLimbBits[i];
+        int64_t c = (h[i] + ((int64_t)1 << (b - 1))) >> b;
+        h[i] -= c * ((int64_t)1 << b);
+        if (i == 9) h[0] += c * 19;
+        else h[i + 1] += c;
+    };
+    for (int i = 0; i < 10; ++i) step(i);
+    step(0);
+}
+
+Fe fe_int(int64_t v) {
+    Fe h{};
+    h[0] = v;
+    return h;
+}
+
+Fe fe_add(const Fe& f, const Fe& g) {
+    Fe h;
+    for (int i = 0; i < 10; ++i) h[i] = f[i] + g[i];
+    fe_carry(h);
+    return h;
+}
+
+Fe fe_sub(const Fe& f, const Fe& g) {
+    Fe h;
+    for (int i = 0; i < 10; ++i) h[i] = f[i] - g[i];
+    fe_carry(h);
+    return h;
+}
+
+Fe fe_neg(const Fe& f) { return fe_sub(Fe{}, f); }
+
+Fe fe_mul(const Fe& f, const Fe& g) {
+    // 2^w_i * 2^w_j = 2^w_(i+j) salvo con i, j impares (un bit más), y
+    // 2^255 = 19 al dar la vuelta. Los factores 2 y 19 se aplican antes del
+    // bucle para que quede sin ramas y el compilador lo desenrolle.
+    int64_t f2[10], g19[10];
+    for (int i = 0; i < 10; ++i) {
+        f2[i] = (i & 1) ? 2 * f[i] : f[i];
+        g19[i] = 19 * g[i];
+    }
+    Fe h{};
+    for (int i = 0; i < 10; ++i) {
+        const int64_t fi = f[i], fi2 = f2[i];
+        for (int j = 0; j < 10 - i; ++j) h[i + j] += ((i & j & 1) ? fi2 : fi) * g[j];
+        for (int j = 10 - i; j < 10; ++j) h[i + j - 10] += ((i & j & 1) ? fi2 : fi) * g19[j];
+    }
+    fe_carry(h);
+    return h;
+}
+
+// Como fe_mul(f, f), sumando cada par i < j una sola vez (por 2)
+Fe fe_sq(const Fe& f) {
+    Fe h{};
+    for (int i = 0; i < 10; ++i) {
+        for (int j = i; j < 10; ++j) {
+            int64_t p = f[i] * (i == j ? f[j] : 2 * f[j]);
+            if (i & j & 1) p *= 2;
+            if (i + j >= 10) h[i + j - 10] += 19 * p;
+            else h[i + j] += p;
+        }
+    }
+    fe_carry(h);
+    return h;
+}
+
+Fe fe_sq_n(Fe f, int n) {
+    for (int i = 0; i < n; ++i) f = fe_sq(f);
+    return f;
+}
+
+// z^(2^250 - 1) y z^11, comunes a la inversión y a la raíz cuadrada
+void fe_pow_2_250_1(const Fe& z, Fe& z_250_1, Fe& z11) {
+    Fe z2 = fe_sq(z);
+    Fe z9 = fe_mul(fe_sq_n(z2, 2), z);
+    z11 = fe_mul(z9, z2);
+    Fe z_5_0 = fe_mul(fe_sq(z11), z9);
+    Fe z_10_0 = fe_mul(fe_sq_n(z_5_0, 5), z_5_0);
+    Fe z_20_0 = fe_mul(fe_sq_n(z_10_0, 10), z_10_0);
+    Fe z_40_0 = fe_mul(fe_sq_n(z_20_0, 20), z_20_0);
+    Fe z_50_0 = fe_mul(fe_sq_n(z_40_0, 10), z_10_0);
+    Fe z_100_0 = fe_mul(fe_sq_n(z_50_0, 50), z_50_0);
+    Fe z_200_0 = fe_mul(fe_sq_n(z_100_0, 100), z_100_0);
+    z_250_1 = fe_mul(fe_sq_n(z_200_0, 50), z_50_0);
+}
+
+// z^(p - 2)
+Fe fe_invert(const Fe& z) {
+    Fe t, z11;
+    fe_pow_2_250_1(z, t, z11);
+    return fe_mul(fe_sq_n(t, 5), z11);
+}
+
+// z^((p - 5) / 8)
+Fe fe_pow22523(const Fe& z) {
+    Fe t, z11;
+    fe_pow_2_250_1(z, t, z11);
+    return fe_mul(fe_sq_n(t, 2), z);
+}
+
+// Representación canónica (0 <= h < p), 255 bits little-endian
+void fe_tobytes(uint8_t s[32], Fe h) {
+    fe_carry(h);
+    fe_carry(h);
+    // q = 1 si h >= p (h + 19 llega a 2^255), 0 si no
+    int64_t q = (19 * h[9] + ((int64_t)1 << 24)) >> 25;
+    for (int i = 0; i < 10; ++i) q = (h[i] + q) >> kLimbBits[i];
+    h[0] += 19 * q;
+    for (int i = 0; i < 9; ++i) {
+        int64_t c = h[i] >> kLimbBits[i];
+        h[i + 1] += c;
+        h[i] -= c * ((int64_t)1 << kLimbBits[i]);
+    }
+    h[9] -= (h[9] >> 25) * ((int64_t)1 << 25);
+
+    uint64_t acc = 0;
+    int acc_bits = 0, n = 0;
+    for (int i = 0; i < 10; ++i) {
+        acc |= (uint64_t)h[i] << acc_bits;
+        acc_bits += kLimbBits[i];
+        while (acc_bits >= 8) {
+            s[n++] = (uint8_t)acc;
+            acc >>= 8;
+            acc_bits -= 8;
+        }
+    }
+    s[n] = (uint8_t)acc; // 255 bits: el último byte lleva 7
+}
+
+// Ignora el bit 255 (el signo de x en un punto codificado)
+Fe fe_frombytes(const uint8_t s[32]) {
+    Fe h{};
+    uint64_t acc = 0;
+    int acc_bits = 0, n = 0;
+    for (int i = 0; i < 10; ++i) {
+        int b = kLimbBits[i];
+        while (acc_bits < b) {
+            acc |= (uint64_t)(n == 31 ? s[n] & 0x7f : s[n]) << acc_bits;
+            ++n;
+            acc_bits += 8;
+        }
+        h[i] = (int64_t)(acc & (((uint64_t)1 << b) - 1));
+        acc >>= b;
+        acc_bits -= b;
+    }
+    return h;
+}
+
+bool fe_equal(const Fe& f, const Fe& g) {
+    uint8_t a[32], b[32];
+    fe_tobytes(a, f);
+    fe_tobytes(b, g);
+    return std::memcmp(a, b, 32) == 0;
+}
+
+bool fe_is_negative(const Fe& f) {
+    uint8_t s[32];
+    fe_tobytes(s, f);
+    return s[0] & 1;
+}
+
+// f = g si flag (0 o 1), sin ramas
+void fe_cmov(Fe& f, const Fe& g, int64_t flag) {
+    int64_t mask = -flag;
+    for (int i = 0; i < 10; ++i) f[i] ^= (f[i] ^ g[i]) & mask;
+}
+
+// ------------------------------------------- curva -x^2 + y^2 = 1 + d x^2 y^2
+
+struct Ge {
+    Fe X, Y, Z, T; // x = X/Z, y = Y/Z, x y = T/Z
+};
+
+struct Constants {
+    Fe d, d2, sqrtm1;
+    Ge base;
+};
+
+const Constants& constants();
+
+Ge ge_identity() { return Ge{ Fe{}, fe_int(1), fe_int(1), Fe{} }; }
+
+// add-2008-hwcd-3 (a = -1)
+Ge ge_add(const Ge& p, const Ge& q) {
+    const Fe& d2 = constants().d2;
+    Fe a = fe_mul(fe_sub(p.Y, p.X), fe_sub(q.Y, q.X));
+    Fe b = fe_mul(fe_add(p.Y, p.X), fe_add(q.Y, q.X));
+    Fe c = fe_mul(fe_mul(p.T, d2), q.T);
+    Fe d = fe_mul(fe_add(p.Z, p.Z), q.Z);
+    Fe e = fe_sub(b, a), f = fe_sub(d, c), g = fe_add(d, c), h = fe_add(b, a);
+    return Ge{ fe_mul(e, f), fe_mul(g, h), fe_mul(f, g), fe_mul(e, h) };
+}
+
+// dbl-2008-hwcd (a = -1)
+Ge ge_dbl(const Ge& p) {
+    Fe a = fe_sq(p.X);
+    Fe b = fe_sq(p.Y);
+    Fe c = fe_sq(p.Z);
+    c = fe_add(c, c);
+    Fe h = fe_add(a, b);
+    Fe e = fe_sub(h, fe_sq(fe_add(p.X, p.Y)));
+    Fe g = fe_sub(a, b);
+    Fe f = fe_add(c, g);
+    return Ge{ fe_mul(e, f), fe_mul(g, h), fe_mul(f, g), fe_mul(e, h) };
+}
+
+Ge ge_neg(const Ge& p) { return Ge{ fe_neg(p.X), p.Y, p.Z, fe_neg(p.T) }; }
+
+void ge_tobytes(uint8_t s[32], const Ge& p) {
+    Fe zi = fe_invert(p.Z);
+    Fe x = fe_mul(p.X, zi), y = fe_mul(p.Y, zi);
+    fe_tobytes(s, y);
+    s[31] |= (uint8_t)(fe_is_negative(x) << 7);
+}
+
+// RFC 8032 §5.1.3; rechaza y >= p y x = 0 con bit de signo. Recibe d y
+// sqrt(-1) porque también sirve para construir la base en constants().
+bool ge_decode(Ge& p, const uint8_t s[32], const Fe& d, const Fe& sqrtm1) {
+    Fe y = fe_frombytes(s);
+    uint8_t canon[32];
+    fe_tobytes(canon, y);
+    canon[31] |= s[31] & 0x80;
+    if (std::memcmp(canon, s, 32) != 0) return false;
+
+    Fe y2 = fe_sq(y);
+    Fe u = fe_sub(y2, fe_int(1));
+    Fe v = fe_add(fe_mul(y2, d), fe_int(1));
+    Fe v3 = fe_mul(fe_sq(v), v);
+    Fe x = fe_mul(fe_mul(u, v3), fe_pow22523(fe_mul(u, fe_mul(fe_sq(v3), v))));
+    Fe vx2 = fe_mul(v, fe_sq(x));
+    if (!fe_equal(vx2, u)) {
+        if (!fe_equal(vx2, fe_neg(u))) return false;
+        x = fe_mul(x, sqrtm1);
+    }
+    bool sign = s[31] >> 7;
+    if (sign && fe_equal(x, Fe{})) return false;
+    if (fe_is_negative(x) != sign) x = fe_neg(x);
+    p = Ge{ x, y, fe_int(1), fe_mul(x, y) };
+    return true;
+}
+
+bool ge_frombytes(Ge& p, const uint8_t s[32]) {
+    const Constants& k = constants();
+    return ge_decode(p, s, k.d, k.sqrtm1);
+}
+
+bool ge_is_identity(const Ge& p) {
+    return fe_equal(p.X, Fe{}) && fe_equal(p.Y, p.Z);
+}
+
+const Constants& constants() {
+    static const Constants k = [] {
+        Constants c;
+        c.d = fe_mul(fe_int(-121665), fe_invert(fe_int(121666)));
+        c.d2 = fe_add(c.d, c.d);
+        // sqrt(-1) = 2^((p - 1) / 4) = (2^((p - 5) / 8))^2 * 2
+        c.sqrtm1 = fe_mul(fe_sq(fe_pow22523(fe_int(2))), fe_int(2));
+        // B: y = 4/5 y x positiva
+        uint8_t b[32];
+        std::memset(b, 0x66, 32);
+        b[0] = 0x58;
+        ge_decode(c.base, b, c.d, c.sqrtm1);
+        return c;
+    }();
+    return k;
+}
+
+// ------------------------------------------------------------ [s]B fijo
+// kBaseTable[i][j] = j * 16^i * B: [s]B son 64 sumas, sin duplicaciones
+
+using BaseTable = std::array<std::array<Ge, 16>, 64>;
+
+const BaseTable& base_table() {
+    static const BaseTable* table = [] {
+        auto* t = new BaseTable;
+        Ge p = constants().base;
+        for (int i = 0; i < 64; ++i) {
+            (*t)[i][0] = ge_identity();
+            for (int j = 1; j < 16; ++j) (*t)[i][j] = ge_add((*t)[i][j - 1], p);
+            p = ge_add((*t)[i][15], p);
+        }
+        return t;
+    }();
+    return *table;
+}
+
+// s < 2^256 en little-endian. Recorre las 16 entradas de cada fila para que el
+// acceso a memoria no dependa del escalar (que al firmar es secreto).
+Ge ge_scalarmult_base(const uint8_t s[32]) {
+    const BaseTable& t = base_table();
+    Ge r = ge_identity();
+    for (int i = 0; i < 64; ++i) {
+        int nib = (s[i / 2] >> (4 * (i & 1))) & 15;
+        Ge sel = ge_identity();
+        for (int j = 1; j < 16; ++j) {
+            int64_t eq = (int64_t)(((unsigned)(nib ^ j) - 1) >> 31); // 1 si nib == j
+            fe_cmov(sel.X, t[i][j].X, eq);
+            fe_cmov(sel.Y, t[i][j].Y, eq);
+            fe_cmov(sel.Z, t[i][j].Z, eq);
+            fe_cmov(sel.T, t[i][j].T, eq);
+        }
+        r = ge_add(r, sel);
+    }
+    return r;
+}
+
+// sum [s_i] P_i (Straus, ventanas de 4 bits). Solo con datos públicos: el
+// tiempo depende de los escalares.
+Ge ge_multi_scalarmult(const std::vector<Ge>& points, const std::vector<std::array<uint8_t, 32>>& scalars) {
+    std::vector<std::array<Ge, 16>> tables(points.size());
+    for (size_t k = 0; k < points.size(); ++k) {
+        tables[k][0] = ge_identity();
+        for (int j = 1; j < 16; ++j) tables[k][j] = ge_add(tables[k][j - 1], points[k]);
+    }
+    Ge r = ge_identity();
+    for (int i = 63; i >= 0; --i) {
+        if (i != 63) r = ge_dbl(ge_dbl(ge_dbl(ge_dbl(r))));
+        for (size_t k = 0; k < points.size(); ++k) {
+            int nib = (scalars[k][i / 2] >> (4 * (i & 1))) & 15;
+            if (nib) r = ge_add(r, tables[k][nib]);
+        }
+    }
+    return r;
+}
+
+// ---------------------------------------------- escalares mod L = 2^252 + ...
+
+constexpr int64_t kL[32] = { 0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7,
+                             0xa2, 0xde, 0xf9, 0xde, 0x14, 0,    0,    0,    0,    0,    0,
+                             0,    0,    0,    0,    0,    0,    0,    0,    0,    0x10 };
+
+// x (64 limbs de 8 bits, con signo) mod L
+void sc_mod_l(uint8_t r[32], int64_t x[64]) {
+    for (int i = 63; i >= 32; --i) {
+        int64_t carry = 0;
+        int j;
+        for (j = i - 32; j < i - 12; ++j) {
+            x[j] += carry - 16 * x[i] * kL[j - (i - 32)];
+            carry = (x[j] + 128) >> 8;
+            x[j] -= carry * 256;
+        }
+        x[j] += carry;
+        x[i] = 0;
+    }
+    int64_t carry = 0;
+    for (int j = 0; j < 32; ++j) {
+        x[j] += carry - (x[31] >> 4) * kL[j];
+        carry = x[j] >> 8;
+        x[j] &= 255;
+    }
+    for (int j = 0; j < 32; ++j) x[j] -= carry * kL[j];
+    for (int i = 0; i < 32; ++i) {
+        x[i + 1] += x[i] >> 8;
+        r[i] = (uint8_t)(x[i] & 255);
+    }
+}
+
+void sc_reduce64(uint8_t r[32], const uint8_t s[64]) {
+    int64_t x[64];
+    for (int i = 0; i < 64; ++i) x[i] = s[i];
+    sc_mod_l(r, x);
+}
+
+// r = a * b + c mod L
+void sc_muladd(uint8_t r[32], const uint8_t a[32], const uint8_t b[32], const uint8_t c[32]) {
+    int64_t x[64] = {};
+    for (int i = 0; i < 32; ++i) x[i] = c[i];
+    for (int i = 0; i < 32; ++i)
+        for (int j = 0; j < 32; ++j) x[i + j] += (int64_t)a[i] * b[j];
+    sc_mod_l(r, x);
+}
+
+// s < L (RFC 8032 exige rechazar S no canónico)
+bool sc_is_canonical(const uint8_t s[32]) {
+    for (int i = 31; i >= 0; --i) {
+        if (s[i] < kL[i]) return true;
+        if (s[i] > kL[i]) return false;
+    }
+    return false; // s == L
+}
+
+void hash_to_scalar(uint8_t r[32], const uint8_t* a, size_t alen, const uint8_t* b, size_t blen, const uint8_t* m,
+                    size_t mlen) {
+    Sha512 h;
+    h.update(a, alen);
+    h.update(b, blen);
+    h.update(m, mlen);
+    auto d = h.final();
+    sc_reduce64(r, d.data());
+}
+
+} // namespace
+
+void ed25519_keypair(const uint8_t seed[32], Ed25519PublicKey& pk, Ed25519SecretKey& sk) {
+    Sha512 h;
+    h.update(seed, 32);
+    auto d = h.final();
+    d[0] &= 248;
+    d[31] &= 127;
+    d[31] |= 64;
+    ge_tobytes(pk.data(), ge_scalarmult_base(d.data()));
+    std::memcpy(sk.data(), seed, 32);
+    std::memcpy(sk.data() + 32, pk.data(), 32);
+}
+
+Ed25519Signature ed25519_sign(const Ed25519SecretKey& sk, const uint8_t* msg, size_t len) {
+    Sha512 h;
+    h.update(sk.data(), 32);
+    auto az = h.final();
+    az[0] &= 248;
+    az[31] &= 127;
+    az[31] |= 64;
+
+    Ed25519Signature sig{};
+    uint8_t r[32], k[32];
+    hash_to_scalar(r, az.data() + 32, 32, nullptr, 0, msg, len);
+    ge_tobytes(sig.data(), ge_scalarmult_base(r));
+    hash_to_scalar(k, sig.data(), 32, sk.data() + 32, 32, msg, len);
+    sc_muladd(sig.data() + 32, k, az.data(), r);
+    return sig;
+}
+
+bool ed25519_verify(const Ed25519PublicKey& pk, const uint8_t* msg, size_t len, const Ed25519Signature& sig) {
+    Ge a, r;
+    if (!sc_is_canonical(sig.data() + 32) || !ge_frombytes(a, pk.data()) || !ge_frombytes(r, sig.data()))
+        return false;
+    std::array<uint8_t, 32> k;
+    hash_to_scalar(k.data(), sig.data(), 32, pk.data(), 32, msg, len);
+    // [8]([S]B - [k]A - R) == 0
+    Ge p = ge_add(ge_scalarmult_base(sig.data() + 32), ge_multi_scalarmult({ ge_neg(a) }, { k }));
+    p = ge_add(p, ge_neg(r));
+    return ge_is_identity(ge_dbl(ge_dbl(ge_dbl(p))));
+}
+
+bool ed25519_verify_batch(const std::vector<Ed25519BatchItem>& items) {
+    if (items.empty()) return true;
+    if (items.size() == 1) return ed25519_verify(*items[0].pk, items[0].msg, items[0].len, *items[0].sig);
+
+    // sum z_i ([S_i]B - [k_i]A_i - R_i) = 0 con z_i aleatorios de 128 bits:
+    // una firma inválida solo pasa con probabilidad 2^-128
+    std::random_device rd;
+    std::vector<Ge> points;
+    std::vector<std::array<uint8_t, 32>> scalars;
+    std::map<Ed25519PublicKey, std::array<uint8_t, 32>> key_scalars; // sum z_i k_i por clave
+    uint8_t s_sum[32] = {};
+    for (const auto& it : items) {
+        const uint8_t* S = it.sig->data() + 32;
+        Ge r;
+        if (!sc_is_canonical(S) || !ge_frombytes(r, it.sig->data())) return false;
+        std::array<uint8_t, 32> z{};
+        for (int i = 0; i < 16; i += 4) {
+            uint32_t v = rd();
+            std::memcpy(z.data() + i, &v, 4);
+        }
+        uint8_t k[32];
+        hash_to_scalar(k, it.sig->data(), 32, it.pk->data(), 32, it.msg, it.len);
+        sc_muladd(s_sum, z.data(), S, s_sum);
+        auto ins = key_scalars.emplace(*it.pk, std::array<uint8_t, 32>{});
+        sc_muladd(ins.first->second.data(), z.data(), k, ins.first->second.data());
+        points.push_back(ge_neg(r));
+        scalars.push_back(z);
+    }
+    for (const auto& [pk, c] : key_scalars) {
+        Ge a;
+        if (!ge_frombytes(a, pk.data())) return false;
+        points.push_back(ge_neg(a));
+        scalars.push_back(c);
+    }
+    Ge p = ge_add(ge_scalarmult_base(s_sum), ge_multi_scalarmult(points, scalars));
+    return ge_is_identity(ge_dbl(ge_dbl(ge_dbl(p))));
+}
+
+namespace {
+
+std::vector<uint8_t> from_hex(const char* s) {
+    std::vector<uint8_t> out;
+    auto nib = [](char c) { return c <= '9' ? c - '0' : c - 'a' + 10; };
+    for (; s[0] && s[1]; s += 2) out.push_back((uint8_t)(nib(s[0]) << 4 | nib(s[1])));
+    return out;
+}
+
+} // namespace
+
+bool ed25519_selftest(std::string& out_log) {
+    bool ok = true;
+    auto check = [&](bool cond, const std::string& what) {
+        if (!cond) {
+            out_log += "Autoprueba Ed25519 FALLIDA: " + what + "\n";
+            ok = false;
+        }
+    };
+
+    // FIPS 180-2, apéndice C: un bloque y dos bloques
+    struct ShaVector {
+        const char* msg;
+        const char* digest;
+    } sha[] = {
+        { "abc", "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+                 "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f" },
+        { "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrst"
+          "nopqrstu",
+          "8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018"
+          "501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909" },
+    };
+    for (const auto& v : sha) {
+        Sha512 h;
+        h.update(reinterpret_cast<const uint8_t*>(v.msg), std::strlen(v.msg));
+        auto d = h.final();
+        check(std::vector<uint8_t>(d.begin(), d.end()) == from_hex(v.digest),
+              "SHA-512 de " + std::to_string(std::strlen(v.msg)) + " bytes");
+    }
+
+    // RFC 8032, 7.1: TEST 1, 2 y 3
+    struct Vector {
+        const char* seed;
+        const char* pk;
+        const char* msg;
+        const char* sig;
+    } rfc[] = {
+        { "9d61b19deffd5a60ba844af492ec2cc44449c5697b326919703bac031cae7f60",
+          "d75a980182b10ab7d54bfed3c964073a0ee172f3daa62325af021a68f707511a", "",
+          "e5564300c360ac729086e2cc806e828a84877f1eb8e5d974d873e065224901555fb8821590a33bacc61e39701cf9b46bd25bf5f0595bbe24655141438e7a100b" },
+        { "4ccd089b28ff96da9db6c346ec114e0f5b8a319f35aba624da8cf6ed4fb8a6fb",
+          "3d4017c3e843895a92b70aa74d1b7ebc9c982ccf2ec4968cc0cd55f12af4660c", "72",
+          "92a009a9f0d4cab8720e820b5f642540a2b27b5416503f8fb3762223ebdb69da085ac1e43e15996e458f3613d0f11d8c387b2eaeb4302aeeb00d291612bb0c00" },
+        { "c5aa8df43f9f837bedb7442f31dcb7b166d38535076f094b85ce3a2e0b4458f7",
+          "fc51cd8e6218a1a38da47ed00230f0580816ed13ba3303ac5deb911548908025", "af82",
+          "6291d657deec24024827e69c3abe01a30ce548a284743a445e3680d7db5ac3ac18ff9b538d16f290ae67f760984dc6594a7c15e9716ed28dc027beceea1ec40a" },
+    };
+    std::vector<Ed25519PublicKey> pks(3);
+    std::vector<Ed25519Signature> sigs(3);
+    std::vector<std::vector<uint8_t>> msgs(3);
+    std::vector<Ed25519BatchItem> batch;
+    for (int i = 0; i < 3; ++i) {
+        std::string name = "RFC 8032 TEST " + std::to_string(i + 1);
+        std::vector<uint8_t> seed = from_hex(rfc[i].seed);
+        Ed25519SecretKey sk;
+        ed25519_keypair(seed.data(), pks[i], sk);
+        msgs[i] = from_hex(rfc[i].msg);
+        sigs[i] = ed25519_sign(sk, msgs[i].data(), msgs[i].size());
+        check(std::vector<uint8_t>(pks[i].begin(), pks[i].end()) == from_hex(rfc[i].pk), name + ": clave pública");
+        check(std::vector<uint8_t>(sigs[i].begin(), sigs[i].end()) == from_hex(rfc[i].sig), name + ": firma");
+        check(ed25519_verify(pks[i], msgs[i].data(), msgs[i].size(), sigs[i]), name + ": verificación");
+        Ed25519Signature bad = sigs[i];
+        bad[0] ^= 1;
+        check(!ed25519_verify(pks[i], msgs[i].data(), msgs[i].size(), bad), name + ": acepta una firma alterada");
+        batch.push_back(Ed25519BatchItem{ &pks[i], msgs[i].data(), msgs[i].size(), &sigs[i] });
+    }
+    check(ed25519_verify_batch(batch), "lote de los tres vectores");
+    // Firma de otro mensaje: el lote debe rechazarlo
+    batch[2].sig = &sigs[1];
+    check(!ed25519_verify_batch(batch), "el lote acepta una firma cambiada");
+    if (ok) out_log += "Autoprueba Ed25519 OK (FIPS 180-2, RFC 8032 TEST 1-3, lote)\n";
+    return ok;
+}
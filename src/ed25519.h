@@ -0,0 +1,45 @@
+// src/ed25519.h
+// Firmas Ed25519 (RFC 8032) en proceso y sin dependencias, para no lanzar gpg
+// por cada repo cuando la firma es solo para uso interno.
+//
+// Campo en radix 2^25.5 (10 limbs de 64 bits, portable también a MSVC), puntos
+// en coordenadas extendidas y [s]B con una tabla fija de 64x16 múltiplos de B
+// (sin duplicaciones y con selección en tiempo constante). La verificación es
+// la "cofactored" ([8][S]B == [8]R + [8][k]A), la única que da el mismo
+// resultado firma a firma y en lote.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using Ed25519PublicKey = std::array<uint8_t, 32>;
+using Ed25519SecretKey = std::array<uint8_t, 64>; // semilla || clave pública (como libsodium)
+using Ed25519Signature = std::array<uint8_t, 64>;
+
+void ed25519_keypair(const uint8_t seed[32], Ed25519PublicKey& pk, Ed25519SecretKey& sk);
+
+Ed25519Signature ed25519_sign(const Ed25519SecretKey& sk, const uint8_t* msg, size_t len);
+
+bool ed25519_verify(const Ed25519PublicKey& pk, const uint8_t* msg, size_t len, const Ed25519Signature& sig);
+
+struct Ed25519BatchItem {
+    const Ed25519PublicKey* pk;
+    const uint8_t* msg;
+    size_t len;
+    const Ed25519Signature* sig;
+};
+
+// Comprueba todas a la vez con una combinación lineal aleatoria: una sola
+// multiplicación múltiple (Straus) en vez de una por firma, y la clave pública
+// repetida se suma una vez. true si todas son válidas; si es false hay que
+// verificarlas una a una para saber cuál falla.
+bool ed25519_verify_batch(const std::vector<Ed25519BatchItem>& items);
+
+// Vectores conocidos (SHA-512 de FIPS 180-2, RFC 8032 7.1 TEST 1-3, lote):
+// la aritmética de campo no es constexpr y no se puede comprobar con
+// static_assert como hash_algos.h. false y el fallo en out_log si no cuadran.
+bool ed25519_selftest(std::string& out_log);
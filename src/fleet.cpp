@@ -0,0 +1,127 @@
+// src/fleet.cpp
+
+#include "fleet.h"
+#include "hash_engine.h"
+#include "manifest.h"
+#include "merkle.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+static constexpr const char* kProofFile = "hashes.fleet";
+static constexpr const char* kSignedRootFile = "hashes.fleet.asc";
+
+std::string fleet_member_name(const fs::path& repo) {
+    fs::path p = repo;
+    if (!p.has_filename()) p = p.parent_path(); // "repo/"
+    return p.filename().string();
+}
+
+static bool leaf_for_repo(const fs::path& repo, MerkleHash& leaf, std::string& out_log) {
+    HashOptions o;
+    o.algo = HashAlgo::Sha256;
+    HashStats st;
+    std::string hex, err;
+    fs::path doc = signed_document(repo);
+    if (!hash_file(doc, o, hex, st, err)) {
+        out_log += "Flota: no se puede leer " + doc.string() + ": " + err + "\n";
+        return false;
+    }
+    leaf = merkle_leaf_hash(hex + "  " + fleet_member_name(repo));
+    return true;
+}
+
+bool fleet_build(const std::vector<fs::path>& repos, std::string& root_doc, std::string& out_log) {
+    std::vector<MerkleHash> leaves(repos.size());
+    for (size_t i = 0; i < repos.size(); ++i)
+        if (!leaf_for_repo(repos[i], leaves[i], out_log)) return false;
+    MerkleHash root = merkle_root(leaves);
+    std::string root_hex = merkle_hex(root);
+
+    for (size_t i = 0; i < repos.size(); ++i) {
+        std::ofstream ofs(repos[i] / kProofFile, std::ios::trunc);
+        if (!ofs.is_open()) {
+            out_log += "Error: no se puede crear " + (repos[i] / kProofFile).string() + "\n";
+            return false;
+        }
+        ofs << "hashnsign-fleet-proof v1\n"
+            << "name " << fleet_member_name(repos[i]) << "\n"
+            << "index " << i << "\n"
+            << "size " << repos.size() << "\n"
+            << "root " << root_hex << "\n";
+        for (auto& p : merkle_inclusion_path(leaves, i)) ofs << "path " << merkle_hex(p) << "\n";
+    }
+
+    root_doc = "hashnsign-fleet v1\nsize " + std::to_string(repos.size()) + "\nroot " + root_hex + "\n";
+    out_log += "Flota: " + std::to_string(repos.size()) + " repos, raíz " + root_hex.substr(0, 16) + "\n";
+    return true;
+}
+
+bool fleet_install_signature(const std::vector<fs::path>& repos, const fs::path& signed_root, std::string& out_log) {
+    for (auto& r : repos) {
+        std::error_code ec;
+        fs::copy_file(signed_root, r / kSignedRootFile, fs::copy_options::overwrite_existing, ec);
+        if (ec) {
+            out_log += "Error copiando la raíz firmada a " + r.string() + ": " + ec.message() + "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool fleet_parse_root(const std::string& doc, FleetRoot& root) {
+    std::istringstream iss(doc);
+    std::string line;
+    bool magic = false;
+    while (std::getline(iss, line)) {
+        if (line == "hashnsign-fleet v1") magic = true;
+        else if (line.rfind("size ", 0) == 0) root.size = std::strtoull(line.c_str() + 5, nullptr, 10);
+        else if (line.rfind("root ", 0) == 0) root.root = line.substr(5);
+    }
+    return magic && root.size > 0 && root.root.size() == 64;
+}
+
+bool fleet_check_repo(const fs::path& repo, const FleetRoot& root, std::string& out_log) {
+    std::ifstream ifs(repo / kProofFile);
+    if (!ifs.is_open()) {
+        out_log += "Flota: falta " + (repo / kProofFile).string() + "\n";
+        return false;
+    }
+    std::string line, name, proof_root;
+    uint64_t index = 0, size = 0;
+    std::vector<MerkleHash> path;
+    bool magic = false, bad = false;
+    while (std::getline(ifs, line)) {
+        if (line == "hashnsign-fleet-proof v1") magic = true;
+        else if (line.rfind("name ", 0) == 0) name = line.substr(5);
+        else if (line.rfind("index ", 0) == 0) index = std::strtoull(line.c_str() + 6, nullptr, 10);
+        else if (line.rfind("size ", 0) == 0) size = std::strtoull(line.c_str() + 5, nullptr, 10);
+        else if (line.rfind("root ", 0) == 0) proof_root = line.substr(5);
+        else if (line.rfind("path ", 0) == 0) {
+            MerkleHash h;
+            if (!merkle_from_hex(line.substr(5), h)) bad = true;
+            path.push_back(h);
+        }
+    }
+    if (!magic || bad) {
+        out_log += "Flota: " + (repo / kProofFile).string() + " mal formado\n";
+        return false;
+    }
+    // Otro repo válido de la flota no puede hacerse pasar por este
+    if (name != fleet_member_name(repo)) {
+        out_log += "Flota: la prueba de " + repo.string() + " es de '" + name + "'\n";
+        return false;
+    }
+    if (size != root.size || proof_root != root.root) {
+        out_log += "Flota: " + repo.string() + " pertenece a otra raíz (" + proof_root.substr(0, 16) + ")\n";
+        return false;
+    }
+    MerkleHash leaf, root_hash;
+    if (!leaf_for_repo(repo, leaf, out_log) || !merkle_from_hex(root.root, root_hash)) return false;
+    if (!merkle_verify_inclusion(leaf, index, size, path, root_hash)) {
+        out_log += "Flota: " + signed_document(repo).string() + " no está en la raíz firmada\n";
+        return false;
+    }
+    return true;
+}
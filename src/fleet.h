@@ -0,0 +1,40 @@
+// src/fleet.h
+// Firma de flota: en vez de una firma gpg por repo se firma una sola raíz.
+// Cada repo es una hoja "<sha256 de su documento firmado>  <nombre del repo>"
+// (hashes.md5 o hashes.tree, ver signed_document) de un árbol de Merkle
+// (merkle.h); la raíz va en un documento corto que se firma una vez en claro
+// (gpg --clearsign). Cada repo lleva:
+//   hashes.fleet      su prueba de inclusión (índice, tamaño, raíz, camino)
+//   hashes.fleet.asc  copia del documento raíz firmado, para verificarlo suelto
+// Verificar una flota entera es una verificación gpg más un SHA-256 y
+// log2(n) nodos por repo.
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct FleetRoot {
+    uint64_t size = 0;
+    std::string root; // hex
+};
+
+// Nombre de hoja de un repo: el de su directorio
+std::string fleet_member_name(const fs::path& repo);
+
+// Calcula el árbol sobre los documentos firmados de 'repos', escribe
+// hashes.fleet en cada uno y deja en 'root_doc' el documento a firmar.
+bool fleet_build(const std::vector<fs::path>& repos, std::string& root_doc, std::string& out_log);
+
+// Copia el documento raíz firmado a hashes.fleet.asc de cada repo
+bool fleet_install_signature(const std::vector<fs::path>& repos, const fs::path& signed_root, std::string& out_log);
+
+bool fleet_parse_root(const std::string& doc, FleetRoot& root);
+
+// ¿El documento firmado actual de 'repo' es la hoja que su hashes.fleet prueba
+// bajo 'root'? No llama a gpg: 'root' debe venir de un documento ya verificado.
+bool fleet_check_repo(const fs::path& repo, const FleetRoot& root, std::string& out_log);
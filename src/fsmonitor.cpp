@@ -0,0 +1,308 @@
+// src/fsmonitor.cpp
+
+#include "fsmonitor.h"
+#include "process.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+static constexpr const char* kWatchmanPrefix = "watchman:";
+
+// ------------------------------------------------- git fsmonitor--daemon (IPC)
+
+#ifndef _WIN32
+
+static bool write_all(int fd, const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+static bool read_all(int fd, char* p, size_t n) {
+    while (n > 0) {
+        ssize_t r = read(fd, p, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= (size_t)r;
+    }
+    return true;
+}
+
+// Una petición simple-ipc: cuerpo en pkt-lines + flush; la respuesta igual.
+static bool fsmonitor_ipc(const fs::path& sock_path, const std::string& request, std::string& response) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::string sp = sock_path.string();
+    if (sp.size() >= sizeof(addr.sun_path)) {
+        close(fd);
+        return false;
+    }
+    std::memcpy(addr.sun_path, sp.c_str(), sp.size() + 1);
+    // Un daemon colgado no debe congelar la GUI
+    timeval tv{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return false;
+    }
+
+    bool ok = true;
+    const size_t kMaxData = 65516; // LARGE_PACKET_DATA_MAX
+    for (size_t pos = 0; ok && pos < request.size(); pos += kMaxData) {
+        size_t n = std::min(kMaxData, request.size() - pos);
+        char hdr[5];
+        std::snprintf(hdr, sizeof(hdr), "%04x", (unsigned)(n + 4));
+        ok = write_all(fd, hdr, 4) && write_all(fd, request.data() + pos, n);
+    }
+    ok = ok && write_all(fd, "0000", 4);
+
+    response.clear();
+    while (ok) {
+        char hdr[5] = {};
+        if (!read_all(fd, hdr, 4)) { ok = false; break; }
+        unsigned len = (unsigned)std::strtoul(hdr, nullptr, 16);
+        if (len == 0) break; // flush: fin de la respuesta
+        if (len < 4) { ok = false; break; }
+        size_t old = response.size();
+        response.resize(old + len - 4);
+        if (!read_all(fd, &response[old], len - 4)) ok = false;
+    }
+    close(fd);
+    return ok;
+}
+
+#endif
+
+// Respuesta: "<token>\0" seguido de rutas terminadas en NUL, o "/" si el daemon
+// no puede responder desde ese token (todo puede haber cambiado).
+static bool query_git_fsmonitor(const fs::path& repo, const std::string& since, ChangeSet& cs, bool& trivial) {
+#ifndef _WIN32
+    fs::path sock = repo / ".git" / "fsmonitor--daemon.ipc";
+    std::error_code ec;
+    if (!fs::exists(sock, ec)) return false;
+    // Un token desconocido da la respuesta trivial con el token actual
+    std::string req = since.rfind("builtin:", 0) == 0 ? since : "builtin:0:0";
+    std::string resp;
+    if (!fsmonitor_ipc(sock, req, resp)) return false;
+
+    size_t nul = resp.find('\0');
+    if (nul == std::string::npos) return false;
+    cs.next_token = resp.substr(0, nul);
+    trivial = (since.rfind("builtin:", 0) != 0);
+    size_t pos = nul + 1;
+    while (pos < resp.size()) {
+        size_t end = resp.find('\0', pos);
+        if (end == std::string::npos) end = resp.size();
+        std::string p = resp.substr(pos, end - pos);
+        pos = end + 1;
+        if (p == "/") trivial = true;
+        else if (!p.empty()) cs.paths.push_back(p);
+    }
+    return true;
+#else
+    (void)repo; (void)since; (void)cs; (void)trivial;
+    return false;
+#endif
+}
+
+// -------------------------------------------------------------------- Watchman
+
+static std::string json_escape(const std::string& s) {
+    std::string o;
+    for (char c : s) {
+        if (c == '"' || c == '\\') { o += '\\'; o += c; }
+        else if ((unsigned char)c < 0x20) {
+            char tmp[8];
+            std::snprintf(tmp, sizeof(tmp), "\\u%04x", (unsigned)c);
+            o += tmp;
+        } else o += c;
+    }
+    return o;
+}
+
+// Lee la cadena JSON que empieza en js[pos] == '"'; deja pos tras la comilla final
+static bool json_read_string(const std::string& js, size_t& pos, std::string& out) {
+    if (pos >= js.size() || js[pos] != '"') return false;
+    out.clear();
+    for (++pos; pos < js.size(); ++pos) {
+        char c = js[pos];
+        if (c == '"') { ++pos; return true; }
+        if (c != '\\') { out += c; continue; }
+        if (++pos >= js.size()) return false;
+        switch (js[pos]) {
+        case 'n': out += '\n'; break;
+        case 't': out += '\t'; break;
+        case 'r': out += '\r'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'u': {
+            if (pos + 4 >= js.size()) return false;
+            unsigned cp = (unsigned)std::strtoul(js.substr(pos + 1, 4).c_str(), nullptr, 16);
+            pos += 4;
+            // Watchman escapa solo controles; basta con BMP a UTF-8
+            if (cp < 0x80) out += (char)cp;
+            else if (cp < 0x800) { out += (char)(0xc0 | (cp >> 6)); out += (char)(0x80 | (cp & 0x3f)); }
+            else { out += (char)(0xe0 | (cp >> 12)); out += (char)(0x80 | ((cp >> 6) & 0x3f)); out += (char)(0x80 | (cp & 0x3f)); }
+            break;
+        }
+        default: out += js[pos]; break; // \" \\ \/
+        }
+    }
+    return false;
+}
+
+// Posición del valor de "key" en un objeto JSON plano (respuestas de Watchman)
+static size_t json_value_pos(const std::string& js, const std::string& key) {
+    size_t k = js.find("\"" + key + "\"");
+    if (k == std::string::npos) return std::string::npos;
+    size_t colon = js.find(':', k + key.size() + 2);
+    if (colon == std::string::npos) return std::string::npos;
+    return js.find_first_not_of(" \t\r\n", colon + 1);
+}
+
+static bool json_get_string(const std::string& js, const std::string& key, std::string& out) {
+    size_t pos = json_value_pos(js, key);
+    return pos != std::string::npos && json_read_string(js, pos, out);
+}
+
+static bool json_get_string_array(const std::string& js, const std::string& key, std::vector<std::string>& out) {
+    size_t pos = json_value_pos(js, key);
+    if (pos == std::string::npos || js[pos] != '[') return false;
+    ++pos;
+    for (;;) {
+        pos = js.find_first_not_of(" \t\r\n,", pos);
+        if (pos == std::string::npos) return false;
+        if (js[pos] == ']') return true;
+        std::string s;
+        if (!json_read_string(js, pos, s)) return false;
+        out.push_back(std::move(s));
+    }
+}
+
+static bool watchman_call(const std::string& json, std::string& resp) {
+#ifndef _WIN32
+    auto [rc, out] = run_command_stdout("printf '%s' " + shell_quote(json) + " | watchman -j --no-pretty 2>/dev/null");
+    if (rc != 0 || out.find("\"error\"") != std::string::npos) return false;
+    resp = out;
+    return true;
+#else
+    (void)json; (void)resp;
+    return false;
+#endif
+}
+
+static bool query_watchman(const fs::path& repo, const std::string& since, ChangeSet& cs, bool& trivial) {
+    std::error_code ec;
+    fs::path root = fs::canonical(repo, ec);
+    if (ec) return false;
+
+    std::string resp;
+    if (!watchman_call("[\"watch-project\", \"" + json_escape(root.string()) + "\"]", resp)) return false;
+    std::string watch, rel;
+    if (!json_get_string(resp, "watch", watch)) return false;
+    json_get_string(resp, "relative_path", rel);
+
+    if (since.rfind(kWatchmanPrefix, 0) != 0) {
+        // Sin clock previo: solo se toma el actual
+        if (!watchman_call("[\"clock\", \"" + json_escape(watch) + "\"]", resp)) return false;
+        std::string clock;
+        if (!json_get_string(resp, "clock", clock)) return false;
+        cs.next_token = kWatchmanPrefix + clock;
+        trivial = true;
+        return true;
+    }
+
+    std::string q = "[\"query\", \"" + json_escape(watch) + "\", {\"since\": \"" +
+                    json_escape(since.substr(std::strlen(kWatchmanPrefix))) + "\", \"fields\": [\"name\"]";
+    if (!rel.empty()) q += ", \"relative_root\": \"" + json_escape(rel) + "\"";
+    q += "}]";
+    if (!watchman_call(q, resp)) return false;
+    std::string clock;
+    if (!json_get_string(resp, "clock", clock)) return false;
+    cs.next_token = kWatchmanPrefix + clock;
+    size_t fresh = json_value_pos(resp, "is_fresh_instance");
+    // Instancia nueva (reinicio de watchman): la lista no es relativa al token
+    trivial = (fresh != std::string::npos && resp.compare(fresh, 4, "true") == 0);
+    if (!json_get_string_array(resp, "files", cs.paths)) return false;
+    return true;
+}
+
+// ------------------------------------------------------------- estado y API
+
+static fs::path token_file(const fs::path& repo, const std::string& purpose) {
+    fs::path dir = state_dir(repo);
+    return dir.empty() ? fs::path() : dir / ("fsmonitor-" + purpose);
+}
+
+static std::string manifest_md5(const fs::path& repo) {
+    std::string hex, err;
+    HashStats st;
+    if (!hash_file(repo / "hashes.md5", HashOptions{}, hex, st, err)) return "";
+    return hex;
+}
+
+bool fsmonitor_changed_paths(const fs::path& repo, const std::string& purpose, ChangeSet& cs, std::string& out_log) {
+    cs.oracle = ChangeOracle::Fsmonitor;
+    fs::path tf = token_file(repo, purpose);
+    std::string since, saved_manifest;
+    if (!tf.empty()) {
+        std::ifstream ifs(tf);
+        std::getline(ifs, since);
+        std::getline(ifs, saved_manifest);
+    }
+    cs.base = since;
+
+    bool trivial = false;
+    bool answered = query_git_fsmonitor(repo, since, cs, trivial);
+    if (!answered) {
+        cs.paths.clear();
+        answered = query_watchman(repo, since, cs, trivial);
+    }
+    if (!answered) {
+        out_log += "fsmonitor: ni git fsmonitor--daemon ni Watchman disponibles en " + repo.string() + "\n";
+        return false;
+    }
+    if (trivial || since.empty()) {
+        out_log += "fsmonitor: sin token válido en " + repo.string() + ", se toma uno nuevo\n";
+        cs.paths.clear();
+        return false;
+    }
+    if (saved_manifest.empty() || saved_manifest != manifest_md5(repo)) {
+        out_log += "fsmonitor: hashes.md5 cambió desde el último token en " + repo.string() + "\n";
+        cs.paths.clear();
+        return false;
+    }
+    return true;
+}
+
+void fsmonitor_save_token(const fs::path& repo, const std::string& purpose, const ChangeSet& cs) {
+    if (cs.next_token.empty()) return;
+    fs::path tf = token_file(repo, purpose);
+    if (tf.empty()) return;
+    std::error_code ec;
+    fs::create_directories(tf.parent_path(), ec);
+    std::ofstream ofs(tf, std::ios::trunc);
+    ofs << cs.next_token << "\n" << manifest_md5(repo) << "\n";
+}
@@ -0,0 +1,24 @@
+// src/fsmonitor.h
+// Rutas cambiadas según un daemon de ficheros ya en marcha, sin recorrer el
+// árbol ni hacer stat de cada archivo:
+//   - git fsmonitor--daemon (socket .git/fsmonitor--daemon.ipc, protocolo pkt-line)
+//   - Watchman (watchman -j, "since" con el clock guardado)
+// El token de la última pasada se guarda por propósito ("generate", "verify")
+// en .git/hashnsign/fsmonitor-<propósito>, junto con el MD5 de hashes.md5 de
+// ese momento: si el manifiesto cambió por otra vía, el token no vale.
+
+#pragma once
+
+#include "incremental.h"
+
+#include <string>
+
+// Rellena cs.paths con lo cambiado desde el token guardado. cs.next_token
+// queda con el token actual siempre que algún daemon responda, aunque la
+// respuesta no sirva (primera vez, daemon reiniciado, manifiesto distinto):
+// en ese caso devuelve false y el llamante hace la pasada completa.
+bool fsmonitor_changed_paths(const fs::path& repo, const std::string& purpose, ChangeSet& cs, std::string& out_log);
+
+// Guarda cs.next_token como base para la próxima pasada de 'purpose', ligado
+// al hashes.md5 actual. No hace nada si no hubo daemon.
+void fsmonitor_save_token(const fs::path& repo, const std::string& purpose, const ChangeSet& cs);
@@ -0,0 +1,423 @@
+// src/hash_algos.h
+// Algoritmos de hash como tipos concretos, sin interfaz virtual: el motor se
+// instancia por algoritmo (plantillas) y update/final quedan en línea dentro
+// del bucle por bloque. Solo hay un despacho por archivo (ver hash_engine.cpp).
+//
+// Todo es constexpr para poder comprobar los vectores de prueba en compilación
+// (static_assert al final de este fichero).
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace hash_detail {
+
+constexpr uint32_t rotl32(uint32_t x, int c) { return (x << c) | (x >> (32 - c)); }
+constexpr uint32_t rotr32(uint32_t x, int c) { return (x >> c) | (x << (32 - c)); }
+
+template <typename Byte>
+constexpr uint32_t load_le32(const Byte* p) {
+    return (uint32_t)(uint8_t)p[0] | ((uint32_t)(uint8_t)p[1] << 8) |
+           ((uint32_t)(uint8_t)p[2] << 16) | ((uint32_t)(uint8_t)p[3] << 24);
+}
+
+template <typename Byte>
+constexpr uint32_t load_be32(const Byte* p) {
+    return ((uint32_t)(uint8_t)p[0] << 24) | ((uint32_t)(uint8_t)p[1] << 16) |
+           ((uint32_t)(uint8_t)p[2] << 8) | (uint32_t)(uint8_t)p[3];
+}
+
+// Buffer de bloque, contador de longitud y relleno Merkle–Damgård comunes.
+// Derived aporta compress(const Byte*) y compress_zero() (bloque todo a cero).
+template <class Derived, size_t Block, bool BigEndianLength>
+class BlockHash {
+public:
+    static constexpr size_t block_size = Block;
+
+    template <typename Byte>
+    constexpr void update(const Byte* p, size_t len) {
+        static_assert(sizeof(Byte) == 1, "update() espera bytes");
+        size_t have = (size_t)(length_ % Block);
+        length_ += len;
+        if (have) {
+            size_t need = Block - have;
+            size_t take = len < need ? len : need;
+            for (size_t i = 0; i < take; ++i) buffer_[have + i] = (uint8_t)p[i];
+            if (take < need) return;
+            self().compress(buffer_.data());
+            p += need;
+            len -= need;
+        }
+        for (; len >= Block; p += Block, len -= Block) self().compress(p);
+        for (size_t i = 0; i < len; ++i) buffer_[i] = (uint8_t)p[i];
+    }
+
+    // Equivale a update() con 'len' bytes a cero sin leer memoria de entrada:
+    // los bloques completos usan compress_zero(), con el mensaje plegado a 0.
+    constexpr void update_zeros(uint64_t len) {
+        size_t have = (size_t)(length_ % Block);
+        length_ += len;
+        if (have) {
+            size_t need = Block - have;
+            size_t take = len < need ? (size_t)len : need;
+            for (size_t i = 0; i < take; ++i) buffer_[have + i] = 0;
+            if (take < need) return;
+            self().compress(buffer_.data());
+            len -= need;
+        }
+        for (; len >= Block; len -= Block) self().compress_zero();
+        for (size_t i = 0; i < (size_t)len; ++i) buffer_[i] = 0;
+    }
+
+    uint64_t length() const { return length_; }
+
+    // Estado intermedio serializado para reanudar más tarde un archivo que
+    // solo crece: "<longitud>:<registros hex>:<bloque a medias hex>".
+    std::string save_state() const {
+        std::string s = std::to_string(length_) + ":";
+        for (uint32_t w : self().state_) {
+            for (int i = 28; i >= 0; i -= 4) s += "0123456789abcdef"[(w >> i) & 0xf];
+        }
+        s += ":";
+        size_t have = (size_t)(length_ % Block);
+        for (size_t i = 0; i < have; ++i) {
+            s += "0123456789abcdef"[buffer_[i] >> 4];
+            s += "0123456789abcdef"[buffer_[i] & 0xf];
+        }
+        return s;
+    }
+
+    // Inverso de save_state(); false (y estado sin tocar) si no encaja con
+    // este algoritmo.
+    bool load_state(const std::string& s) {
+        auto nib = [](char c) -> int {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            return -1;
+        };
+        size_t c1 = s.find(':');
+        size_t c2 = c1 == std::string::npos ? c1 : s.find(':', c1 + 1);
+        if (c1 == 0 || c2 == std::string::npos) return false;
+        uint64_t len = 0;
+        for (size_t i = 0; i < c1; ++i) {
+            if (s[i] < '0' || s[i] > '9') return false;
+            len = len * 10 + (uint64_t)(s[i] - '0');
+        }
+        auto st = self().state_;
+        if (c2 - c1 - 1 != st.size() * 8) return false;
+        for (size_t w = 0; w < st.size(); ++w) {
+            uint32_t v = 0;
+            for (size_t i = 0; i < 8; ++i) {
+                int n = nib(s[c1 + 1 + w * 8 + i]);
+                if (n < 0) return false;
+                v = (v << 4) | (uint32_t)n;
+            }
+            st[w] = v;
+        }
+        size_t have = (size_t)(len % Block);
+        if (s.size() - c2 - 1 != have * 2) return false;
+        std::array<uint8_t, Block> buf{};
+        for (size_t i = 0; i < have; ++i) {
+            int hi = nib(s[c2 + 1 + 2 * i]), lo = nib(s[c2 + 2 + 2 * i]);
+            if (hi < 0 || lo < 0) return false;
+            buf[i] = (uint8_t)(hi << 4 | lo);
+        }
+        self().state_ = st;
+        buffer_ = buf;
+        length_ = len;
+        return true;
+    }
+
+protected:
+    constexpr void pad() {
+        uint64_t bit_len = length_ * 8;
+        std::array<uint8_t, Block> pad{};
+        pad[0] = 0x80;
+        size_t have = (size_t)(length_ % Block);
+        size_t pad_len = (have < Block - 8) ? (Block - 8 - have) : (2 * Block - 8 - have);
+        update(pad.data(), pad_len);
+        std::array<uint8_t, 8> len_bytes{};
+        for (int i = 0; i < 8; ++i)
+            len_bytes[BigEndianLength ? 7 - i : i] = (uint8_t)(bit_len >> (8 * i));
+        update(len_bytes.data(), 8);
+    }
+
+    uint64_t length_ = 0;
+    std::array<uint8_t, Block> buffer_{};
+
+private:
+    constexpr Derived& self() { return static_cast<Derived&>(*this); }
+    constexpr const Derived& self() const { return static_cast<const Derived&>(*this); }
+};
+
+} // namespace hash_detail
+
+// Convierte un digest binario a hex en minúsculas (formato md5sum/sha256sum).
+inline std::string to_hex(const uint8_t* data, size_t len) {
+    static const char* digits = "0123456789abcdef";
+    std::string s(len * 2, '0');
+    for (size_t i = 0; i < len; ++i) {
+        s[2 * i] = digits[data[i] >> 4];
+        s[2 * i + 1] = digits[data[i] & 0x0f];
+    }
+    return s;
+}
+
+// ---------------------------------------------------------------- MD5 (RFC 1321)
+
+class Md5 : public hash_detail::BlockHash<Md5, 64, false> {
+public:
+    static constexpr const char* name = "md5";
+    static constexpr size_t digest_size = 16;
+    using Digest = std::array<uint8_t, digest_size>;
+
+    constexpr Digest final() {
+        pad();
+        Digest out{};
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j) out[i * 4 + j] = (uint8_t)(state_[i] >> (8 * j));
+        return out;
+    }
+    std::string hex_final() { Digest d = final(); return to_hex(d.data(), d.size()); }
+
+private:
+    friend class hash_detail::BlockHash<Md5, 64, false>;
+
+    template <typename Byte>
+    constexpr void compress(const Byte* block) {
+        std::array<uint32_t, 16> X{};
+        for (int i = 0; i < 16; ++i) X[i] = hash_detail::load_le32(block + i * 4);
+        rounds<false>(X.data());
+    }
+    constexpr void compress_zero() { rounds<true>(nullptr); }
+
+    // Con Zero=true el compilador elimina las sumas de X[k] (todas son 0), que es
+    // lo único que depende del bloque; el resto depende del estado encadenado.
+    template <bool Zero>
+    constexpr void rounds(const uint32_t* X) {
+        using hash_detail::rotl32;
+        auto x = [X](int k) constexpr -> uint32_t { return Zero ? 0u : X[k]; };
+        uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+
+#define MD5_STEP(f, a, b, c, d, k, s, t) \
+    a += f(b, c, d) + x(k) + (t);        \
+    a = rotl32(a, s) + b;
+#define F(x, y, z) (((x) & (y)) | (~(x) & (z)))
+#define G(x, y, z) (((x) & (z)) | ((y) & ~(z)))
+#define H(x, y, z) ((x) ^ (y) ^ (z))
+#define I(x, y, z) ((y) ^ ((x) | ~(z)))
+
+        MD5_STEP(F, a, b, c, d,  0,  7, 0xd76aa478) MD5_STEP(F, d, a, b, c,  1, 12, 0xe8c7b756)
+        MD5_STEP(F, c, d, a, b,  2, 17, 0x242070db) MD5_STEP(F, b, c, d, a,  3, 22, 0xc1bdceee)
+        MD5_STEP(F, a, b, c, d,  4,  7, 0xf57c0faf) MD5_STEP(F, d, a, b, c,  5, 12, 0x4787c62a)
+        MD5_STEP(F, c, d, a, b,  6, 17, 0xa8304613) MD5_STEP(F, b, c, d, a,  7, 22, 0xfd469501)
+        MD5_STEP(F, a, b, c, d,  8,  7, 0x698098d8) MD5_STEP(F, d, a, b, c,  9, 12, 0x8b44f7af)
+        MD5_STEP(F, c, d, a, b, 10, 17, 0xffff5bb1) MD5_STEP(F, b, c, d, a, 11, 22, 0x895cd7be)
+        MD5_STEP(F, a, b, c, d, 12,  7, 0x6b901122) MD5_STEP(F, d, a, b, c, 13, 12, 0xfd987193)
+        MD5_STEP(F, c, d, a, b, 14, 17, 0xa679438e) MD5_STEP(F, b, c, d, a, 15, 22, 0x49b40821)
+
+        MD5_STEP(G, a, b, c, d,  1,  5, 0xf61e2562) MD5_STEP(G, d, a, b, c,  6,  9, 0xc040b340)
+        MD5_STEP(G, c, d, a, b, 11, 14, 0x265e5a51) MD5_STEP(G, b, c, d, a,  0, 20, 0xe9b6c7aa)
+        MD5_STEP(G, a, b, c, d,  5,  5, 0xd62f105d) MD5_STEP(G, d, a, b, c, 10,  9, 0x02441453)
+        MD5_STEP(G, c, d, a, b, 15, 14, 0xd8a1e681) MD5_STEP(G, b, c, d, a,  4, 20, 0xe7d3fbc8)
+        MD5_STEP(G, a, b, c, d,  9,  5, 0x21e1cde6) MD5_STEP(G, d, a, b, c, 14,  9, 0xc33707d6)
+        MD5_STEP(G, c, d, a, b,  3, 14, 0xf4d50d87) MD5_STEP(G, b, c, d, a,  8, 20, 0x455a14ed)
+        MD5_STEP(G, a, b, c, d, 13,  5, 0xa9e3e905) MD5_STEP(G, d, a, b, c,  2,  9, 0xfcefa3f8)
+        MD5_STEP(G, c, d, a, b,  7, 14, 0x676f02d9) MD5_STEP(G, b, c, d, a, 12, 20, 0x8d2a4c8a)
+
+        MD5_STEP(H, a, b, c, d,  5,  4, 0xfffa3942) MD5_STEP(H, d, a, b, c,  8, 11, 0x8771f681)
+        MD5_STEP(H, c, d, a, b, 11, 16, 0x6d9d6122) MD5_STEP(H, b, c, d, a, 14, 23, 0xfde5380c)
+        MD5_STEP(H, a, b, c, d,  1,  4, 0xa4beea44) MD5_STEP(H, d, a, b, c,  4, 11, 0x4bdecfa9)
+        MD5_STEP(H, c, d, a, b,  7, 16, 0xf6bb4b60) MD5_STEP(H, b, c, d, a, 10, 23, 0xbebfbc70)
+        MD5_STEP(H, a, b, c, d, 13,  4, 0x289b7ec6) MD5_STEP(H, d, a, b, c,  0, 11, 0xeaa127fa)
+        MD5_STEP(H, c, d, a, b,  3, 16, 0xd4ef3085) MD5_STEP(H, b, c, d, a,  6, 23, 0x04881d05)
+        MD5_STEP(H, a, b, c, d,  9,  4, 0xd9d4d039) MD5_STEP(H, d, a, b, c, 12, 11, 0xe6db99e5)
+        MD5_STEP(H, c, d, a, b, 15, 16, 0x1fa27cf8) MD5_STEP(H, b, c, d, a,  2, 23, 0xc4ac5665)
+
+        MD5_STEP(I, a, b, c, d,  0,  6, 0xf4292244) MD5_STEP(I, d, a, b, c,  7, 10, 0x432aff97)
+        MD5_STEP(I, c, d, a, b, 14, 15, 0xab9423a7) MD5_STEP(I, b, c, d, a,  5, 21, 0xfc93a039)
+        MD5_STEP(I, a, b, c, d, 12,  6, 0x655b59c3) MD5_STEP(I, d, a, b, c,  3, 10, 0x8f0ccc92)
+        MD5_STEP(I, c, d, a, b, 10, 15, 0xffeff47d) MD5_STEP(I, b, c, d, a,  1, 21, 0x85845dd1)
+        MD5_STEP(I, a, b, c, d,  8,  6, 0x6fa87e4f) MD5_STEP(I, d, a, b, c, 15, 10, 0xfe2ce6e0)
+        MD5_STEP(I, c, d, a, b,  6, 15, 0xa3014314) MD5_STEP(I, b, c, d, a, 13, 21, 0x4e0811a1)
+        MD5_STEP(I, a, b, c, d,  4,  6, 0xf7537e82) MD5_STEP(I, d, a, b, c, 11, 10, 0xbd3af235)
+        MD5_STEP(I, c, d, a, b,  2, 15, 0x2ad7d2bb) MD5_STEP(I, b, c, d, a,  9, 21, 0xeb86d391)
+
+#undef F
+#undef G
+#undef H
+#undef I
+#undef MD5_STEP
+
+        state_[0] += a; state_[1] += b; state_[2] += c; state_[3] += d;
+    }
+
+    std::array<uint32_t, 4> state_{{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476}};
+};
+
+// ---------------------------------------------------------- SHA-256 (FIPS 180-4)
+
+namespace hash_detail {
+inline constexpr uint32_t kSha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+} // namespace hash_detail
+
+class Sha256 : public hash_detail::BlockHash<Sha256, 64, true> {
+public:
+    static constexpr const char* name = "sha256";
+    static constexpr size_t digest_size = 32;
+    using Digest = std::array<uint8_t, digest_size>;
+
+    constexpr Digest final() {
+        pad();
+        Digest out{};
+        for (int i = 0; i < 8; ++i)
+            for (int j = 0; j < 4; ++j) out[i * 4 + j] = (uint8_t)(state_[i] >> (24 - 8 * j));
+        return out;
+    }
+    std::string hex_final() { Digest d = final(); return to_hex(d.data(), d.size()); }
+
+private:
+    friend class hash_detail::BlockHash<Sha256, 64, true>;
+
+    template <typename Byte>
+    constexpr void compress(const Byte* block) {
+        std::array<uint32_t, 64> W{};
+        for (int i = 0; i < 16; ++i) W[i] = hash_detail::load_be32(block + i * 4);
+        expand(W);
+        rounds(W);
+    }
+    // Un bloque a cero tiene W[0..15] = 0 y, como sigma0(0) = sigma1(0) = 0,
+    // toda la expansión es 0: no hace falta calcularla.
+    constexpr void compress_zero() {
+        std::array<uint32_t, 64> W{};
+        rounds(W);
+    }
+
+    static constexpr void expand(std::array<uint32_t, 64>& W) {
+        using hash_detail::rotr32;
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = rotr32(W[i - 15], 7) ^ rotr32(W[i - 15], 18) ^ (W[i - 15] >> 3);
+            uint32_t s1 = rotr32(W[i - 2], 17) ^ rotr32(W[i - 2], 19) ^ (W[i - 2] >> 10);
+            W[i] = W[i - 16] + s0 + W[i - 7] + s1;
+        }
+    }
+
+    constexpr void rounds(const std::array<uint32_t, 64>& W) {
+        using hash_detail::rotr32;
+        uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+        uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t S1 = rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + S1 + ch + hash_detail::kSha256K[i] + W[i];
+            uint32_t S0 = rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = S0 + maj;
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state_[0] += a; state_[1] += b; state_[2] += c; state_[3] += d;
+        state_[4] += e; state_[5] += f; state_[6] += g; state_[7] += h;
+    }
+
+    std::array<uint32_t, 8> state_{{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19}};
+};
+
+// ------------------------------------------------------------ interfaz común
+
+// Lo que el motor exige a un algoritmo. En C++17 se comprueba con
+// static_assert(is_hash_algorithm<H>::value); en C++20 también como concepto.
+template <class H, class = void>
+struct is_hash_algorithm : std::false_type {};
+
+template <class H>
+struct is_hash_algorithm<H, std::void_t<
+    decltype(H::block_size), decltype(H::digest_size), decltype(H::name), typename H::Digest,
+    decltype(std::declval<H&>().update(std::declval<const char*>(), size_t{})),
+    decltype(std::declval<H&>().update_zeros(uint64_t{})),
+    decltype(std::declval<H&>().final())>>
+    : std::bool_constant<std::is_same_v<decltype(std::declval<H&>().final()), typename H::Digest> &&
+                         std::tuple_size<typename H::Digest>::value == H::digest_size> {};
+
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+template <class H>
+concept HashAlgorithm = is_hash_algorithm<H>::value;
+#endif
+
+// ------------------------------------------------- vectores de prueba (compilación)
+
+namespace hash_detail {
+
+constexpr size_t cstr_len(const char* s) {
+    size_t n = 0;
+    while (s[n]) ++n;
+    return n;
+}
+
+constexpr uint8_t hex_nibble(char c) {
+    return (uint8_t)(c <= '9' ? c - '0' : c - 'a' + 10);
+}
+
+template <class H>
+constexpr bool digest_equals(const typename H::Digest& d, const char* hex) {
+    for (size_t i = 0; i < H::digest_size; ++i)
+        if (d[i] != (uint8_t)((hex_nibble(hex[2 * i]) << 4) | hex_nibble(hex[2 * i + 1]))) return false;
+    return true;
+}
+
+template <class H>
+constexpr bool check_vector(const char* msg, const char* hex) {
+    H h;
+    h.update(msg, cstr_len(msg));
+    return digest_equals<H>(h.final(), hex);
+}
+
+// update_zeros() debe coincidir con pasar los ceros de verdad, cruzando bloques
+template <class H>
+constexpr bool check_zeros(size_t head, uint64_t zeros) {
+    H a, b;
+    std::array<uint8_t, 3 * H::block_size> z{};
+    a.update("xyz", head);
+    b.update("xyz", head);
+    a.update_zeros(zeros);
+    b.update(z.data(), (size_t)zeros);
+    auto da = a.final();
+    auto db = b.final();
+    for (size_t i = 0; i < H::digest_size; ++i)
+        if (da[i] != db[i]) return false;
+    return true;
+}
+
+} // namespace hash_detail
+
+static_assert(is_hash_algorithm<Md5>::value, "Md5 no cumple la interfaz de algoritmo");
+static_assert(is_hash_algorithm<Sha256>::value, "Sha256 no cumple la interfaz de algoritmo");
+
+static_assert(hash_detail::check_vector<Md5>("", "d41d8cd98f00b204e9800998ecf8427e"), "MD5 vacío");
+static_assert(hash_detail::check_vector<Md5>("abc", "900150983cd24fb0d6963f7d28e17f72"), "MD5 abc");
+static_assert(hash_detail::check_vector<Md5>(
+                  "12345678901234567890123456789012345678901234567890123456789012345678901234567890",
+                  "57edf4a22be3c955ac49da2e2107b67a"), "MD5 RFC 1321 (80 dígitos)");
+static_assert(hash_detail::check_zeros<Md5>(3, 2 * 64 + 5), "MD5 update_zeros");
+
+static_assert(hash_detail::check_vector<Sha256>("", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"), "SHA-256 vacío");
+static_assert(hash_detail::check_vector<Sha256>("abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"), "SHA-256 abc");
+static_assert(hash_detail::check_vector<Sha256>(
+                  "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+                  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"), "SHA-256 448 bits");
+static_assert(hash_detail::check_zeros<Sha256>(3, 2 * 64 + 5), "SHA-256 update_zeros");
@@ -0,0 +1,721 @@
+// src/hash_engine.cpp
+
+#include "hash_engine.h"
+#include "buffer_pool.h"
+#include "digest_cache.h"
+#include "hash_algos.h"
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <csetjmp>
+#include <csignal>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/if_alg.h>
+#include <sys/socket.h>
+#endif
+
+const char* algo_name(HashAlgo a) {
+    switch (a) {
+    case HashAlgo::Md5: return Md5::name;
+    case HashAlgo::Sha256: return Sha256::name;
+    }
+    return "?";
+}
+
+const char* backend_name(ReadBackend b) {
+    switch (b) {
+    case ReadBackend::Buffered: return "buffered";
+    case ReadBackend::Mmap: return "mmap";
+    case ReadBackend::AfAlg: return "af_alg";
+    }
+    return "?";
+}
+
+bool backend_available(ReadBackend b, HashAlgo a) {
+    switch (b) {
+    case ReadBackend::Buffered: return true;
+    case ReadBackend::Mmap:
+#ifndef _WIN32
+        return true;
+#else
+        return false;
+#endif
+    case ReadBackend::AfAlg: {
+#ifdef __linux__
+        int fd = socket(AF_ALG, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (fd < 0) return false;
+        sockaddr_alg sa{};
+        sa.salg_family = AF_ALG;
+        std::strncpy(reinterpret_cast<char*>(sa.salg_type), "hash", sizeof(sa.salg_type) - 1);
+        std::strncpy(reinterpret_cast<char*>(sa.salg_name), algo_name(a), sizeof(sa.salg_name) - 1);
+        bool ok = bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0;
+        close(fd);
+        return ok;
+#else
+        (void)a;
+        return false;
+#endif
+    }
+    }
+    return false;
+}
+
+#ifndef _WIN32
+
+// Ventana de mmap: acota el espacio de direcciones por worker en ficheros enormes
+static constexpr off_t kMmapWindow = (off_t)64 << 20;
+// Por debajo de esto mmap+munmap cuesta más que la copia que ahorra
+static constexpr off_t kMmapMinSize = (off_t)256 << 10;
+
+// Si otro proceso trunca el fichero mientras está mapeado, leer las páginas
+// que ya no existen da SIGBUS. El manejador lo convierte en un error de
+// lectura cuando la dirección cae en la región que el hilo está hasheando;
+// cualquier otro SIGBUS sigue yendo al manejador anterior.
+namespace {
+
+struct MmapGuard {
+    sigjmp_buf env;
+    const char* lo;
+    const char* hi;
+};
+
+thread_local MmapGuard* t_mmap_guard = nullptr;
+struct sigaction g_prev_sigbus;
+
+void on_sigbus(int sig, siginfo_t* si, void* ctx) {
+    MmapGuard* g = t_mmap_guard;
+    const char* addr = static_cast<const char*>(si->si_addr);
+    if (g && addr >= g->lo && addr < g->hi) siglongjmp(g->env, 1);
+    if (g_prev_sigbus.sa_flags & SA_SIGINFO) {
+        g_prev_sigbus.sa_sigaction(sig, si, ctx);
+    } else if (g_prev_sigbus.sa_handler != SIG_DFL && g_prev_sigbus.sa_handler != SIG_IGN) {
+        g_prev_sigbus.sa_handler(sig);
+    } else {
+        // Al volver se repite el acceso y el comportamiento por defecto termina el proceso
+        sigaction(SIGBUS, &g_prev_sigbus, nullptr);
+    }
+}
+
+void install_sigbus_guard() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        struct sigaction sa;
+        std::memset(&sa, 0, sizeof(sa));
+        sa.sa_sigaction = on_sigbus;
+        sa.sa_flags = SA_SIGINFO;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGBUS, &sa, &g_prev_sigbus);
+    });
+}
+
+// h.update sobre memoria mapeada; false si la región desaparece a medias.
+// Entre sigsetjmp y update no hay objetos con destructor que saltarse.
+template <class H>
+bool guarded_update(H& h, const char* p, size_t n) {
+    MmapGuard g;
+    g.lo = p;
+    g.hi = p + n;
+    if (sigsetjmp(g.env, 1)) {
+        t_mmap_guard = nullptr;
+        return false;
+    }
+    t_mmap_guard = &g;
+    h.update(p, n);
+    t_mmap_guard = nullptr;
+    return true;
+}
+
+} // namespace
+
+// Hashea [pos, end) directamente sobre la page cache, sin copiar a un buffer.
+// Un truncado concurrente llega como SIGBUS y se devuelve como error.
+template <class H>
+static bool hash_range_mmap(int fd, off_t pos, off_t end, H& h, HashStats& stats, std::string& err) {
+    install_sigbus_guard();
+    static const off_t page = (off_t)sysconf(_SC_PAGESIZE);
+    while (pos < end) {
+        off_t base = pos & ~(page - 1);
+        size_t len = (size_t)std::min<off_t>(kMmapWindow, end - base);
+        void* m = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, base);
+        if (m == MAP_FAILED) {
+            err = std::strerror(errno);
+            return false;
+        }
+        // Readahead agresivo y, si el sistema de ficheros lo admite, THP en page cache
+        madvise(m, len, MADV_SEQUENTIAL);
+        madvise(m, len, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+        madvise(m, len, MADV_HUGEPAGE);
+#endif
+        size_t skip = (size_t)(pos - base);
+        bool mapped_ok;
+        {
+            // Aquí los fallos de página (la lectura real) caen dentro de hash
+            PhaseScope phase(Phase::Hash);
+            mapped_ok = guarded_update(h, static_cast<const char*>(m) + skip, len - skip);
+        }
+        if (!mapped_ok) {
+            munmap(m, len);
+            err = "truncado durante la lectura (SIGBUS)";
+            return false;
+        }
+        stats.bytes_read += len - skip;
+        munmap(m, len);
+        pos = base + (off_t)len;
+    }
+    return true;
+}
+
+// Lee [pos, end) con pread y lo pasa al digest. Devuelve false si hay error de
+// lectura; un EOF prematuro (fichero truncado mientras se leía) solo corta.
+template <class H>
+static bool hash_range(int fd, off_t pos, off_t end, H& h, char* buf, size_t buf_size,
+                       HashStats& stats, std::string& err) {
+    while (pos < end) {
+        size_t want = (size_t)std::min<off_t>((off_t)buf_size, end - pos);
+        ssize_t n = pread(fd, buf, want, pos);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            err = std::strerror(errno);
+            return false;
+        }
+        if (n == 0) break;
+        {
+            PhaseScope phase(Phase::Hash);
+            h.update(buf, (size_t)n);
+        }
+        stats.bytes_read += (uint64_t)n;
+        pos += n;
+    }
+    return true;
+}
+
+template <class H>
+static bool hash_data(int fd, off_t pos, off_t end, ReadBackend backend, H& h, char* buf, size_t buf_size,
+                      HashStats& stats, std::string& err) {
+    if (backend == ReadBackend::Mmap && end - pos >= kMmapMinSize)
+        return hash_range_mmap(fd, pos, end, h, stats, err);
+    return hash_range(fd, pos, end, h, buf, buf_size, stats, err);
+}
+
+#ifdef __linux__
+
+namespace {
+
+// Sockets de transformación AF_ALG de este hilo, uno por algoritmo (-1 si el
+// kernel no lo ofrece). Cada archivo abre su operación con accept().
+struct AfAlgTfms {
+    std::vector<std::pair<std::string, int>> fds;
+
+    ~AfAlgTfms() {
+        for (auto& f : fds)
+            if (f.second >= 0) close(f.second);
+    }
+
+    int get(const char* algo) {
+        for (auto& f : fds)
+            if (f.first == algo) return f.second;
+        int fd = socket(AF_ALG, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (fd >= 0) {
+            sockaddr_alg sa{};
+            sa.salg_family = AF_ALG;
+            std::strncpy(reinterpret_cast<char*>(sa.salg_type), "hash", sizeof(sa.salg_type) - 1);
+            std::strncpy(reinterpret_cast<char*>(sa.salg_name), algo, sizeof(sa.salg_name) - 1);
+            if (bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        fds.emplace_back(algo, fd);
+        return fd;
+    }
+};
+
+} // namespace
+
+// Hash en el kernel (API crypto, AF_ALG): las páginas del fichero pasan de la
+// page cache al socket de hash con splice a través de una tubería, sin copiarse
+// nunca a espacio de usuario; con drivers acelerados el cálculo sale de la CPU.
+// 'unsupported' si el kernel no ofrece el algoritmo o rechaza el primer splice.
+template <class H>
+static bool hash_afalg(int fd, off_t size, std::string& hex, HashStats& stats, std::string& err, bool& unsupported) {
+    static thread_local AfAlgTfms tfms;
+    int tfm = tfms.get(H::name);
+    if (tfm < 0) {
+        unsupported = true;
+        return false;
+    }
+    int op = accept4(tfm, nullptr, nullptr, SOCK_CLOEXEC);
+    if (op < 0) {
+        unsupported = true;
+        return false;
+    }
+    int p[2];
+    if (pipe2(p, O_CLOEXEC) != 0) {
+        close(op);
+        unsupported = true;
+        return false;
+    }
+    int psz = fcntl(p[1], F_SETPIPE_SZ, 1 << 20);
+    size_t chunk = psz > 0 ? (size_t)psz : 65536;
+
+    loff_t off = 0;
+    uint64_t sent = 0;
+    bool ok = true;
+    while (ok && off < size) {
+        ssize_t n = splice(fd, &off, p[1], nullptr, (size_t)std::min<off_t>((off_t)chunk, size - off), SPLICE_F_MORE);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (sent == 0) unsupported = true;
+            err = std::strerror(errno);
+            ok = false;
+            break;
+        }
+        if (n == 0) break; // truncado mientras se leía
+        for (ssize_t left = n; left > 0;) {
+            ssize_t m = splice(p[0], nullptr, op, nullptr, (size_t)left, SPLICE_F_MORE);
+            if (m < 0) {
+                if (errno == EINTR) continue;
+                if (sent == 0) unsupported = true; // primer bloque: el socket no admite splice
+                err = std::strerror(errno);
+                ok = false;
+                break;
+            }
+            left -= m;
+        }
+        sent += (uint64_t)n;
+    }
+    stats.bytes_read += sent;
+    if (ok) {
+        // read() cierra la operación (aunque quedara SPLICE_F_MORE) y da el digest
+        typename H::Digest d{};
+        ssize_t r = read(op, d.data(), d.size());
+        if (r == (ssize_t)d.size()) {
+            hex = to_hex(d.data(), d.size());
+        } else {
+            err = r < 0 ? std::strerror(errno) : "digest AF_ALG incompleto";
+            ok = false;
+        }
+    }
+    close(p[0]);
+    close(p[1]);
+    close(op);
+    return ok;
+}
+
+#endif
+
+// Solo compensa guardar el estado en archivos grandes
+static constexpr off_t kResumeMinSize = (off_t)16 << 20;
+// Ventana final del prefijo que se comprueba antes de reanudar
+static constexpr off_t kResumeTail = (off_t)64 << 10;
+
+// MD5 de [end - kResumeTail, end): barato y detecta que el prefijo se reescribió
+static bool tail_window_md5(int fd, off_t end, char* buf, size_t buf_size, std::string& hex) {
+    Md5 m;
+    off_t pos = end - std::min<off_t>(end, kResumeTail);
+    while (pos < end) {
+        size_t want = (size_t)std::min<off_t>((off_t)buf_size, end - pos);
+        ssize_t n = pread(fd, buf, want, pos);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        m.update(buf, (size_t)n);
+        pos += n;
+    }
+    hex = m.hex_final();
+    return true;
+}
+
+// Recorre el fichero por extents de datos. Los huecos se pasan como ceros.
+// Si el sistema de ficheros no soporta SEEK_DATA marca 'unsupported' para que
+// el llamante use la lectura secuencial.
+template <class H>
+static bool hash_sparse(int fd, off_t size, ReadBackend backend, H& h, char* buf, size_t buf_size,
+                        HashStats& stats, std::string& err, bool& unsupported) {
+    unsupported = false;
+    off_t pos = 0;
+    while (pos < size) {
+        off_t data = lseek(fd, pos, SEEK_DATA);
+        if (data < 0) {
+            if (errno == ENXIO) {
+                data = size; // el resto del fichero es un hueco
+            } else if (pos == 0 && errno == EINVAL) {
+                unsupported = true;
+                return false;
+            } else {
+                err = std::strerror(errno);
+                return false;
+            }
+        }
+        if (data > size) data = size;
+        if (data > pos) {
+            h.update_zeros((uint64_t)(data - pos));
+            stats.bytes_hole += (uint64_t)(data - pos);
+            pos = data;
+        }
+        if (pos >= size) break;
+
+        off_t hole = lseek(fd, pos, SEEK_HOLE);
+        if (hole < 0 || hole > size) hole = size;
+        if (!hash_data(fd, pos, hole, backend, h, buf, buf_size, stats, err)) return false;
+        pos = hole;
+    }
+    return true;
+}
+
+#endif
+
+#ifndef _WIN32
+// ¿Sigue siendo el mismo estado del archivo? Tamaño, mtime y ctime: ctime
+// también delata escrituras que restauran mtime (touch -r, rsync -t...).
+// En los archivos que se reanudan (resume_appends y al menos kResumeMinSize)
+// se tolera que solo haya crecido: se hashea [0, st_size) y en un archivo que
+// solo se amplía ese prefijo es el estado del fstat inicial. En el resto,
+// crecer puede ser un truncado y reescritura a mitad de lectura.
+static bool same_snapshot(const struct stat& a, const struct stat& b, bool allow_growth) {
+    if (allow_growth && b.st_size > a.st_size) return true;
+    return a.st_size == b.st_size && a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec &&
+           a.st_ctim.tv_sec == b.st_ctim.tv_sec && a.st_ctim.tv_nsec == b.st_ctim.tv_nsec;
+}
+#endif
+
+// Pipeline completo de un archivo, instanciado por algoritmo: todo lo que hay
+// por debajo (lecturas, huecos, update) se resuelve en compilación.
+// 'changed' indica que el archivo se modificó mientras se leía: el digest no
+// corresponde a ningún estado real y no se devuelve.
+template <class H>
+static bool hash_file_once(const fs::path& file, const HashOptions& opt, char* buf, size_t buf_size,
+                           std::string& hex, HashStats& stats, std::string& err, bool& changed) {
+    static_assert(is_hash_algorithm<H>::value, "H debe ser un algoritmo de hash_algos.h");
+    PhaseScope phase(Phase::Read); // open, stat y lecturas; el update va en Hash
+    H h;
+    bool have_hex = false; // el backend AF_ALG da el digest ya terminado
+
+#ifndef _WIN32
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        err = std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        err = std::strerror(errno);
+        close(fd);
+        return false;
+    }
+    if (opt.digest_cache && S_ISREG(st.st_mode) && digest_cache_lookup(fd, file, st, opt.algo, hex)) {
+        close(fd);
+        stats.files++;
+        stats.cache_hits++;
+        return true;
+    }
+
+    // Un error de lectura en un archivo que ha cambiado (truncado mientras se
+    // leía) es un cambio: entra en los reintentos de hash_file_impl
+    auto read_failed = [&] {
+        struct stat now;
+        if (S_ISREG(st.st_mode) && fstat(fd, &now) == 0 && !same_snapshot(st, now, false)) {
+            changed = true;
+            err = "modificado durante la lectura";
+        }
+        close(fd);
+        return false;
+    };
+
+    bool done = false;
+#ifdef __linux__
+    if (opt.backend == ReadBackend::AfAlg && S_ISREG(st.st_mode)) {
+        bool unsupported = false;
+        if (hash_afalg<H>(fd, st.st_size, hex, stats, err, unsupported)) {
+            done = have_hex = true;
+        } else if (!unsupported) {
+            return read_failed();
+        } else {
+            err.clear(); // el motivo del intento AF_ALG no es el de la lectura que sigue
+        }
+    }
+#endif
+    bool resumable = opt.resume_appends && S_ISREG(st.st_mode) && st.st_size >= kResumeMinSize;
+    if (!done && resumable) {
+        ResumePoint rp;
+        std::string tail;
+        if (resume_point_lookup(fd, file, st, opt.algo, rp) && rp.offset <= (uint64_t)st.st_size &&
+            tail_window_md5(fd, (off_t)rp.offset, buf, buf_size, tail) && tail == rp.tail &&
+            h.load_state(rp.state) && h.length() == rp.offset) {
+            if (!hash_data(fd, (off_t)rp.offset, st.st_size, opt.backend, h, buf, buf_size, stats, err))
+                return read_failed();
+            stats.bytes_resumed += rp.offset;
+            done = true;
+        } else {
+            h = H{};
+        }
+    }
+    // Solo merece la pena buscar huecos si hay menos bloques asignados que tamaño
+    if (!done && opt.sparse && S_ISREG(st.st_mode) && (off_t)st.st_blocks * 512 < st.st_size) {
+        bool unsupported = false;
+        if (hash_sparse(fd, st.st_size, opt.backend, h, buf, buf_size, stats, err, unsupported)) {
+            done = true;
+        } else if (!unsupported) {
+            return read_failed();
+        } else {
+            err.clear();
+        }
+    }
+    if (!done && opt.backend == ReadBackend::Mmap && S_ISREG(st.st_mode) && st.st_size >= kMmapMinSize) {
+        if (!hash_range_mmap(fd, 0, st.st_size, h, stats, err)) return read_failed();
+        done = true;
+    }
+    if (!done && S_ISREG(st.st_mode)) {
+        // Acotado al tamaño del fstat: lo que se añada durante la lectura no
+        // entra en el digest
+        if (!hash_range(fd, 0, st.st_size, h, buf, buf_size, stats, err)) return read_failed();
+        done = true;
+    }
+    if (!done) {
+        for (;;) {
+            ssize_t n = read(fd, buf, buf_size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                err = std::strerror(errno);
+                close(fd);
+                return false;
+            }
+            if (n == 0) break;
+            {
+                PhaseScope phase(Phase::Hash);
+                h.update(buf, (size_t)n);
+            }
+            stats.bytes_read += (uint64_t)n;
+        }
+    }
+    if (S_ISREG(st.st_mode)) {
+        struct stat after;
+        if (fstat(fd, &after) != 0 || !same_snapshot(st, after, resumable)) {
+            close(fd);
+            changed = true;
+            err = "modificado durante la lectura";
+            return false;
+        }
+    }
+#else
+    std::error_code ec;
+    auto mtime0 = fs::last_write_time(file, ec);
+    auto size0 = fs::file_size(file, ec);
+    std::ifstream ifs(file, std::ios::binary);
+    if (!ifs.is_open()) {
+        err = "no se puede abrir";
+        return false;
+    }
+    while (ifs) {
+        ifs.read(buf, (std::streamsize)buf_size);
+        std::streamsize n = ifs.gcount();
+        if (n <= 0) break;
+        {
+            PhaseScope phase(Phase::Hash);
+            h.update(buf, (size_t)n);
+        }
+        stats.bytes_read += (uint64_t)n;
+    }
+    if (ifs.bad()) {
+        err = "error de lectura";
+        return false;
+    }
+    if (fs::last_write_time(file, ec) != mtime0 || fs::file_size(file, ec) != size0) {
+        changed = true;
+        err = "modificado durante la lectura";
+        return false;
+    }
+#endif
+
+#ifndef _WIN32
+    if (resumable && !have_hex && h.length() >= (uint64_t)kResumeMinSize) {
+        // Punto de reanudación al final de lo hasheado: las lecturas se acotan
+        // a st_size, así que lo añadido durante la lectura queda para la próxima
+        ResumePoint rp;
+        rp.offset = h.length();
+        rp.state = h.save_state();
+        if (tail_window_md5(fd, (off_t)rp.offset, buf, buf_size, rp.tail))
+            resume_point_store(fd, file, st, opt.algo, rp);
+    }
+#endif
+    if (!have_hex) hex = h.hex_final();
+    stats.files++;
+#ifndef _WIN32
+    if (opt.digest_cache && S_ISREG(st.st_mode)) digest_cache_store(fd, file, st, opt.algo, hex);
+    close(fd);
+#endif
+    return true;
+}
+
+// Reintento optimista: un archivo que cambia mientras se lee se vuelve a
+// hashear tras una breve espera; si no se estabiliza se marca como error en
+// vez de devolver un digest que no coincide con ningún estado real.
+template <class H>
+static bool hash_file_impl(const fs::path& file, const HashOptions& opt, char* buf, size_t buf_size,
+                           std::string& hex, HashStats& stats, std::string& err) {
+    for (unsigned attempt = 0;; ++attempt) {
+        bool changed = false;
+        bool ok = hash_file_once<H>(file, opt, buf, buf_size, hex, stats, err, changed);
+        if (!changed) return ok;
+        if (attempt >= opt.change_retries) {
+            stats.unstable++;
+            err += " (" + std::to_string(attempt + 1) + " intentos)";
+            return false;
+        }
+        stats.retries++;
+        err.clear();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20 << std::min(attempt, 5u)));
+    }
+}
+
+// Única frontera con despacho dinámico: una vez por archivo, nunca por bloque
+static bool hash_file_buf(const fs::path& file, const HashOptions& opt, char* buf, size_t buf_size,
+                          std::string& hex, HashStats& stats, std::string& err) {
+    switch (opt.algo) {
+    case HashAlgo::Sha256: return hash_file_impl<Sha256>(file, opt, buf, buf_size, hex, stats, err);
+    case HashAlgo::Md5: break;
+    }
+    return hash_file_impl<Md5>(file, opt, buf, buf_size, hex, stats, err);
+}
+
+bool hash_file(const fs::path& file, const HashOptions& opt, std::string& hex, HashStats& stats, std::string& err) {
+    IoBuffer b = BufferPool::shared().acquire(-1, opt.huge_pages);
+    if (!b.data) {
+        err = "sin memoria para el buffer de lectura";
+        return false;
+    }
+    bool ok = hash_file_buf(file, opt, b.data, b.size, hex, stats, err);
+    BufferPool::shared().release(b);
+    if (opt.digest_cache || opt.resume_appends) digest_cache_flush();
+    return ok;
+}
+
+static std::mutex g_layout_mu;
+static std::string g_layout;
+
+void hash_files(std::vector<HashJob>& jobs, const HashOptions& opt, HashStats& stats) {
+    const NumaTopology& topo = NumaTopology::get();
+    unsigned n = opt.threads ? opt.threads : std::thread::hardware_concurrency();
+    if (n == 0) n = 1;
+    if (n > jobs.size()) n = jobs.size() ? (unsigned)jobs.size() : 1;
+
+    std::atomic<size_t> next{0};
+    std::mutex stats_mu;
+    auto worker = [&](size_t wi) {
+        // Primero se fija el hilo, luego se pide el buffer: así la memoria nueva
+        // se toca (y se asigna) desde una CPU del nodo del worker
+        int node = opt.numa ? topo.node_for_worker(wi) : -1;
+        if (node >= 0) pin_thread_to_node(node);
+        IoBuffer b = BufferPool::shared().acquire(node, opt.huge_pages);
+
+        HashStats local;
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            HashJob& j = jobs[i];
+            if (!b.data) {
+                j.err = "sin memoria para el buffer de lectura";
+                continue;
+            }
+            j.ok = hash_file_buf(j.path, opt, b.data, b.size, j.hex, local, j.err);
+        }
+        BufferPool::shared().release(b);
+        std::lock_guard<std::mutex> lk(stats_mu);
+        stats.add(local);
+    };
+
+    // Siempre en hilos propios, también con n == 1: pin_thread_to_node no
+    // debe cambiar la afinidad del hilo de la GUI
+    std::vector<std::thread> threads;
+    threads.reserve(n);
+    for (unsigned i = 0; i < n; ++i) threads.emplace_back(worker, (size_t)i);
+    for (auto& t : threads) t.join();
+    if (opt.digest_cache || opt.resume_appends) digest_cache_flush();
+
+    std::string layout = std::to_string(n) + " workers";
+    if (opt.numa && !topo.ids.empty()) layout += " en " + std::to_string(topo.nodes()) + " nodo(s) NUMA";
+    layout += "; " + BufferPool::shared().describe();
+    std::lock_guard<std::mutex> lk(g_layout_mu);
+    g_layout = layout;
+}
+
+std::string last_hash_files_layout() {
+    std::lock_guard<std::mutex> lk(g_layout_mu);
+    return g_layout;
+}
+
+HashOptions verify_hash_options(HashOptions opts) {
+    opts.digest_cache = false;
+    opts.resume_appends = false;
+    return opts;
+}
+
+ReadBackend benchmark_backends(const std::vector<fs::path>& files, const HashOptions& opts, std::string& out_log) {
+    const ReadBackend all[] = { ReadBackend::Buffered, ReadBackend::Mmap, ReadBackend::AfAlg };
+    // Con la caché o la reanudación se mediría sobre todo la lectura de
+    // xattrs, no el backend; y de paso se escribirían en los archivos
+    HashOptions base = opts;
+    base.digest_cache = false;
+    base.resume_appends = false;
+    auto run = [&](ReadBackend b, HashStats& st) {
+        std::vector<HashJob> jobs;
+        jobs.reserve(files.size());
+        for (auto& f : files) jobs.push_back(HashJob(f));
+        HashOptions o = base;
+        o.backend = b;
+        auto t0 = std::chrono::steady_clock::now();
+        hash_files(jobs, o, st);
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    };
+
+    // Calentamiento: todos los backends compiten con la page cache caliente
+    HashStats warm;
+    run(ReadBackend::Buffered, warm);
+    out_log += "Benchmark de backends: " + std::to_string(files.size()) + " archivos, " +
+               format_bytes(warm.bytes_read + warm.bytes_hole) + "\n";
+
+    ReadBackend best = ReadBackend::Buffered;
+    double best_secs = 0;
+    for (ReadBackend b : all) {
+        if (!backend_available(b, base.algo)) {
+            out_log += std::string("  ") + backend_name(b) + ": no disponible\n";
+            continue;
+        }
+        HashStats st;
+        double secs = run(b, st);
+        double mbps = secs > 0 ? (double)(st.bytes_read + st.bytes_hole) / (1024.0 * 1024.0) / secs : 0;
+        char line[128];
+        std::snprintf(line, sizeof(line), "  %-9s %8.3f s  %9.1f MiB/s\n", backend_name(b), secs, mbps);
+        out_log += line;
+        if (b == all[0] || secs < best_secs) {
+            best = b;
+            best_secs = secs;
+        }
+    }
+    out_log += std::string("Más rápido: ") + backend_name(best) + "\n";
+    return best;
+}
+
+std::string format_bytes(uint64_t n) {
+    static const char* units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+    double v = (double)n;
+    int u = 0;
+    while (v >= 1024.0 && u < 4) { v /= 1024.0; ++u; }
+    char tmp[32];
+    std::snprintf(tmp, sizeof(tmp), u == 0 ? "%.0f %s" : "%.1f %s", v, units[u]);
+    return tmp;
+}
@@ -0,0 +1,116 @@
+// src/hash_engine.h
+// Motor de hashing en proceso: sustituye las llamadas a md5sum por archivo.
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Algoritmo del digest; cada uno instancia su propio pipeline (hash_algos.h)
+enum class HashAlgo {
+    Md5,    // hashes.md5, compatible con md5sum
+    Sha256,
+};
+
+const char* algo_name(HashAlgo a);
+
+// Cómo llegan los bytes del fichero al digest
+enum class ReadBackend {
+    Buffered, // read()/pread() a un buffer del pool (una copia kernel -> usuario)
+    Mmap,     // mmap del fichero y hash directo sobre la page cache, sin memcpy
+    AfAlg,    // splice de la page cache a un socket AF_ALG: hashea el kernel (Linux)
+};
+
+const char* backend_name(ReadBackend b);
+
+// ¿Puede usarse 'b' con 'a' aquí? (AF_ALG depende del kernel; donde no está,
+// hash_file cae a lectura con buffer)
+bool backend_available(ReadBackend b, HashAlgo a);
+
+struct HashOptions {
+    HashAlgo algo = HashAlgo::Md5;
+    ReadBackend backend = ReadBackend::Buffered;
+    // Detecta huecos con lseek(SEEK_DATA/SEEK_HOLE) y los pasa al digest como
+    // ceros sin leerlos del disco. Sin efecto donde no hay soporte (Windows,
+    // sistemas de ficheros sin huecos).
+    bool sparse = true;
+    // Workers de hash_files (0 = hardware_concurrency)
+    unsigned threads = 0;
+    // Buffers de E/S con MAP_HUGETLB / MADV_HUGEPAGE
+    bool huge_pages = true;
+    // Reparte los workers entre nodos NUMA, cada uno fijado a las CPUs de su
+    // nodo y leyendo en buffers ligados a ese mismo nodo
+    bool numa = true;
+    // Reutiliza el digest guardado en xattrs user.hashnsign.* (o en la caché
+    // central) si tamaño y mtime no han cambiado, sin leer el archivo
+    // (digest_cache.h). Solo al generar: verificar no lo usa.
+    bool digest_cache = false;
+    // Archivos grandes que solo crecen (logs, datasets): guarda el estado
+    // intermedio del digest al final y, la próxima vez, si la ventana final de
+    // ese prefijo no ha cambiado, continúa desde ahí y solo lee lo añadido
+    bool resume_appends = false;
+    // Reintentos si el archivo cambia (tamaño, mtime o ctime) mientras se lee;
+    // agotados, el archivo falla con "modificado durante la lectura"
+    unsigned change_retries = 3;
+};
+
+struct HashStats {
+    uint64_t files = 0;
+    uint64_t bytes_read = 0; // leídos realmente del disco
+    uint64_t bytes_hole = 0; // huecos alimentados como ceros sin leer
+    uint64_t cache_hits = 0; // archivos resueltos desde la caché de digests
+    uint64_t bytes_resumed = 0; // prefijos no releídos gracias a resume_appends
+    uint64_t retries = 0;       // relecturas por modificación concurrente
+    uint64_t unstable = 0;      // archivos que no dejaron de cambiar
+
+    void add(const HashStats& o) {
+        files += o.files;
+        bytes_read += o.bytes_read;
+        bytes_hole += o.bytes_hole;
+        cache_hits += o.cache_hits;
+        bytes_resumed += o.bytes_resumed;
+        retries += o.retries;
+        unstable += o.unstable;
+    }
+};
+
+// Calcula el digest de 'file' en hex (igual que md5sum/sha256sum). Devuelve
+// false y rellena 'err' si no se puede abrir o leer.
+bool hash_file(const fs::path& file, const HashOptions& opt, std::string& hex, HashStats& stats, std::string& err);
+
+// Un archivo a hashear por hash_files; 'hex' o 'err' se rellenan al terminar.
+struct HashJob {
+    HashJob() = default;
+    explicit HashJob(fs::path p) : path(std::move(p)) {}
+
+    fs::path path;
+    std::string hex;
+    std::string err;
+    bool ok = false;
+};
+
+// Hashea todos los trabajos en paralelo con el pool de buffers compartido.
+// El orden de 'jobs' se conserva; 'stats' acumula la E/S de todos los workers.
+void hash_files(std::vector<HashJob>& jobs, const HashOptions& opt, HashStats& stats);
+
+// Descripción del último reparto (workers, nodos, buffers) para el log
+std::string last_hash_files_layout();
+
+// Mide cada backend disponible sobre 'files' (una pasada de calentamiento y
+// luego una cronometrada por backend) y escribe la tabla en out_log. Devuelve
+// el más rápido. La caché de digests y la reanudación se desactivan para
+// medir lecturas de verdad.
+ReadBackend benchmark_backends(const std::vector<fs::path>& files, const HashOptions& opts, std::string& out_log);
+
+// Opciones para verificar: sin caché de digests ni puntos de reanudación.
+// Ambos se fían de metadatos que puede falsear cualquiera con escritura sobre
+// el archivo (un mtime restaurado con touch -r, un xattr user.* plantado), y
+// una verificación tiene que leer el contenido.
+HashOptions verify_hash_options(HashOptions opts);
+
+// "12.3 MiB" para los resúmenes del log
+std::string format_bytes(uint64_t n);
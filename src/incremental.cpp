@@ -0,0 +1,214 @@
+// src/incremental.cpp
+
+#include "incremental.h"
+#include "manifest.h"
+#include "manifest_ref.h"
+#include "perf_counters.h"
+#include "process.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <unordered_map>
+
+const char* oracle_name(ChangeOracle o) {
+    switch (o) {
+    case ChangeOracle::None: return "completo";
+    case ChangeOracle::GitDiff: return "git diff";
+    case ChangeOracle::Fsmonitor: return "fsmonitor";
+    }
+    return "?";
+}
+
+// Salida de "git ... -z": rutas separadas por NUL
+static void split_nul(const std::string& out, std::vector<std::string>& paths) {
+    size_t pos = 0;
+    while (pos < out.size()) {
+        size_t end = out.find('\0', pos);
+        if (end == std::string::npos) end = out.size();
+        if (end > pos) paths.push_back(out.substr(pos, end - pos));
+        pos = end + 1;
+    }
+}
+
+ChangedPathFilter::ChangedPathFilter(const ChangeSet& cs) {
+    for (auto p : cs.paths) {
+        while (!p.empty() && p.back() == '/') p.pop_back();
+        if (!p.empty()) sorted_.push_back("./" + p);
+    }
+    std::sort(sorted_.begin(), sorted_.end());
+    sorted_.erase(std::unique(sorted_.begin(), sorted_.end()), sorted_.end());
+}
+
+bool ChangedPathFilter::covers(const std::string& manifest_path) const {
+    // La ruta y cada uno de sus directorios padre
+    std::string p = manifest_path;
+    for (;;) {
+        if (std::binary_search(sorted_.begin(), sorted_.end(), p)) return true;
+        size_t slash = p.rfind('/');
+        if (slash == std::string::npos || slash <= 1) return false; // llegó a "."
+        p.resize(slash);
+    }
+}
+
+fs::path state_dir(const fs::path& repo) {
+    // En un worktree enlazado o un submódulo .git es un archivo: git sabe
+    // dónde está el directorio de verdad
+    std::string p = git_line(repo, "rev-parse --git-path hashnsign 2>/dev/null");
+    if (p.empty()) return {};
+    return fs::path(p).is_absolute() ? fs::path(p) : repo / p;
+}
+
+void record_dirty_paths(const fs::path& repo) {
+    fs::path dir = state_dir(repo);
+    if (dir.empty()) return;
+    auto [rc, out] = run_command_stdout("git -C " + shell_quote(repo.string()) +
+                                        " status --porcelain -z --no-renames --untracked-files=no");
+    if (rc != 0) return;
+    // Cada registro es "XY ruta"
+    std::string paths;
+    std::vector<std::string> recs;
+    split_nul(out, recs);
+    for (auto& r : recs) {
+        if (r.size() > 3) {
+            paths += r.substr(3);
+            paths += '\0';
+        }
+    }
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    std::ofstream ofs(dir / "dirty", std::ios::binary | std::ios::trunc);
+    ofs << paths;
+}
+
+bool git_changed_paths(const fs::path& repo, ChangeSet& cs, std::string& out_log) {
+    std::string git = "git -C " + shell_quote(repo.string()) + " ";
+    cs.oracle = ChangeOracle::GitDiff;
+
+    // El manifiesto de trabajo debe ser el guardado en ese commit; si no, el
+    // diff no lo describe
+    std::string blob;
+    if (manifest_ref_source(repo, cs.base, blob)) {
+        // Guardado en refs/hashnsign/manifest: la ref anota de qué commit salió
+        auto [rc_h, cur] = run_command_stdout(git + "hash-object -- hashes.md5");
+        if (rc_h != 0 || trim(cur) != blob) {
+            out_log += "Incremental: hashes.md5 no es el de " + std::string(kManifestRef) + "\n";
+            return false;
+        }
+    } else {
+        auto [rc, out] = run_command_stdout(git + "log -1 --format=%H -- hashes.md5");
+        cs.base = trim(out);
+        if (rc != 0 || cs.base.empty()) {
+            out_log += "Incremental: hashes.md5 no tiene commit previo en " + repo.string() + "\n";
+            return false;
+        }
+        auto [rc_q, out_q] = run_command_stdout(git + "diff --quiet " + cs.base + " -- hashes.md5");
+        if (rc_q != 0) {
+            out_log += "Incremental: hashes.md5 ha cambiado desde " + cs.base.substr(0, 12) + "\n";
+            return false;
+        }
+    }
+
+    auto [rc_d, diff] = run_command_stdout(git + "diff --name-only -z --no-renames " + cs.base);
+    if (rc_d != 0) {
+        out_log += "Incremental: git diff falló en " + repo.string() + "\n";
+        return false;
+    }
+    auto [rc_o, others] = run_command_stdout(git + "ls-files -z --others");
+    if (rc_o != 0) {
+        out_log += "Incremental: git ls-files falló en " + repo.string() + "\n";
+        return false;
+    }
+    split_nul(diff, cs.paths);
+    split_nul(others, cs.paths);
+
+    // Sin el registro de lo que estaba sucio al hashear, un archivo revertido
+    // después no sale en el diff y su digest viejo se quedaría
+    fs::path dir = state_dir(repo);
+    if (dir.empty()) {
+        out_log += "Incremental: no hay directorio de estado en " + repo.string() + "\n";
+        return false;
+    }
+    std::ifstream ifs(dir / "dirty", std::ios::binary);
+    if (ifs.is_open()) {
+        std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        split_nul(data, cs.paths);
+    }
+    return true;
+}
+
+bool patch_manifest(const fs::path& repo, const ChangeSet& cs, const HashOptions& opts, HashStats& stats,
+                    std::string& out_log) {
+    fs::path hashes = repo / "hashes.md5";
+    std::vector<ManifestEntry> entries;
+    if (!read_manifest(hashes, entries, out_log)) return false;
+
+    std::unordered_map<std::string, size_t> index;
+    for (size_t i = 0; i < entries.size(); ++i) index[entries[i].path] = i;
+
+    std::set<std::string> to_hash;     // "./rel"
+    for (auto& rel0 : cs.paths) {
+        std::string rel = rel0;
+        while (!rel.empty() && rel.back() == '/') rel.pop_back();
+        if (rel.empty() || manifest_excludes(rel)) continue;
+        fs::path full = repo / fs::path(rel);
+        std::error_code ec;
+        if (fs::is_regular_file(full, ec)) {
+            to_hash.insert("./" + rel);
+        } else if (fs::is_directory(full, ec)) {
+            // Submódulos o eventos de directorio: se rehashea entero
+            PhaseScope phase(Phase::Walk);
+            for (auto& p : fs::recursive_directory_iterator(full, ec)) {
+                if (!p.is_regular_file()) continue;
+                std::string srel = fs::relative(p.path(), repo).string();
+                if (!manifest_excludes(srel)) to_hash.insert("./" + srel);
+            }
+        }
+    }
+    // Lo cubierto por el cambio que ya no existe como archivo se borra: rutas
+    // borradas y todo lo que colgaba de un directorio borrado o rehasheado
+    ChangedPathFilter filter(cs);
+    std::set<std::string> removed;     // "./rel"
+    for (auto& e : entries) {
+        if (filter.covers(e.path) && !to_hash.count(e.path)) removed.insert(e.path);
+    }
+
+    std::vector<HashJob> jobs;
+    std::vector<std::string> rels;
+    for (auto& r : to_hash) {
+        jobs.push_back(HashJob(repo / r));
+        rels.push_back(r);
+    }
+    hash_files(jobs, opts, stats);
+
+    size_t updated = 0, added = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (!jobs[i].ok) {
+            out_log += "md5 fallo para " + jobs[i].path.string() + " : " + jobs[i].err + "\n";
+            return false;
+        }
+        auto it = index.find(rels[i]);
+        if (it != index.end()) {
+            if (entries[it->second].digest != jobs[i].hex) ++updated;
+            entries[it->second].digest = jobs[i].hex;
+        } else {
+            index[rels[i]] = entries.size();
+            entries.push_back(ManifestEntry{jobs[i].hex, rels[i]});
+            ++added;
+        }
+    }
+
+    size_t before = entries.size();
+    std::vector<ManifestEntry> kept;
+    kept.reserve(entries.size());
+    for (auto& e : entries)
+        if (!removed.count(e.path)) kept.push_back(std::move(e));
+
+    if (!write_manifest(hashes, kept, out_log)) return false;
+    out_log += "Incremental (" + std::string(oracle_name(cs.oracle)) + " desde " + cs.base.substr(0, 12) +
+               "): " + std::to_string(cs.paths.size()) + " rutas candidatas, " + std::to_string(updated) +
+               " modificadas, " + std::to_string(added) + " nuevas, " + std::to_string(before - kept.size()) +
+               " borradas\n";
+    return true;
+}
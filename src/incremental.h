@@ -0,0 +1,64 @@
+// src/incremental.h
+// Regeneración incremental de hashes.md5: en vez de rehashear todo el árbol se
+// pregunta qué rutas pueden haber cambiado y se parchea el manifiesto anterior.
+
+#pragma once
+
+#include "hash_engine.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// De dónde sale la lista de rutas cambiadas
+enum class ChangeOracle {
+    None,    // recorrido completo (comportamiento original)
+    GitDiff, // git diff desde el último commit que tocó hashes.md5 (o el anotado en refs/hashnsign/manifest)
+    Fsmonitor, // git fsmonitor--daemon o Watchman, desde el token guardado (fsmonitor.h)
+};
+
+const char* oracle_name(ChangeOracle o);
+
+struct ChangeSet {
+    ChangeOracle oracle = ChangeOracle::None;
+    std::string base;               // commit (o token) de referencia, para el log
+    std::string next_token;         // token del daemon en el momento de la consulta
+    std::vector<std::string> paths; // rutas relativas al repo, separadas por '/'
+};
+
+// ¿Puede haber cambiado la entrada "./ruta" según 'cs'? Cubre tanto la ruta
+// exacta como cualquier directorio padre listado (los daemons a veces solo
+// informan del directorio, p.ej. al borrarlo entero).
+class ChangedPathFilter {
+public:
+    explicit ChangedPathFilter(const ChangeSet& cs);
+    bool covers(const std::string& manifest_path) const;
+
+private:
+    std::vector<std::string> sorted_; // "./ruta" ordenadas para búsqueda binaria
+};
+
+// Directorio de estado local del repo (<git-dir>/hashnsign, también en
+// worktrees y submódulos): nunca se versiona ni entra en el manifiesto. Vacío
+// si no es un repo git.
+fs::path state_dir(const fs::path& repo);
+
+// Rutas que pueden diferir del hashes.md5 guardado en el último commit que lo
+// tocó: lo que git diff ve entre ese commit y el árbol de trabajo, más los
+// archivos no versionados (git no sabe si cambiaron, se rehashean siempre) y
+// los que estaban sucios al generar (record_dirty_paths).
+// Devuelve false si no hay base fiable (sin commit previo, manifiesto editado
+// desde entonces, git falla): el llamante debe hacer el recorrido completo.
+bool git_changed_paths(const fs::path& repo, ChangeSet& cs, std::string& out_log);
+
+// Guarda las rutas versionadas con cambios sin commitear en el momento de
+// generar: el manifiesto las refleja, pero "git diff <base>" no las verá si
+// luego se revierten. git_changed_paths las añade en la siguiente pasada.
+void record_dirty_paths(const fs::path& repo);
+
+// Parchea hashes.md5 en sitio: rehashea solo las rutas de 'cs' que existen,
+// quita las borradas y añade las nuevas al final. El resto de líneas no se toca.
+bool patch_manifest(const fs::path& repo, const ChangeSet& cs, const HashOptions& opts, HashStats& stats,
+                    std::string& out_log);
@@ -0,0 +1,447 @@
+// src/log_search.cpp
+#include "log_search.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+constexpr uint64_t kBatchLines = 1 << 16; // líneas que se fusionan de una vez
+constexpr size_t kTrigramBits = size_t(1) << 24;
+
+char lower(char c) { return c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c; }
+
+uint32_t trigram(const char* p) {
+    return (uint32_t)(uint8_t)lower(p[0]) << 16 | (uint32_t)(uint8_t)lower(p[1]) << 8 | (uint8_t)lower(p[2]);
+}
+
+bool ends_with(std::string_view s, std::string_view suf) {
+    return s.size() >= suf.size() && s.compare(s.size() - suf.size(), suf.size(), suf) == 0;
+}
+
+bool starts_with(std::string_view s, std::string_view pre) { return s.compare(0, pre.size(), pre) == 0; }
+
+// Estado de una línea y, en las de archivo ("<ruta>: OK"), dónde acaba la ruta
+LineStatus classify(std::string_view t, size_t& path_end) {
+    path_end = std::string_view::npos;
+    if (ends_with(t, ": OK")) {
+        path_end = t.size() - 4;
+        return LineStatus::Ok;
+    }
+    if (ends_with(t, ": FAILED")) {
+        path_end = t.size() - 8;
+        return LineStatus::Failed;
+    }
+    // Con la vía entre paréntesis: "./ruta: OK (fs-verity)"
+    if (!t.empty() && t.back() == ')') {
+        size_t ok = t.rfind(": OK ("), bad = t.rfind(": FAILED (");
+        if (ok != std::string_view::npos && (bad == std::string_view::npos || ok > bad)) {
+            path_end = ok;
+            return LineStatus::Ok;
+        }
+        if (bad != std::string_view::npos) {
+            path_end = bad;
+            return LineStatus::Failed;
+        }
+    }
+    if (ends_with(t, ": NO APROBADO")) {
+        path_end = t.size() - 13;
+        return LineStatus::NotApproved;
+    }
+    size_t p = t.find(": FAILED open or read");
+    if (p != std::string_view::npos) {
+        path_end = p;
+        return LineStatus::Unreadable;
+    }
+    if (starts_with(t, "Error") || starts_with(t, "ERROR")) return LineStatus::Error;
+    if ((starts_with(t, "Resultado") && t.find("FAIL") != std::string_view::npos) ||
+        starts_with(t, "Integridad FALLIDA"))
+        return LineStatus::Failed;
+    return LineStatus::Other;
+}
+
+// Ruta de una línea de archivo, sin el "./" de los logs de verificación
+std::string_view line_path(std::string_view t) {
+    size_t end;
+    classify(t, end);
+    if (end == std::string_view::npos) return {};
+    std::string_view p = t.substr(0, end);
+    if (starts_with(p, "./")) p.remove_prefix(2);
+    return p;
+}
+
+// '*' = cualquier secuencia, '?' = un carácter
+bool glob_match(std::string_view pat, std::string_view s) {
+    // Lo más habitual, "*.ext", "dir/*" o "dir/*.ext", sin recorrer carácter a carácter
+    size_t star = pat.find('*');
+    if (pat.find('?') == std::string_view::npos && pat.find('*', star + 1) == std::string_view::npos) {
+        if (star == std::string_view::npos) return pat == s;
+        std::string_view pre = pat.substr(0, star), suf = pat.substr(star + 1);
+        return s.size() >= pre.size() + suf.size() && starts_with(s, pre) && ends_with(s, suf);
+    }
+    size_t pi = 0, si = 0, mark = 0;
+    star = std::string_view::npos;
+    while (si < s.size()) {
+        if (pi < pat.size() && (pat[pi] == '?' || pat[pi] == s[si])) {
+            ++pi;
+            ++si;
+        } else if (pi < pat.size() && pat[pi] == '*') {
+            star = pi++;
+            mark = si;
+        } else if (star != std::string_view::npos) {
+            pi = star + 1;
+            si = ++mark;
+        } else {
+            return false;
+        }
+    }
+    while (pi < pat.size() && pat[pi] == '*') ++pi;
+    return pi == pat.size();
+}
+
+void add_trigrams(std::string_view s, std::vector<uint32_t>& out) {
+    for (size_t i = 0; i + 3 <= s.size(); ++i) out.push_back(trigram(s.data() + i));
+}
+
+} // namespace
+
+LineStatus classify_log_line(std::string_view text, std::string_view& path) {
+    size_t end;
+    LineStatus st = classify(text, end);
+    path = end == std::string_view::npos ? std::string_view() : text.substr(0, end);
+    return st;
+}
+
+const char* line_status_name(LineStatus s) {
+    switch (s) {
+    case LineStatus::Ok: return "OK";
+    case LineStatus::Failed: return "FAILED";
+    case LineStatus::Unreadable: return "ILEGIBLE";
+    case LineStatus::NotApproved: return "NO APROBADO";
+    case LineStatus::Error: return "ERROR";
+    default: return "OTRO";
+    }
+}
+
+bool parse_line_status(const std::string& name, LineStatus& out) {
+    std::string n;
+    for (char c : name) n += c == '-' || c == '_' ? ' ' : lower(c);
+    for (int s = (int)LineStatus::Other; s <= (int)LineStatus::Error; ++s) {
+        std::string candidate;
+        for (const char* p = line_status_name((LineStatus)s); *p; ++p) candidate += lower(*p);
+        if (candidate == n) {
+            out = (LineStatus)s;
+            return true;
+        }
+    }
+    return false;
+}
+
+void LogIndex::start(const MappedLog* log) {
+    stop();
+    log_ = log;
+    indexed_.store(0);
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        status_.clear();
+        repo_.clear();
+        repos_.clear();
+        postings_.clear();
+    }
+    repo_ids_.clear();
+    current_repo_ = 0;
+    block_ = 0;
+    block_tri_.clear();
+    published_.clear();
+    status_batch_.clear();
+    repo_batch_.clear();
+    seen_.assign(kTrigramBits / 64, 0);
+    if (!log_ || !log_->is_open()) return;
+    stop_.store(false);
+    done_.store(false);
+    builder_ = std::thread([this] { build(); });
+}
+
+void LogIndex::stop() {
+    stop_.store(true);
+    if (builder_.joinable()) builder_.join();
+    done_.store(true);
+}
+
+uint32_t LogIndex::repo_id(std::string_view name) {
+    std::string key(name);
+    auto it = repo_ids_.find(key);
+    if (it != repo_ids_.end()) return it->second;
+    std::lock_guard<std::mutex> lk(mu_);
+    repos_.push_back(key);
+    uint32_t id = (uint32_t)repos_.size();
+    repo_ids_.emplace(std::move(key), id);
+    return id;
+}
+
+// Cierra el bloque en curso: sus trigramas pasan a las listas y el bitmap
+// queda limpio para el siguiente
+void LogIndex::end_block() {
+    std::sort(block_tri_.begin(), block_tri_.end());
+    std::lock_guard<std::mutex> lk(mu_);
+    for (uint32_t t : block_tri_) {
+        postings_[t].push_back((uint32_t)block_);
+        seen_[t >> 6] &= ~(uint64_t(1) << (t & 63));
+    }
+    for (uint32_t t : published_) seen_[t >> 6] &= ~(uint64_t(1) << (t & 63));
+    block_tri_.clear();
+    published_.clear();
+}
+
+void LogIndex::add_line(uint64_t i, std::string_view t) {
+    if (i / kBlockLines != block_) {
+        end_block();
+        block_ = i / kBlockLines;
+    }
+    for (size_t k = 0; k + 3 <= t.size(); ++k) {
+        uint32_t tri = trigram(t.data() + k);
+        uint64_t bit = uint64_t(1) << (tri & 63);
+        if (!(seen_[tri >> 6] & bit)) {
+            seen_[tri >> 6] |= bit;
+            block_tri_.push_back(tri);
+        }
+    }
+
+    size_t path_end;
+    LineStatus st = classify(t, path_end);
+    uint32_t repo = current_repo_;
+    if (starts_with(t, "=== ")) {
+        current_repo_ = repo = 0;
+    } else if (starts_with(t, "Verificando: ") || starts_with(t, "Procesando: ")) {
+        current_repo_ = repo = repo_id(t.substr(t.find(": ") + 2));
+    } else if (starts_with(t, "Resultado ")) {
+        // verificación multiproceso: "Resultado <repo>: firma=..."
+        size_t colon = t.find(": ");
+        if (colon != std::string_view::npos) repo = repo_id(t.substr(10, colon - 10));
+    }
+    status_batch_.push_back((uint8_t)st);
+    repo_batch_.push_back(repo);
+}
+
+void LogIndex::build() {
+    uint64_t next = 0;
+    while (!stop_.load()) {
+        bool log_done = !log_->indexing(); // antes de lines(): así lines() ya es la final
+        uint64_t n = log_->lines();
+        if (next >= n) {
+            if (log_done) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+        }
+        uint64_t last = std::min(n, next + kBatchLines);
+        log_->for_each_line(next, last, [&](uint64_t i, std::string_view t) {
+            add_line(i, t);
+            return true;
+        });
+        {
+            // Los trigramas del bloque a medias se publican ya; el bitmap sigue
+            // marcándolos para no repetirlos cuando el bloque se complete
+            std::sort(block_tri_.begin(), block_tri_.end());
+            std::lock_guard<std::mutex> lk(mu_);
+            for (uint32_t t : block_tri_) postings_[t].push_back((uint32_t)block_);
+            published_.insert(published_.end(), block_tri_.begin(), block_tri_.end());
+            block_tri_.clear();
+            status_.insert(status_.end(), status_batch_.begin(), status_batch_.end());
+            repo_.insert(repo_.end(), repo_batch_.begin(), repo_batch_.end());
+        }
+        status_batch_.clear();
+        repo_batch_.clear();
+        next = last;
+        indexed_.store(next, std::memory_order_release);
+    }
+    done_.store(true, std::memory_order_release);
+}
+
+bool LogIndex::search(const LogQuery& q, size_t max_lines, LogHits& out) const {
+    auto t0 = std::chrono::steady_clock::now();
+    out = LogHits{};
+    std::lock_guard<std::mutex> lk(mu_);
+    uint64_t n = status_.size();
+    out.searched = n;
+
+    std::string text;
+    for (char c : q.text) text += lower(c);
+    std::vector<uint32_t> tris;
+    add_trigrams(text, tris);
+    size_t seg = 0;
+    for (size_t i = 0; i <= q.path_glob.size(); ++i) {
+        if (i == q.path_glob.size() || q.path_glob[i] == '*' || q.path_glob[i] == '?') {
+            add_trigrams(std::string_view(q.path_glob).substr(seg, i - seg), tris);
+            seg = i + 1;
+        }
+    }
+    std::sort(tris.begin(), tris.end());
+    tris.erase(std::unique(tris.begin(), tris.end()), tris.end());
+
+    // Bloques candidatos: intersección de las listas, de la más corta a la
+    // más larga
+    uint64_t blocks = (n + kBlockLines - 1) / kBlockLines;
+    std::vector<uint32_t> cand;
+    bool all_blocks = tris.empty();
+    if (!all_blocks) {
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (uint32_t t : tris) {
+            auto it = postings_.find(t);
+            if (it == postings_.end()) {
+                lists.clear();
+                break;
+            }
+            lists.push_back(&it->second);
+        }
+        if (!lists.empty()) {
+            std::sort(lists.begin(), lists.end(), [](auto* a, auto* b) { return a->size() < b->size(); });
+            cand = *lists[0];
+            std::vector<uint32_t> tmp;
+            for (size_t k = 1; k < lists.size() && !cand.empty(); ++k) {
+                tmp.clear();
+                std::set_intersection(cand.begin(), cand.end(), lists[k]->begin(), lists[k]->end(),
+                                      std::back_inserter(tmp));
+                cand.swap(tmp);
+            }
+        }
+    }
+
+    // Repos cuyo nombre contiene el filtro; las líneas sin repo (las de la
+    // verificación multiproceso llevan el repo en la ruta) se miran en el texto
+    std::vector<uint8_t> repo_ok(repos_.size() + 1, q.repo.empty() ? 1 : 0);
+    if (!q.repo.empty())
+        for (size_t r = 0; r < repos_.size(); ++r)
+            if (repos_[r].find(q.repo) != std::string::npos) repo_ok[r + 1] = 1;
+    bool need_text = !text.empty() || !q.path_glob.empty();
+
+    auto columns_ok = [&](uint64_t i) {
+        if (q.status >= 0 && status_[i] != (uint8_t)q.status) return false;
+        return repo_ok[repo_[i]] || (repo_[i] == 0 && status_[i] != (uint8_t)LineStatus::Other);
+    };
+
+    struct Part {
+        std::vector<uint64_t> lines;
+        uint64_t total = 0;
+    };
+    auto scan = [&](const uint32_t* first, const uint32_t* last, Part& part) {
+        auto hit = [&](uint64_t i) {
+            if (part.lines.size() < max_lines) part.lines.push_back(i);
+            ++part.total;
+        };
+        std::string low;
+        for (const uint32_t* b = first; b != last; ++b) {
+            uint64_t lo = *b * kBlockLines, hi = std::min(n, lo + kBlockLines);
+            if (lo >= hi) continue;
+            // Primero las columnas: sin texto que mirar, ni se lee el log
+            bool any = false, any_text = need_text;
+            for (uint64_t i = lo; i < hi; ++i) {
+                if (!columns_ok(i)) continue;
+                any = true;
+                if (!repo_ok[repo_[i]]) any_text = true;
+                else if (!need_text) hit(i);
+            }
+            if (!any || !any_text) continue;
+
+            // El bloque entero se pasa a minúsculas una vez y el texto se busca
+            // de una pasada; cada línea solo comprueba si le cae una aparición
+            const char* base = log_->line(lo).data();
+            size_t pos = 0;
+            if (!text.empty()) {
+                // el final del bloque es el principio del siguiente, que está
+                // en un punto de control del MappedLog
+                std::string_view tail = log_->line(hi < n ? hi : hi - 1);
+                const char* end = hi < n ? tail.data() : tail.data() + tail.size();
+                low.assign(base, (size_t)(end - base));
+                for (char& c : low) c = lower(c);
+                pos = low.find(text);
+                if (pos == std::string::npos) continue;
+            }
+            log_->for_each_line(lo, hi, [&](uint64_t i, std::string_view t) {
+                if (!text.empty()) {
+                    size_t off = (size_t)(t.data() - base);
+                    if (pos < off) pos = low.find(text, off);
+                    if (pos == std::string::npos) return false;
+                    if (pos + text.size() > off + t.size()) return true;
+                }
+                if (!columns_ok(i)) return true;
+                std::string_view path;
+                if (!q.path_glob.empty() || !repo_ok[repo_[i]]) path = line_path(t);
+                if (!repo_ok[repo_[i]]) {
+                    if (path.find(q.repo) == std::string_view::npos) return true;
+                } else if (!need_text) {
+                    return true; // ya contada arriba
+                }
+                if (!q.path_glob.empty() && !glob_match(q.path_glob, path)) return true;
+                hit(i);
+                return true;
+            });
+        }
+    };
+
+    if (all_blocks) {
+        cand.resize(blocks);
+        for (uint64_t b = 0; b < blocks; ++b) cand[b] = (uint32_t)b;
+    }
+    // Mirar el texto es lo caro: los bloques se reparten en tramos seguidos
+    // entre varios hilos y los resultados se juntan en orden
+    unsigned threads = 1;
+    if (need_text) {
+        unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        threads = (unsigned)std::min<size_t>(hw, cand.size() / 64 + 1);
+    }
+    std::vector<Part> parts(threads);
+    if (threads == 1) {
+        scan(cand.data(), cand.data() + cand.size(), parts[0]);
+    } else {
+        std::vector<std::thread> pool;
+        size_t per = (cand.size() + threads - 1) / threads;
+        for (unsigned k = 0; k < threads; ++k) {
+            size_t a = std::min(cand.size(), k * per), e = std::min(cand.size(), a + per);
+            pool.emplace_back(scan, cand.data() + a, cand.data() + e, std::ref(parts[k]));
+        }
+        for (auto& t : pool) t.join();
+    }
+    for (auto& part : parts) {
+        out.total += part.total;
+        for (uint64_t ln : part.lines) {
+            if (out.lines.size() >= max_lines) break;
+            out.lines.push_back(ln);
+        }
+    }
+    out.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return true;
+}
+
+uint64_t LogIndex::memory_bytes() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    uint64_t n = status_.capacity() + repo_.capacity() * sizeof(uint32_t) + seen_.capacity() * sizeof(uint64_t);
+    n += postings_.bucket_count() * sizeof(void*);
+    for (auto& kv : postings_) n += sizeof(kv) + 2 * sizeof(void*) + kv.second.capacity() * sizeof(uint32_t);
+    return n;
+}
+
+bool search_log_file(const fs::path& file, const LogQuery& q, size_t max_lines, std::string& out_log) {
+    MappedLog log;
+    if (!log.open(file, out_log)) return false;
+    auto t0 = std::chrono::steady_clock::now();
+    LogIndex index;
+    index.start(&log);
+    while (index.indexing()) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    double build_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    LogHits hits;
+    index.search(q, max_lines, hits);
+    for (uint64_t ln : hits.lines) {
+        out_log += std::to_string(ln + 1) + ": ";
+        out_log += log.line(ln);
+        out_log += "\n";
+    }
+    char buf[256];
+    std::snprintf(buf, sizeof(buf), "%llu coincidencias de %llu líneas (índice %.2f s, búsqueda %.1f ms)%s\n",
+                  (unsigned long long)hits.total, (unsigned long long)hits.searched, build_s, hits.ms,
+                  hits.total > hits.lines.size() ? ", se muestran las primeras" : "");
+    out_log += buf;
+    index.stop();
+    return true;
+}
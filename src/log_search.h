@@ -0,0 +1,106 @@
+// src/log_search.h
+// Búsqueda y filtros sobre los logs del historial (MappedLog): por repo,
+// estado (OK, FAILED, ...), glob de ruta y texto libre.
+//
+// LogIndex construye en un hilo aparte, a la par que el índice de líneas del
+// MappedLog, dos estructuras:
+//  - columnas de 1 byte de estado y 4 bytes de repo por línea: los filtros
+//    de estado y repo recorren arrays contiguos sin tocar el texto;
+//  - un índice de trigramas (en minúsculas) por bloques de kBlockLines
+//    líneas: el texto y los trozos literales del glob se resuelven cruzando
+//    las listas de bloques de sus trigramas, y solo esos bloques se leen.
+// Las búsquedas ven lo ya indexado y se pueden repetir mientras crece.
+
+#pragma once
+
+#include "run_log.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class LineStatus : uint8_t { Other, Ok, Failed, Unreadable, NotApproved, Error };
+
+const char* line_status_name(LineStatus s);
+// "OK", "FAILED", ... (sin distinguir mayúsculas); false si no es ninguno
+bool parse_line_status(const std::string& name, LineStatus& out);
+
+// Estado de una línea de log y, en las de archivo ("./ruta: OK",
+// "<repo>/ruta: FAILED"...), la ruta tal cual (vacía en las demás)
+LineStatus classify_log_line(std::string_view text, std::string_view& path);
+
+struct LogQuery {
+    std::string repo;      // subcadena del repo (vacío = cualquiera)
+    int status = -1;       // LineStatus, o -1 = cualquiera
+    std::string path_glob; // '*' y '?' sobre la ruta de la línea (vacío = cualquiera)
+    std::string text;      // subcadena de la línea, sin distinguir mayúsculas
+
+    bool empty() const { return repo.empty() && status < 0 && path_glob.empty() && text.empty(); }
+};
+
+struct LogHits {
+    std::vector<uint64_t> lines; // como mucho max_lines, en orden
+    uint64_t total = 0;          // todas las coincidencias
+    uint64_t searched = 0;       // líneas indexadas cuando se buscó
+    double ms = 0;
+};
+
+class LogIndex {
+public:
+    static constexpr uint64_t kBlockLines = 256;
+
+    LogIndex() = default;
+    ~LogIndex() { stop(); }
+    LogIndex(const LogIndex&) = delete;
+    LogIndex& operator=(const LogIndex&) = delete;
+
+    // Empieza a indexar 'log' (abierto); sigue sus líneas mientras se indexa.
+    // Hay que llamar a stop() antes de cerrar o reabrir el log.
+    void start(const MappedLog* log);
+    void stop();
+
+    uint64_t lines() const { return indexed_.load(std::memory_order_acquire); }
+    bool indexing() const { return !done_.load(std::memory_order_acquire); }
+
+    bool search(const LogQuery& q, size_t max_lines, LogHits& out) const;
+
+    // Memoria de las columnas y del índice de trigramas (aproximada)
+    uint64_t memory_bytes() const;
+
+private:
+    void build();
+    void add_line(uint64_t i, std::string_view text);
+    void end_block();
+    uint32_t repo_id(std::string_view name);
+
+    const MappedLog* log_ = nullptr;
+    std::thread builder_;
+    std::atomic<bool> stop_{ false };
+    std::atomic<bool> done_{ true };
+    std::atomic<uint64_t> indexed_{ 0 };
+
+    mutable std::mutex mu_; // protege lo de abajo frente a search()
+    std::vector<uint8_t> status_;
+    std::vector<uint32_t> repo_; // 0 = sin repo; i = repos_[i - 1]
+    std::vector<std::string> repos_;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings_; // trigrama -> bloques
+
+    // Solo del hilo que construye
+    std::unordered_map<std::string, uint32_t> repo_ids_;
+    uint32_t current_repo_ = 0;
+    std::vector<uint64_t> seen_;      // bitmap de trigramas del bloque en curso
+    std::vector<uint32_t> block_tri_; // trigramas del bloque en curso aún sin publicar
+    std::vector<uint32_t> published_; // los ya publicados (para limpiar el bitmap)
+    std::vector<uint8_t> status_batch_;
+    std::vector<uint32_t> repo_batch_;
+    uint64_t block_ = 0;
+};
+
+// Consola: indexa 'file' entero, busca y escribe en out_log las líneas que
+// coinciden ("<n>: <texto>") y el resumen
+bool search_log_file(const fs::path& file, const LogQuery& q, size_t max_lines, std::string& out_log);
@@ -10,8 +10,11 @@
 #include <SDL.h>
 #include <SDL_opengl.h>
 
+#include <cfloat>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <sstream>
@@ -20,87 +23,125 @@
 #include <fstream>
 #include <memory>
 #include <array>
+#include <algorithm>
+
+#include "allowlist.h"
+#include "buffer_pool.h"
+#include "dup_report.h"
+#include "fleet.h"
+#include "fsmonitor.h"
+#include "hash_engine.h"
+#include "incremental.h"
+#include "log_search.h"
+#include "manifest.h"
+#include "manifest_ref.h"
+#include "manifest_tree.h"
+#include "mem_stats.h"
+#include "minisign.h"
+#include "perf_counters.h"
+#include "process.h"
+#include "run_log.h"
+#include "shard_verify.h"
+#include "translog.h"
+#include "tree_sign.h"
+#include "ui_profiler.h"
+#include "verity.h"
 
 namespace fs = std::filesystem;
 
-// Ejecuta un comando y captura stdout+stderr (retorna pair: exit_code, output)
-static std::pair<int,std::string> run_command_capture(const std::string& cmd) {
-    std::array<char, 256> buffer;
-    std::string result;
+// Resumen de E/S de una pasada del motor de hashing
+static std::string stats_summary(const HashStats& st) {
+    std::string s = std::to_string(st.files) + " archivos, leídos " + format_bytes(st.bytes_read) +
+                    ", huecos sin leer " + format_bytes(st.bytes_hole);
+    if (st.cache_hits) s += ", " + std::to_string(st.cache_hits) + " desde caché";
+    if (st.bytes_resumed) s += ", " + format_bytes(st.bytes_resumed) + " reanudados sin releer";
+    if (st.retries) s += ", " + std::to_string(st.retries) + " relecturas por cambios concurrentes";
+    if (st.unstable) s += ", " + std::to_string(st.unstable) + " archivos inestables";
+    return s;
+}
 
-#ifdef _WIN32
-    // On Windows, use "bash -lc" if user wants to run in Git Bash environment:
-    // But here we call popen directly; user must ensure md5sum/gpg are in PATH for the process.
-    FILE* pipe = _popen((cmd + " 2>&1").c_str(), "r");
-#else
-    FILE* pipe = popen((cmd + " 2>&1").c_str(), "r");
-#endif
-    if (!pipe) return { -1, "popen failed" };
-    while (fgets(buffer.data(), (int)buffer.size(), pipe) != nullptr) {
-        result += buffer.data();
+// Archivos a hashear de 'repo' (recursivo, excluyendo .git y los hashes previos),
+// con su ruta relativa en 'rels'
+static void collect_repo_files(const fs::path& repo, std::vector<HashJob>& jobs, std::vector<std::string>& rels) {
+    PhaseScope phase(Phase::Walk);
+    for (auto& p : fs::recursive_directory_iterator(repo)) {
+        if (!p.is_regular_file()) continue;
+        auto rel = fs::relative(p.path(), repo);
+        std::string srel = rel.string();
+        if (manifest_excludes(srel)) continue;
+        jobs.push_back(HashJob(p.path()));
+        rels.push_back(srel);
     }
-#ifdef _WIN32
-    int rc = _pclose(pipe);
-#else
-    int rc = pclose(pipe);
-#endif
-    return { rc, result };
 }
 
-// Escribe hashes.md5 dentro de 'repo' recorriendo ficheros y usando md5sum por archivo
-static bool generate_hashes_md5(const fs::path& repo, std::string& out_log) {
+// Escribe hashes.md5 dentro de 'repo' recorriendo ficheros y hasheando en proceso
+// (mismo formato que md5sum, rutas relativas ./<relpath> para "md5sum -c").
+// Con un oráculo de cambios se parchea el manifiesto anterior y solo se
+// rehashean las rutas cambiadas; si no hay base fiable, recorrido completo.
+// También escribe hashes.verity según 'verity'.
+static bool generate_hashes_md5(const fs::path& repo, const HashOptions& opts, ChangeOracle oracle,
+                                VerityMode verity, std::string& out_log) {
     fs::path hashes_path = repo / "hashes.md5";
+    ChangeSet cs;
+    // La línea de hashes.verity reescribe hashes.md5: va antes del token y del
+    // registro de sucios, o el token guardaría el md5 de un manifiesto que ya
+    // no existe y el siguiente Generar sería un recorrido completo
+    auto finish = [&]() {
+        if (!write_verity_manifest(repo, verity, out_log)) return false;
+        record_dirty_paths(repo);
+        fsmonitor_save_token(repo, "generate", cs);
+        return true;
+    };
+    if (oracle != ChangeOracle::None && fs::exists(hashes_path)) {
+        bool have = oracle == ChangeOracle::Fsmonitor ? fsmonitor_changed_paths(repo, "generate", cs, out_log)
+                                                      : git_changed_paths(repo, cs, out_log);
+        if (have) {
+            HashStats stats;
+            if (patch_manifest(repo, cs, opts, stats, out_log)) {
+                out_log += "Generado: " + hashes_path.string() + " (" + stats_summary(stats) + ")\n";
+                return finish();
+            }
+        }
+        out_log += "Incremental no disponible, recorrido completo\n";
+    } else if (oracle == ChangeOracle::Fsmonitor) {
+        // Sin manifiesto previo: solo se toma el token para la próxima vez
+        std::string ignored;
+        fsmonitor_changed_paths(repo, "generate", cs, ignored);
+    }
+
     std::ofstream ofs(hashes_path, std::ios::trunc);
     if (!ofs.is_open()) {
         out_log += "Error: no se puede crear " + hashes_path.string() + "\n";
         return false;
     }
 
-    // Recorre archivos recursivamente, excluyendo .git y los hashes previos
-    for (auto& p : fs::recursive_directory_iterator(repo)) {
-        if (!p.is_regular_file()) continue;
-        auto rel = fs::relative(p.path(), repo);
-        std::string srel = rel.string();
-        if (srel.rfind(".git", 0) == 0) continue; // empieza por .git
-        if (srel == "hashes.md5" || srel == "hashes.md5.asc") continue;
+    std::vector<HashJob> jobs;
+    std::vector<std::string> rels;
+    collect_repo_files(repo, jobs, rels);
 
-        // Ejecuta md5sum sobre el archivo y captura la línea
-        std::string cmd = "md5sum \"" + p.path().string() + "\"";
-        auto [rc, out] = run_command_capture(cmd);
-        if (rc != 0) {
-            out_log += "md5sum fallo para " + p.path().string() + " :\n" + out + "\n";
+    HashStats stats;
+    hash_files(jobs, opts, stats);
+    PhaseScope phase(Phase::Write);
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (!jobs[i].ok) {
+            out_log += "md5 fallo para " + jobs[i].path.string() + " : " + jobs[i].err + "\n";
             ofs.close();
             return false;
         }
-        // md5sum devuelve: "<hash>  /full/path/to/file\n"
-        // Queremos dejar las rutas relativas dentro del repo para verificación con md5sum -c
-        // Así que reemplazamos la ruta absoluta por ./<relpath>
-        // Tomamos la primera token (hash) y la segunda (path) separadas por espacios
-        std::istringstream iss(out);
-        std::string hash, path_out;
-        if (!(iss >> hash)) continue;
-        // Rest of line is path (may include spaces). Get remainder of out after hash.
-        auto pos = out.find(hash);
-        std::string remainder = out.substr(pos + hash.size());
-        // Trim leading whitespace
-        size_t start = remainder.find_first_not_of(" \t");
-        std::string fullpath = (start==std::string::npos) ? "" : remainder.substr(start);
-        // remove trailing newline
-        while(!fullpath.empty() && (fullpath.back() == '\n' || fullpath.back() == '\r')) fullpath.pop_back();
-
-        // Use relative path prefixed with ./
-        std::string relpath = "./" + srel;
-        ofs << hash << "  " << relpath << "\n";
+        ofs << jobs[i].hex << "  ./" << rels[i] << "\n";
     }
     ofs.close();
-    out_log += "Generado: " + hashes_path.string() + "\n";
-    return true;
+    out_log += "Hash (" + std::string(backend_name(opts.backend)) + "): " + last_hash_files_layout() + "\n";
+    out_log += "Generado: " + hashes_path.string() + " (" + stats_summary(stats) + ")\n";
+    // El token se tomó antes de hashear: lo cambiado durante la pasada sale la próxima vez
+    return finish();
 }
 
-// Firma hashes.md5 con gpg y opcional default key
+// Firma el documento del repo (hashes.md5 o hashes.tree) con gpg y opcional default key
 static bool sign_hashes(const fs::path& repo, const std::string& gpg_key, std::string& out_log) {
-    fs::path hashes = repo / "hashes.md5";
-    fs::path asc = repo / "hashes.md5.asc";
+    PhaseScope phase(Phase::Sign);
+    fs::path hashes = signed_document(repo);
+    fs::path asc = hashes.string() + ".asc";
     if (!fs::exists(hashes)) {
         out_log += "No existe " + hashes.string() + "\n";
         return false;
@@ -121,6 +162,62 @@ static bool sign_hashes(const fs::path& repo, const std::string& gpg_key, std::s
     return true;
 }
 
+// Cómo se firma el documento de cada repo (hashes.md5 o hashes.tree)
+enum class SignMode { Gpg, GpgFleet, Ed25519 };
+
+// Donde minisign guarda sus claves por defecto (~/.minisign)
+static fs::path minisign_dir() {
+#ifdef _WIN32
+    const char* home = std::getenv("USERPROFILE");
+#else
+    const char* home = std::getenv("HOME");
+#endif
+    return fs::path(home ? home : ".") / ".minisign";
+}
+
+// Quita las firmas de los otros modos, que ya no describen el documento
+// recién generado (y en verificación tendrían prioridad sobre la nueva)
+static void remove_stale_signatures(const fs::path& repo, std::initializer_list<std::string> keep) {
+    std::error_code ec;
+    for (const char* f : { "hashes.md5.asc", "hashes.md5.minisig", "hashes.tree.asc", "hashes.tree.minisig",
+                           "hashes.fleet", "hashes.fleet.asc" })
+        if (std::find(keep.begin(), keep.end(), f) == keep.end()) fs::remove(repo / f, ec);
+}
+
+// Firma de flota: una sola operación gpg (--clearsign) sobre la raíz de
+// Merkle de los documentos de todos los repos, en vez de una por repo (fleet.h)
+static bool sign_fleet(const std::vector<fs::path>& repos, const fs::path& root, const std::string& gpg_key,
+                       std::string& out_log) {
+    PhaseScope phase(Phase::Sign);
+    std::string doc;
+    if (!fleet_build(repos, doc, out_log)) return false;
+    fs::path txt = root / "hashnsign-fleet.txt";
+    fs::path asc = root / "hashnsign-fleet.asc";
+    {
+        std::ofstream ofs(txt, std::ios::trunc);
+        if (!ofs.is_open()) {
+            out_log += "Error: no se puede crear " + txt.string() + "\n";
+            return false;
+        }
+        ofs << doc;
+    }
+    std::error_code ec;
+    fs::remove(asc, ec);
+    std::string cmd = "gpg ";
+    if (!gpg_key.empty()) cmd += "--default-key " + gpg_key + " ";
+    cmd += "--armor --output \"" + asc.string() + "\" --clearsign \"" + txt.string() + "\"";
+    auto [rc, out] = run_command_capture(cmd);
+    out_log += out;
+    if (rc != 0) {
+        out_log += "gpg sign failed (rc=" + std::to_string(rc) + ")\n";
+        return false;
+    }
+    if (!fleet_install_signature(repos, asc, out_log)) return false;
+    for (auto& r : repos) remove_stale_signatures(r, { "hashes.fleet", "hashes.fleet.asc" });
+    out_log += "Firmado (flota): " + asc.string() + "\n";
+    return true;
+}
+
 // Git add/commit/push
 static bool git_add_commit_push(const fs::path& repo, std::string& out_log) {
     auto run = [&](const std::string& c)->bool {
@@ -133,7 +230,12 @@ static bool git_add_commit_push(const fs::path& repo, std::string& out_log) {
         return true;
     };
 
-    if (!run("git add hashes.md5 hashes.md5.asc")) return false;
+    // Los que ya no existen (p.ej. hashes.md5.asc al pasar a firma de flota) se
+    // quitan del índice
+    std::string files, gone;
+    for (const char* f : kManifestArtifacts) (fs::exists(repo / f) ? files : gone) += std::string(" ") + f;
+    if (!run("git add" + files)) return false;
+    if (!run("git rm --cached --quiet --ignore-unmatch" + gone)) return false;
     // Check if there is something to commit
     auto [rcStatus, statusOut] = run_command_capture("cd \"" + repo.string() + "\" && git status --porcelain");
     if (rcStatus != 0) {
@@ -150,9 +252,15 @@ static bool git_add_commit_push(const fs::path& repo, std::string& out_log) {
     return true;
 }
 
+// Publica lo generado: commit y push en la rama o, con 'in_ref', solo en
+// refs/hashnsign/manifest (manifest_ref.h)
+static bool publish_manifest(const fs::path& repo, bool in_ref, std::string& out_log) {
+    return in_ref ? manifest_ref_publish(repo, true, out_log) : git_add_commit_push(repo, out_log);
+}
+
 static bool verify_signature(const fs::path& repo, const std::string& gpg_key, std::string& out_log) {
-    fs::path asc = repo / "hashes.md5.asc";
-    fs::path hashes = repo / "hashes.md5";
+    fs::path hashes = signed_document(repo);
+    fs::path asc = hashes.string() + ".asc";
     if (!fs::exists(asc) || !fs::exists(hashes)) {
         out_log += "Faltan archivos de firma o hashes en " + repo.string() + "\n";
         return false;
@@ -176,26 +284,369 @@ static bool verify_signature(const fs::path& repo, const std::string& gpg_key, s
     return good;
 }
 
-static bool verify_md5sum(const fs::path& repo, std::string& out_log) {
+// Raíz de flota de un documento firmado en claro, tras comprobar su firma
+static bool load_fleet_root(const fs::path& asc, const std::string& gpg_key, FleetRoot& root,
+                            std::string& out_log) {
+    if (!fs::exists(asc)) return false;
+    // El documento se toma de la salida de gpg, el mismo texto que acaba de
+    // verificar: releer el archivo dejaría cambiarlo entre medias, y un
+    // segundo parser de clearsign podría no leer lo mismo que gpg
+    std::string cmd = "gpg --batch ";
+    if (!gpg_key.empty()) cmd += "--keyid-format LONG ";
+    std::string err;
+    auto [rc, doc] = run_command_split(cmd + "--decrypt " + shell_quote(asc.string()), err);
+    out_log += err;
+    if (rc != 0 || err.find("Good signature") == std::string::npos) {
+        out_log += "Firma NO válida o no verificable en " + asc.string() + "\n";
+        return false;
+    }
+    if (!fleet_parse_root(doc, root)) {
+        out_log += "Raíz de flota mal formada en " + asc.string() + "\n";
+        return false;
+    }
+    return true;
+}
+
+// Firma de cada repo: su prueba de inclusión si es de una flota, si no su
+// <documento>.minisig o su <documento>.asc (signed_document). La raíz de flota de 'root' se
+// verifica con gpg una sola vez; solo si un repo no encaja en ella se recurre a
+// su propia copia firmada. Las firmas Ed25519 de todos los repos se comprueban
+// juntas, en un lote, con la clave pública 'minisign_pub'.
+static std::vector<bool> verify_signatures(const std::vector<fs::path>& repos, const fs::path& root,
+                                           const std::string& gpg_key, const fs::path& minisign_pub,
+                                           std::string& log_text) {
+    PhaseScope phase(Phase::Sign);
+    std::vector<fs::path> ed_files;
+    std::vector<size_t> ed_index(repos.size(), SIZE_MAX);
+    for (size_t i = 0; i < repos.size(); ++i) {
+        fs::path doc = signed_document(repos[i]);
+        if (fs::exists(repos[i] / "hashes.fleet") || !fs::exists(doc.string() + ".minisig")) continue;
+        ed_index[i] = ed_files.size();
+        ed_files.push_back(doc);
+    }
+    std::vector<bool> ed_ok(ed_files.size(), false);
+    if (!ed_files.empty()) {
+        MinisignPublicKey key;
+        if (minisign_load_public_key(minisign_pub, key, log_text)) ed_ok = minisign_verify_files(ed_files, key, log_text);
+    }
+
+    std::vector<bool> sigs;
+    FleetRoot fleet;
+    bool fleet_tried = false, fleet_ok = false;
+    for (size_t i = 0; i < repos.size(); ++i) {
+        const fs::path& r = repos[i];
+        std::string tmp;
+        bool ok;
+        if (ed_index[i] != SIZE_MAX) {
+            ok = ed_ok[ed_index[i]];
+        } else if (!fs::exists(r / "hashes.fleet")) {
+            ok = verify_signature(r, gpg_key, tmp);
+        } else {
+            if (!fleet_tried) {
+                fleet_tried = true;
+                fleet_ok = load_fleet_root(root / "hashnsign-fleet.asc", gpg_key, fleet, tmp);
+            }
+            std::string shared_log;
+            ok = fleet_ok && fleet_check_repo(r, fleet, shared_log);
+            if (!ok) {
+                FleetRoot own;
+                ok = load_fleet_root(r / "hashes.fleet.asc", gpg_key, own, tmp) && fleet_check_repo(r, own, tmp);
+            }
+            tmp += ok ? "Firma de flota válida en " + r.string() + "\n"
+                      : "Firma de flota NO válida en " + r.string() + "\n";
+        }
+        log_text += tmp;
+        sigs.push_back(ok);
+    }
+    return sigs;
+}
+
+// Equivalente en proceso a "md5sum -c hashes.md5": misma salida por línea
+// ("./ruta: OK" / "./ruta: FAILED") para que el log siga siendo familiar.
+// Con el oráculo fsmonitor solo se rehashea lo que el daemon vio cambiar desde
+// la última verificación correcta; el resto se da por bueno sin leerlo.
+static bool verify_md5sum(const fs::path& repo, const HashOptions& opts, ChangeOracle oracle,
+                          std::string& out_log) {
     fs::path hashes = repo / "hashes.md5";
     if (!fs::exists(hashes)) {
         out_log += "No existe " + hashes.string() + "\n";
         return false;
     }
-    std::string cmd = "cd \"" + repo.string() + "\" && md5sum -c hashes.md5";
-    auto [rc, out] = run_command_capture(cmd);
-    out_log += out;
-    if (rc == 0) {
+    std::vector<ManifestEntry> entries;
+    if (!read_manifest(hashes, entries, out_log)) return false;
+
+    ChangeSet cs;
+    if (oracle == ChangeOracle::Fsmonitor && fsmonitor_changed_paths(repo, "verify", cs, out_log)) {
+        ChangedPathFilter filter(cs);
+        size_t before = entries.size();
+        // La línea de hashes.verity se queda aunque no haya cambiado: sin ella
+        // verity_prefilter no puede avalar las medidas y se rehashea todo lo sellado
+        const std::string verity_self = std::string("./") + kVerityManifest;
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [&](const ManifestEntry& e) {
+                                         return !filter.covers(e.path) && e.path != verity_self;
+                                     }),
+                      entries.end());
+        out_log += "fsmonitor: " + std::to_string(before - entries.size()) + " entradas sin cambios desde la "
+                   "última verificación, " + std::to_string(entries.size()) + " a comprobar\n";
+    }
+
+    size_t failed = 0, unreadable = 0;
+    size_t sealed = verity_prefilter(repo, entries, failed, out_log);
+
+    std::vector<HashJob> jobs;
+    jobs.reserve(entries.size());
+    for (auto& e : entries) jobs.push_back(HashJob(repo / e.path));
+
+    HashStats stats;
+    hash_files(jobs, verify_hash_options(opts), stats);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const ManifestEntry& e = entries[i];
+        if (!jobs[i].ok) {
+            out_log += e.path + ": FAILED open or read (" + jobs[i].err + ")\n";
+            ++unreadable;
+        } else if (jobs[i].hex != e.digest) {
+            out_log += e.path + ": FAILED\n";
+            ++failed;
+        } else {
+            out_log += e.path + ": OK\n";
+        }
+    }
+    out_log += stats_summary(stats);
+    if (sealed) out_log += ", " + std::to_string(sealed) + " por medida fs-verity";
+    out_log += "\n";
+    if (failed == 0 && unreadable == 0) {
+        fsmonitor_save_token(repo, "verify", cs);
         out_log += "Integridad OK en " + repo.string() + "\n";
         return true;
+    }
+    out_log += "Integridad FALLIDA (" + std::to_string(failed) + " distintos, " + std::to_string(unreadable) +
+               " ilegibles) en " + repo.string() + "\n";
+    return false;
+}
+
+// Digests del manifiesto de 'repo' contra la allowlist. En modo árbol no hay
+// digests por archivo que comprobar.
+static bool check_allowlist(const fs::path& repo, const Allowlist& allow, std::string& out_log) {
+    if (fs::exists(repo / "hashes.tree")) {
+        out_log += "Allowlist: " + repo.string() + " está en modo árbol, sin digests por archivo\n";
+        return true;
+    }
+    return allowlist_check_manifest(allow, repo / "hashes.md5", out_log);
+}
+
+// Lo que se deja en la ventana de log; lo anterior se lee en el historial
+static constexpr size_t kLogKeep = 1 << 20;
+
+// Ejecución en curso: su archivo del historial y desde dónde del log en
+// pantalla queda salida por escribir en él
+struct RunCapture {
+    RunLogWriter file;
+    size_t start = 0;
+};
+
+// Si el log en pantalla ha crecido demasiado, se queda solo con su final (y
+// devuelve la memoria: tras una ejecución grande la capacidad seguiría ahí)
+static void trim_log(std::string& log_text) {
+    if (log_text.size() <= kLogKeep) return;
+    size_t cut = log_text.find('\n', log_text.size() - kLogKeep);
+    if (cut == std::string::npos) return;
+    log_text.erase(0, cut + 1);
+    log_text.insert(0, "[... " + format_bytes(cut + 1) + " anteriores: ver el historial ...]\n");
+    log_text.shrink_to_fit();
+}
+
+// Principio de una operación: abre su archivo del historial y pone a cero
+// los contadores por fase y los de memoria
+static void begin_run(RunCapture& run, const char* op, std::string& log_text) {
+    if (perf_enabled()) perf_reset();
+    mem_reset();
+    if (!run.file.open(op)) log_text += "No se puede crear el log del historial en " + run_log_dir().string() + "\n";
+    run.start = log_text.size();
+}
+
+// Pasa al historial lo que la operación lleva añadido al log. Se llama entre
+// repos: la salida de una ejecución larga no se acumula entera en memoria.
+static void flush_run(RunCapture& run, std::string& log_text) {
+    run.file.write(std::string_view(log_text).substr(run.start));
+    trim_log(log_text);
+    run.start = log_text.size();
+}
+
+// Fin de la operación: la tabla de contadores si están activos y la memoria
+// de la ejecución, y cierra el archivo del historial
+static void finish_run(RunCapture& run, std::string& log_text) {
+    if (perf_enabled()) log_text += perf_report();
+    mem_set_buffer("log", log_text.capacity());
+    mem_set_buffer("pool de E/S", BufferPool::shared().bytes());
+    log_text += mem_report();
+    flush_run(run, log_text);
+    fs::path saved = run.file.close();
+    if (!saved.empty()) log_text += "Log guardado en " + saved.string() + "\n";
+}
+
+// Benchmark de backends de lectura sobre todos los archivos de los repos
+static ReadBackend benchmark_repos(const std::vector<fs::path>& repos, const HashOptions& opts,
+                                   std::string& out_log) {
+    std::vector<fs::path> files;
+    for (auto& r : repos) {
+        std::vector<HashJob> jobs;
+        std::vector<std::string> rels;
+        collect_repo_files(r, jobs, rels);
+        for (auto& j : jobs) files.push_back(j.path);
+    }
+    if (files.empty()) {
+        out_log += "Benchmark: no hay archivos\n";
+        return opts.backend;
+    }
+    return benchmark_backends(files, opts, out_log);
+}
+
+// Verificar (todos) con el contenido repartido entre procesos worker; las
+// firmas se siguen comprobando aquí
+static void verify_all_sharded(const std::vector<fs::path>& repos, const fs::path& root, const std::string& gpg_key,
+                               const fs::path& minisign_pub, const Allowlist& allow, const fs::path& translog,
+                               const fs::path& translog_head, const ShardOptions& so, std::string& log_text) {
+    log_text += "=== Verificar (multiproceso) ===\n";
+    std::vector<bool> sigs = verify_signatures(repos, root, gpg_key, minisign_pub, log_text);
+    // Los repos en modo árbol no tienen contenido que repartir: git diff aquí
+    std::vector<fs::path> md5_repos;
+    std::vector<int> content(repos.size(), -1);
+    for (size_t i = 0; i < repos.size(); ++i) {
+        if (fs::exists(repos[i] / "hashes.tree")) {
+            std::string tmp;
+            content[i] = verify_tree_statement(repos[i], tmp) ? 1 : 0;
+            log_text += tmp;
+        } else {
+            md5_repos.push_back(repos[i]);
+        }
+    }
+    std::vector<RepoVerifyResult> results;
+    // Un fallo del coordinador que no se refleja en ningún repo (poll, otra
+    // plataforma) invalida todos los resultados md5
+    bool sharded_ok = md5_repos.empty() || verify_sharded(md5_repos, so, results, log_text);
+    bool trust = sharded_ok || std::any_of(results.begin(), results.end(),
+                                           [](const RepoVerifyResult& r) { return !r.good(); });
+    if (!trust) log_text += "La verificación multiproceso no terminó bien: md5 no verificado\n";
+    for (size_t i = 0, k = 0; i < repos.size(); ++i) {
+        bool tree = content[i] >= 0;
+        bool ok = tree ? content[i] == 1 : trust && k < results.size() && results[k].good();
+        if (!tree) ++k;
+        std::string listed;
+        if (allow.is_open()) listed = std::string(", lista=") + (check_allowlist(repos[i], allow, log_text) ? "OK" : "FAIL");
+        if (!translog.empty())
+            listed += std::string(", registro=") + (translog_check(translog, repos[i], translog_head, log_text) ? "OK" : "FAIL");
+        log_text += "Resultado " + repos[i].string() + ": firma=" + std::string(sigs[i] ? "OK" : "FAIL") +
+                    (tree ? ", tree=" : ", md5=") + std::string(ok ? "OK" : "FAIL") + listed + "\n";
+    }
+    log_text += "=== Fin verificación ===\n";
+}
+
+// Modo consola (sin ventana):
+//   hash_gpg_gui --selftest                          vectores conocidos de BLAKE2b y Ed25519
+//   hash_gpg_gui --bench <repo>...                   compara los backends de lectura
+//   hash_gpg_gui --verify-sharded <n> <repo>...      verificación multiproceso (n workers por disco)
+//   hash_gpg_gui --verify-shard                      worker interno de la anterior (stdin/stdout)
+//   hash_gpg_gui --allowlist <lista> <repo>...       señala los digests de hashes.md5 que no están en la lista
+//   hash_gpg_gui --duplicates <informe> <repo>...    grupos de archivos iguales entre todos los hashes.md5
+//   hash_gpg_gui --log-head                          cabecera actual del registro de transparencia
+//   hash_gpg_gui --log-audit <cabecera>              ¿el registro extiende una cabecera guardada antes?
+//   hash_gpg_gui --log-check [--head <cabecera>] <repo>...
+//                                                    ¿está el documento firmado de cada repo en el registro?
+//                                                    (con --head, además, ¿extiende el registro esa cabecera?)
+//   hash_gpg_gui --search <log> [--repo R] [--status S] [--path GLOB] [--text T] [--max N]
+//                                                    filtra un log del historial (S: ok, failed, ilegible, no-aprobado, error)
+// El registro es $HASHNSIGN_TRANSLOG o translog_default_dir().
+// Con HASHNSIGN_PERF=1 se añade la tabla de contadores por fase (perf_counters.h)
+// y con HASHNSIGN_MEM=1 la de asignaciones por fase (mem_stats.h).
+static int run_cli(int argc, char** argv) {
+    std::string cmd = argv[1];
+    if (cmd == "--verify-shard") return run_verify_shard_worker(stdin, stdout);
+    if (const char* p = std::getenv("HASHNSIGN_PERF")) perf_enable(*p && *p != '0');
+    if (const char* p = std::getenv("HASHNSIGN_MEM")) mem_accounting_enable(*p && *p != '0');
+
+    std::vector<fs::path> args(argv + 2, argv + argc);
+    std::string out;
+    int rc = 0;
+    if (cmd == "--selftest" && args.empty()) {
+        rc = minisign_selftest(out) ? 0 : 1;
+    } else if (cmd == "--bench" && !args.empty()) {
+        benchmark_repos(args, HashOptions{}, out);
+    } else if (cmd == "--verify-sharded" && args.size() >= 2) {
+        ShardOptions so;
+        so.workers_per_group = (unsigned)std::max(1, std::atoi(argv[2]));
+        if (const char* l = std::getenv("HASHNSIGN_WORKER_LAUNCHER")) so.launcher = l;
+        std::vector<RepoVerifyResult> results;
+        std::vector<fs::path> repos(args.begin() + 1, args.end());
+        rc = verify_sharded(repos, so, results, out) ? 0 : 1;
+    } else if (cmd == "--allowlist" && args.size() >= 2) {
+        Allowlist allow;
+        if (!allow.open(args[0], out)) {
+            rc = 1;
+        } else {
+            for (size_t i = 1; i < args.size(); ++i)
+                if (!check_allowlist(args[i], allow, out)) rc = 1;
+        }
+    } else if (cmd == "--duplicates" && args.size() >= 2) {
+        DupStats stats;
+        rc = duplicate_report(std::vector<fs::path>(args.begin() + 1, args.end()), args[0], DupOptions{}, stats, out)
+                 ? 0
+                 : 1;
+    } else if (cmd == "--search" && !args.empty() && args.size() % 2 == 1) {
+        LogQuery q;
+        size_t max_lines = 1000;
+        for (size_t i = 1; i + 1 < args.size() && rc == 0; i += 2) {
+            std::string opt = args[i].string(), val = args[i + 1].string();
+            LineStatus st;
+            if (opt == "--repo") q.repo = val;
+            else if (opt == "--path") q.path_glob = val;
+            else if (opt == "--text") q.text = val;
+            else if (opt == "--max") max_lines = (size_t)std::strtoull(val.c_str(), nullptr, 10);
+            else if (opt == "--status" && parse_line_status(val, st)) q.status = (int)st;
+            else {
+                out = "Opción o estado no válido: " + opt + " " + val + "\n";
+                rc = 2;
+            }
+        }
+        if (rc == 0 && !search_log_file(args[0], q, max_lines, out)) rc = 1;
+    } else if (cmd.rfind("--log-", 0) == 0) {
+        const char* env = std::getenv("HASHNSIGN_TRANSLOG");
+        fs::path dir = env && *env ? fs::path(env) : translog_default_dir();
+        TransLog log;
+        if (cmd == "--log-head" && args.empty()) {
+            if (log.open(dir, out)) out += translog_head_text(log.head());
+            else rc = 1;
+        } else if (cmd == "--log-audit" && args.size() == 1) {
+            rc = translog_audit(dir, args[0], out) ? 0 : 1;
+        } else if (cmd == "--log-check" && !args.empty() && (args[0] != "--head" || args.size() >= 3)) {
+            fs::path head;
+            if (args[0] == "--head") {
+                head = args[1];
+                args.erase(args.begin(), args.begin() + 2);
+            }
+            for (auto& r : args)
+                if (!translog_check(dir, r, head, out)) rc = 1;
+        } else {
+            out = "Uso: hash_gpg_gui [--log-head | --log-audit <cabecera> | --log-check [--head <cabecera>] <repo>...]\n";
+            rc = 2;
+        }
     } else {
-        out_log += "Integridad FALLIDA (rc=" + std::to_string(rc) + ") en " + repo.string() + "\n";
-        return false;
+        out = "Uso: hash_gpg_gui [--selftest | --bench <repo>... | --verify-sharded <n> <repo>... |"
+              " --allowlist <lista> <repo>... | --duplicates <informe> <repo>... | --log-head | --log-audit <cabecera> |"
+              " --log-check [--head <cabecera>] <repo>... |"
+              " --search <log> [--repo R] [--status S] [--path GLOB] [--text T] [--max N]]\n";
+        rc = 2;
     }
+    if (perf_enabled()) out += perf_report();
+    if (mem_accounting_enabled()) out += mem_report();
+    std::fputs(out.c_str(), rc == 0 ? stdout : stderr);
+    return rc;
 }
 
-int main(int, char**)
+int main(int argc, char** argv)
 {
+    if (argc > 1) return run_cli(argc, argv);
+
     // Setup SDL + OpenGL context
     if (SDL_Init(SDL_INIT_VIDEO|SDL_INIT_TIMER|SDL_INIT_GAMECONTROLLER) != 0) {
         std::fprintf(stderr, "Error SDL_Init: %s\n", SDL_GetError());
@@ -234,11 +685,57 @@ int main(int, char**)
     // App state
     char root_path_buf[1024] = "./";
     char gpg_key_buf[128] = "";
+    char allowlist_buf[1024] = "";
     std::string log_text;
     bool auto_scroll = true;
+    HashOptions hash_opts;
+    ChangeOracle change_oracle = ChangeOracle::None;
+    VerityMode verity_mode = VerityMode::Off;
+    SignMode sign_mode = SignMode::Gpg;
+    bool tree_mode = false;
+    char minisign_sec_buf[1024], minisign_pub_buf[1024];
+    std::snprintf(minisign_sec_buf, sizeof(minisign_sec_buf), "%s", (minisign_dir() / "minisign.key").string().c_str());
+    std::snprintf(minisign_pub_buf, sizeof(minisign_pub_buf), "%s", (minisign_dir() / "minisign.pub").string().c_str());
+    bool store_in_ref = false;
+    bool use_translog = false;
+    char translog_buf[1024];
+    std::snprintf(translog_buf, sizeof(translog_buf), "%s", translog_default_dir().string().c_str());
+    // Cabecera guardada antes (--log-head): sin ella, Verificar solo comprueba
+    // el registro contra sí mismo
+    char translog_head_buf[1024] = "";
+    bool sharded_verify = false;
+    int shard_workers = 2;
+    char launcher_buf[256] = "";
+    // Historial de ejecuciones (run_log.h)
+    bool show_history = false;
+    std::vector<fs::path> history_files;
+    MappedLog history;
+    char history_path_buf[1024] = "";
+    char history_goto_buf[32] = "";
+    uint64_t history_base = 0; // primera línea de la ventana que ve el clipper
+    bool history_jump = false;
+    // Filtros del historial; el índice se destruye antes que el log
+    LogIndex history_index;
+    char filter_repo_buf[256] = "";
+    char filter_path_buf[512] = "";
+    char filter_text_buf[256] = "";
+    int filter_status = 0; // 0 = cualquiera; si no, LineStatus + 1
+    bool history_filtered = false;
+    bool filter_dirty = false;
+    LogHits history_hits;
+    double history_search_at = 0;
+    // Explorador del manifiesto (manifest_tree.h)
+    bool show_tree = false;
+    ManifestTree manifest_tree;
+    // Panel de memoria (mem_stats.h)
+    bool show_memory = false;
+    double memory_at = -1; // última lectura de los buffers
+    // Perfil de la interfaz (ui_profiler.h)
+    UiProfiler ui_prof;
 
     bool running = true;
     while (running) {
+        ui_prof.begin_frame();
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
             ImGui_ImplSDL2_ProcessEvent(&event);
@@ -255,12 +752,80 @@ int main(int, char**)
 
         ImGui::InputText("Ruta raíz", root_path_buf, sizeof(root_path_buf));
         ImGui::InputText("GPG_KEY_ID (opcional)", gpg_key_buf, sizeof(gpg_key_buf));
+        ImGui::Checkbox("Saltar huecos de ficheros dispersos (SEEK_DATA/SEEK_HOLE)", &hash_opts.sparse);
+        {
+            static const char* backends[] = { "buffered (read)", "mmap (sin copia)", "af_alg (kernel, splice)" };
+            int b = (int)hash_opts.backend;
+            if (ImGui::Combo("Backend de lectura", &b, backends, IM_ARRAYSIZE(backends))) hash_opts.backend = (ReadBackend)b;
+        }
+        {
+            static const char* oracles[] = { "recorrido completo", "incremental (git diff)",
+                                            "incremental (fsmonitor/Watchman)" };
+            int o = (int)change_oracle;
+            if (ImGui::Combo("Detección de cambios", &o, oracles, IM_ARRAYSIZE(oracles))) change_oracle = (ChangeOracle)o;
+        }
+        {
+            static const char* modes[] = { "no", "medir (hashes.verity)", "sellar y medir (irreversible)" };
+            int v = (int)verity_mode;
+            if (ImGui::Combo("fs-verity", &v, modes, IM_ARRAYSIZE(modes))) verity_mode = (VerityMode)v;
+        }
+        ImGui::InputText("Allowlist de digests aprobados (opcional)", allowlist_buf, sizeof(allowlist_buf));
+        ImGui::Checkbox("Caché de digests al generar (xattr user.hashnsign.*)", &hash_opts.digest_cache);
+        ImGui::SameLine();
+        ImGui::Checkbox("Reanudar archivos que solo crecen", &hash_opts.resume_appends);
+        ImGui::Checkbox("Buffers en huge pages", &hash_opts.huge_pages);
+        ImGui::SameLine();
+        ImGui::Checkbox("Workers por nodo NUMA", &hash_opts.numa);
+        {
+            bool counters = perf_enabled();
+            if (ImGui::Checkbox("Contadores hardware por fase (perf_event_open)", &counters)) perf_enable(counters);
+            ImGui::SameLine();
+            bool memory = mem_accounting_enabled();
+            if (ImGui::Checkbox("Contabilidad de memoria por fase", &memory)) mem_accounting_enable(memory);
+            ImGui::SameLine();
+            bool profile = ui_prof.enabled();
+            if (ImGui::Checkbox("Perfil de la interfaz", &profile)) ui_prof.set_enabled(profile);
+        }
+        {
+            const char* modes[] = { "gpg (una por repo)", "gpg de flota (una para todos)", "Ed25519 / minisign" };
+            int m = (int)sign_mode;
+            if (ImGui::Combo("Firma", &m, modes, IM_ARRAYSIZE(modes))) sign_mode = (SignMode)m;
+            const char* contents[] = { "Manifiesto hashes.md5 (recorrido)", "Tree de git (HEAD)" };
+            int c = tree_mode ? 1 : 0;
+            if (ImGui::Combo("Contenido firmado", &c, contents, IM_ARRAYSIZE(contents))) tree_mode = c == 1;
+        }
+        if (sign_mode == SignMode::Ed25519) {
+            ImGui::InputText("Clave secreta minisign", minisign_sec_buf, sizeof(minisign_sec_buf));
+            if (ImGui::Button("Crear clave Ed25519")) {
+                std::string tmp;
+                minisign_generate_keys(fs::path(minisign_sec_buf), fs::path(minisign_pub_buf), tmp);
+                log_text += tmp;
+            }
+        }
+        ImGui::InputText("Clave pública minisign (verificar .minisig)", minisign_pub_buf, sizeof(minisign_pub_buf));
+        ImGui::Checkbox("Guardar manifiesto y firmas en refs/hashnsign/manifest (sin commits en la rama)", &store_in_ref);
+        ImGui::Checkbox("Registro de transparencia local", &use_translog);
+        if (use_translog) {
+            ImGui::SameLine();
+            ImGui::InputText("Directorio del registro", translog_buf, sizeof(translog_buf));
+            ImGui::InputText("Cabecera de confianza (opcional)", translog_head_buf, sizeof(translog_head_buf));
+        }
+        fs::path translog_dir = use_translog ? fs::path(translog_buf) : fs::path();
+        fs::path translog_head = use_translog ? fs::path(translog_head_buf) : fs::path();
+        ImGui::Checkbox("Verificación multiproceso", &sharded_verify);
+        if (sharded_verify) {
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(100);
+            ImGui::InputInt("procesos por disco", &shard_workers);
+            ImGui::InputText("Lanzador de workers (opcional, p.ej. ssh nodo1)", launcher_buf, sizeof(launcher_buf));
+        }
 
         ImGui::Separator();
 
         // Detect repos
         ImGui::Text("Repos detectados:");
         static std::vector<fs::path> repos;
+        ui_prof.start(UiProfiler::Discovery);
         repos.clear();
         try {
             for (auto& p : fs::directory_iterator(fs::path(root_path_buf))) {
@@ -271,65 +836,521 @@ int main(int, char**)
         } catch (const std::exception& e) {
             // ignore
         }
+        ui_prof.stop(UiProfiler::Discovery);
 
+        ui_prof.start(UiProfiler::RepoList);
         for (size_t i=0;i<repos.size();++i) {
             ImGui::BulletText("%s", repos[i].string().c_str());
         }
         if (repos.empty()) ImGui::TextDisabled("No se encontraron repositorios (carpetas con .git) en la ruta.");
+        ui_prof.stop(UiProfiler::RepoList);
 
         ImGui::Separator();
 
-        // Buttons
+        // Buttons: las operaciones corren dentro del frame
+        ui_prof.start(UiProfiler::Buttons);
         if (ImGui::Button("Generar & Firmar (todos)")) {
+            RunCapture run;
+            begin_run(run, "generar", log_text);
             log_text += "=== Generar & Firmar ===\n";
+            std::vector<fs::path> generated;
+            MinisignSecretKey ed_key;
+            bool signer_ok = sign_mode != SignMode::Ed25519 ||
+                             minisign_load_secret_key(fs::path(minisign_sec_buf), ed_key, log_text);
+            Allowlist allow;
+            if (signer_ok && allowlist_buf[0]) signer_ok = allow.open(fs::path(allowlist_buf), log_text);
             for (auto& r : repos) {
+                if (!signer_ok) break;
+                flush_run(run, log_text);
                 log_text += "Procesando: " + r.string() + "\n";
                 std::string tmp;
-                if (!generate_hashes_md5(r, tmp)) {
-                    log_text += "ERROR generando hashes en " + r.string() + "\n" + tmp + "\n";
-                    continue;
-                } else log_text += tmp;
+                if (tree_mode) {
+                    if (!write_tree_statement(r, tmp)) {
+                        log_text += "ERROR generando hashes.tree en " + r.string() + "\n" + tmp + "\n";
+                        continue;
+                    } else log_text += tmp;
+                } else {
+                    if (!generate_hashes_md5(r, hash_opts, change_oracle, verity_mode, tmp)) {
+                        log_text += "ERROR generando hashes en " + r.string() + "\n" + tmp + "\n";
+                        continue;
+                    } else log_text += tmp;
+                    // Solo se señala: la firma describe lo que hay, aprobado o no
+                    if (allow.is_open()) check_allowlist(r, allow, log_text);
+                    // Si no, signed_document seguiría eligiendo el hashes.tree anterior
+                    std::error_code ec;
+                    fs::remove(r / "hashes.tree", ec);
+                }
                 tmp.clear();
-                if (!sign_hashes(r, std::string(gpg_key_buf), tmp)) {
+                if (sign_mode == SignMode::GpgFleet) {
+                    generated.push_back(r);
+                    continue;
+                }
+                bool signed_ok = sign_mode == SignMode::Ed25519 ? minisign_sign_file(signed_document(r), ed_key, tmp)
+                                                                : sign_hashes(r, std::string(gpg_key_buf), tmp);
+                if (!signed_ok) {
                     log_text += "ERROR firmando en " + r.string() + "\n" + tmp + "\n";
                     continue;
                 } else log_text += tmp;
+                remove_stale_signatures(r, { signed_document(r).filename().string() +
+                                             (sign_mode == SignMode::Ed25519 ? ".minisig" : ".asc") });
+                if (use_translog) translog_record(translog_dir, r, log_text);
                 tmp.clear();
-                if (!git_add_commit_push(r, tmp)) {
+                if (!publish_manifest(r, store_in_ref, tmp)) {
                     log_text += "ERROR git en " + r.string() + "\n" + tmp + "\n";
                     continue;
                 } else log_text += tmp;
             }
+            if (!generated.empty()) {
+                std::string tmp;
+                if (!sign_fleet(generated, fs::path(root_path_buf), std::string(gpg_key_buf), tmp)) {
+                    log_text += "ERROR firmando la flota\n" + tmp + "\n";
+                } else {
+                    log_text += tmp;
+                    for (auto& r : generated) {
+                        if (use_translog) translog_record(translog_dir, r, log_text);
+                        tmp.clear();
+                        if (!publish_manifest(r, store_in_ref, tmp)) log_text += "ERROR git en " + r.string() + "\n" + tmp + "\n";
+                        else log_text += tmp;
+                    }
+                }
+            }
             log_text += "=== Fin ===\n";
+            finish_run(run, log_text);
         }
         ImGui::SameLine();
         if (ImGui::Button("Verificar (todos)")) {
-            log_text += "=== Verificar ===\n";
-            for (auto& r : repos) {
-                log_text += "Verificando: " + r.string() + "\n";
-                std::string tmp;
-                bool sigok = verify_signature(r, std::string(gpg_key_buf), tmp);
-                log_text += tmp;
-                tmp.clear();
-                bool mdok = verify_md5sum(r, tmp);
-                log_text += tmp;
-                log_text += "Resultado: firma=" + std::string(sigok ? "OK" : "FAIL") + ", md5=" + std::string(mdok ? "OK" : "FAIL") + "\n";
+            RunCapture run;
+            begin_run(run, "verificar", log_text);
+            if (store_in_ref) {
+                for (auto& r : repos)
+                    if (!manifest_ref_restore(r, log_text))
+                        log_text += "ERROR: no se pudo leer " + std::string(kManifestRef) + " en " + r.string() +
+                                    ": se verifica lo que haya en el árbol de trabajo\n";
+            }
+            Allowlist allow;
+            if (allowlist_buf[0] && !allow.open(fs::path(allowlist_buf), log_text)) {
+                log_text += "ERROR: no se puede usar la allowlist, no se verifica\n";
+            } else if (sharded_verify) {
+                ShardOptions so;
+                so.workers_per_group = (unsigned)std::max(1, shard_workers);
+                so.launcher = launcher_buf;
+                so.hash = hash_opts;
+                verify_all_sharded(repos, fs::path(root_path_buf), std::string(gpg_key_buf), fs::path(minisign_pub_buf),
+                                   allow, translog_dir, translog_head, so, log_text);
+            } else {
+                log_text += "=== Verificar ===\n";
+                std::vector<bool> sigs = verify_signatures(repos, fs::path(root_path_buf), std::string(gpg_key_buf),
+                                                           fs::path(minisign_pub_buf), log_text);
+                for (size_t i = 0; i < repos.size(); ++i) {
+                    const fs::path& r = repos[i];
+                    flush_run(run, log_text);
+                    log_text += "Verificando: " + r.string() + "\n";
+                    std::string tmp;
+                    bool sigok = sigs[i];
+                    bool tree = fs::exists(r / "hashes.tree");
+                    bool mdok = tree ? verify_tree_statement(r, tmp) : verify_md5sum(r, hash_opts, change_oracle, tmp);
+                    std::string listed;
+                    if (allow.is_open()) listed = std::string(", lista=") + (check_allowlist(r, allow, tmp) ? "OK" : "FAIL");
+                    if (use_translog)
+                        listed += std::string(", registro=") + (translog_check(translog_dir, r, translog_head, tmp) ? "OK" : "FAIL");
+                    log_text += tmp;
+                    log_text += "Resultado: firma=" + std::string(sigok ? "OK" : "FAIL") + (tree ? ", tree=" : ", md5=") +
+                                std::string(mdok ? "OK" : "FAIL") + listed + "\n";
+                }
+                log_text += "=== Fin verificación ===\n";
             }
-            log_text += "=== Fin verificación ===\n";
+            finish_run(run, log_text);
         }
+        ImGui::SameLine();
+        if (ImGui::Button("Benchmark backends")) {
+            RunCapture run;
+            begin_run(run, "benchmark", log_text);
+            log_text += "=== Benchmark ===\n";
+            // El ganador queda seleccionado para generar y verificar
+            hash_opts.backend = benchmark_repos(repos, hash_opts, log_text);
+            log_text += std::string("Backend seleccionado: ") + backend_name(hash_opts.backend) + "\n";
+            finish_run(run, log_text);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Informe de duplicados")) {
+            RunCapture run;
+            begin_run(run, "duplicados", log_text);
+            log_text += "=== Duplicados ===\n";
+            DupStats stats;
+            duplicate_report(repos, fs::path(root_path_buf) / "hashnsign-duplicates.txt", DupOptions{}, stats, log_text);
+            finish_run(run, log_text);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Historial")) {
+            show_history = true;
+            history_files = list_run_logs();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Explorar manifiesto")) show_tree = true;
+        ImGui::SameLine();
+        if (ImGui::Button("Memoria")) show_memory = true;
+        ui_prof.stop(UiProfiler::Buttons);
 
         ImGui::Separator();
 
         ImGui::Checkbox("Auto-scroll", &auto_scroll);
 
-        ImGui::BeginChild("LogWindow", ImVec2(0, 350), true, ImGuiWindowFlags_HorizontalScrollbar);
-        ImGui::TextUnformatted(log_text.c_str());
-        if (auto_scroll) ImGui::SetScrollHereY(1.0f);
-        ImGui::EndChild();
+        {
+            UiSection section(ui_prof, UiProfiler::LogRender);
+            ImGui::BeginChild("LogWindow", ImVec2(0, 350), true, ImGuiWindowFlags_HorizontalScrollbar);
+            ImGui::TextUnformatted(log_text.c_str());
+            if (auto_scroll) ImGui::SetScrollHereY(1.0f);
+            ImGui::EndChild();
+        }
 
         ImGui::End();
 
+        ui_prof.start(UiProfiler::Windows);
+
+        if (show_history) {
+            // El clipper trabaja con int y el scroll con float (exacto hasta
+            // 2^24 px): se muestra una ventana de kWindow líneas que se mueve
+            // al llegar a sus bordes o al saltar a una línea
+            constexpr uint64_t kWindow = 1 << 20;
+            constexpr size_t kMaxShown = 4096; // caracteres por línea
+            ImGui::SetNextWindowSize(ImVec2(900, 500), ImGuiCond_FirstUseEver);
+            if (ImGui::Begin("Historial de ejecuciones", &show_history)) {
+                auto open_history = [&](const fs::path& p) {
+                    history_index.stop();
+                    if (history.open(p, log_text)) history_index.start(&history);
+                    history_base = 0;
+                    history_hits = LogHits{};
+                    filter_dirty = true;
+                };
+                if (ImGui::Button("Actualizar")) history_files = list_run_logs();
+                ImGui::SameLine();
+                std::string current = history.is_open() ? history.path().filename().string() : "(elegir)";
+                if (ImGui::BeginCombo("Ejecución", current.c_str())) {
+                    for (auto& f : history_files)
+                        if (ImGui::Selectable(f.filename().string().c_str(), history.is_open() && f == history.path()))
+                            open_history(f);
+                    ImGui::EndCombo();
+                }
+                ImGui::InputText("Otro log", history_path_buf, sizeof(history_path_buf));
+                ImGui::SameLine();
+                if (ImGui::Button("Abrir") && history_path_buf[0]) open_history(fs::path(history_path_buf));
+
+                if (history.is_open()) {
+                    uint64_t n = history.lines();
+                    if (history.indexing()) {
+                        float done = history.size_bytes() ? (float)history.indexed_bytes() / (float)history.size_bytes() : 1.0f;
+                        ImGui::Text("%s: %llu líneas, %s (indexando)", history.path().filename().string().c_str(),
+                                    (unsigned long long)n, format_bytes(history.size_bytes()).c_str());
+                        ImGui::SameLine();
+                        ImGui::ProgressBar(done, ImVec2(200, 0));
+                    } else {
+                        ImGui::Text("%s: %llu líneas, %s", history.path().filename().string().c_str(), (unsigned long long)n,
+                                    format_bytes(history.size_bytes()).c_str());
+                    }
+                    ImGui::SetNextItemWidth(150);
+                    if (ImGui::InputText("##goto", history_goto_buf, sizeof(history_goto_buf),
+                                         ImGuiInputTextFlags_CharsDecimal | ImGuiInputTextFlags_EnterReturnsTrue))
+                        history_jump = true;
+                    ImGui::SameLine();
+                    if (ImGui::Button("Ir a línea")) history_jump = true;
+
+                    static const char* kStatusItems[] = { "Cualquiera", "OTRO", "OK", "FAILED", "ILEGIBLE", "NO APROBADO", "ERROR" };
+                    ImGui::SetNextItemWidth(150);
+                    filter_dirty |= ImGui::InputText("Repo##filtro", filter_repo_buf, sizeof(filter_repo_buf));
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(130);
+                    filter_dirty |= ImGui::Combo("Estado", &filter_status, kStatusItems, IM_ARRAYSIZE(kStatusItems));
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(200);
+                    filter_dirty |= ImGui::InputText("Ruta (glob)", filter_path_buf, sizeof(filter_path_buf));
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(200);
+                    filter_dirty |= ImGui::InputText("Texto", filter_text_buf, sizeof(filter_text_buf));
+
+                    LogQuery query;
+                    query.repo = filter_repo_buf;
+                    query.status = filter_status - 1;
+                    query.path_glob = filter_path_buf;
+                    query.text = filter_text_buf;
+                    // Se busca al cambiar el filtro y, mientras se indexa, cada
+                    // medio segundo para ir viendo lo nuevo
+                    double now = ImGui::GetTime();
+                    bool grown = history_index.lines() > history_hits.searched &&
+                                 (!history_index.indexing() || now - history_search_at > 0.5);
+                    if (query.empty()) {
+                        history_filtered = false;
+                    } else if (filter_dirty || grown) {
+                        history_index.search(query, kWindow, history_hits);
+                        history_search_at = now;
+                        history_filtered = true;
+                    }
+                    filter_dirty = false;
+                    if (history_filtered) {
+                        ImGui::Text("%llu coincidencias en %llu líneas%s (%.1f ms)", (unsigned long long)history_hits.total,
+                                    (unsigned long long)history_hits.searched, history_index.indexing() ? ", indexando" : "",
+                                    history_hits.ms);
+                        if (history_hits.total > history_hits.lines.size()) {
+                            ImGui::SameLine();
+                            ImGui::TextDisabled("(se muestran las %zu primeras)", history_hits.lines.size());
+                        }
+                        // Un clic en una coincidencia la abre en el log completo
+                        ImGui::BeginChild("HistoryHits", ImVec2(0, 0), true, ImGuiWindowFlags_HorizontalScrollbar);
+                        ImGuiListClipper hits_clipper;
+                        hits_clipper.Begin((int)history_hits.lines.size());
+                        while (hits_clipper.Step()) {
+                            for (int i = hits_clipper.DisplayStart; i < hits_clipper.DisplayEnd; ++i) {
+                                uint64_t ln = history_hits.lines[(size_t)i];
+                                std::string_view text = history.line(ln);
+                                if (text.size() > kMaxShown) text = text.substr(0, kMaxShown);
+                                char num[32];
+                                std::snprintf(num, sizeof(num), "%10llu", (unsigned long long)(ln + 1));
+                                ImGui::PushID(i);
+                                if (ImGui::SmallButton(num)) {
+                                    std::snprintf(history_goto_buf, sizeof(history_goto_buf), "%llu", (unsigned long long)(ln + 1));
+                                    history_jump = true;
+                                    filter_repo_buf[0] = filter_path_buf[0] = filter_text_buf[0] = '\0';
+                                    filter_status = 0;
+                                }
+                                ImGui::PopID();
+                                ImGui::SameLine();
+                                ImGui::TextUnformatted(text.data(), text.data() + text.size());
+                            }
+                        }
+                        hits_clipper.End();
+                        ImGui::EndChild();
+                    } else {
+                        ImGui::BeginChild("HistoryLines", ImVec2(0, 0), true, ImGuiWindowFlags_HorizontalScrollbar);
+                        float lh = ImGui::GetTextLineHeightWithSpacing();
+                        bool jumped = history_jump && n > 0;
+                        if (jumped) {
+                            uint64_t target = std::strtoull(history_goto_buf, nullptr, 10);
+                            target = std::min<uint64_t>(target ? target - 1 : 0, n - 1);
+                            history_base = target > kWindow / 2 ? target - kWindow / 2 : 0;
+                            ImGui::SetScrollY((float)(target - history_base) * lh);
+                        }
+                        history_jump = false;
+                        uint64_t shown = n > history_base ? std::min<uint64_t>(kWindow, n - history_base) : 0;
+                        ImGuiListClipper clipper;
+                        clipper.Begin((int)shown, lh);
+                        while (clipper.Step()) {
+                            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                                uint64_t ln = history_base + (uint64_t)i;
+                                std::string_view text = history.line(ln);
+                                if (text.size() > kMaxShown) text = text.substr(0, kMaxShown);
+                                ImGui::TextDisabled("%10llu", (unsigned long long)(ln + 1));
+                                ImGui::SameLine();
+                                ImGui::TextUnformatted(text.data(), text.data() + text.size());
+                            }
+                        }
+                        clipper.End();
+                        // En los bordes de la ventana se desplaza media ventana sin
+                        // mover lo que se ve
+                        float y = ImGui::GetScrollY();
+                        if (jumped) {
+                            // el scroll nuevo se aplica en el siguiente frame
+                        } else if (y < lh && history_base > 0) {
+                            uint64_t shift = std::min<uint64_t>(history_base, kWindow / 2);
+                            history_base -= shift;
+                            ImGui::SetScrollY(y + (float)shift * lh);
+                        } else if (y > ImGui::GetScrollMaxY() - lh && history_base + shown < n) {
+                            uint64_t shift = std::min<uint64_t>(n - history_base - shown, kWindow / 2);
+                            history_base += shift;
+                            ImGui::SetScrollY(y - (float)shift * lh);
+                        }
+                        ImGui::EndChild();
+                    }
+                }
+            }
+            ImGui::End();
+        }
+
+        if (show_tree) {
+            ImGui::SetNextWindowSize(ImVec2(900, 500), ImGuiCond_FirstUseEver);
+            if (ImGui::Begin("Explorar manifiesto", &show_tree)) {
+                std::string current = manifest_tree.is_open() ? manifest_tree.repo().string() : "(elegir)";
+                if (ImGui::BeginCombo("Repo", current.c_str())) {
+                    for (auto& r : repos)
+                        if (ImGui::Selectable(r.string().c_str(), manifest_tree.is_open() && r == manifest_tree.repo()))
+                            manifest_tree.open(r, latest_verify_log(), log_text);
+                    ImGui::EndCombo();
+                }
+                if (manifest_tree.is_open() && !manifest_tree.ready()) {
+                    ImGui::Text("Cargando y ordenando hashes.md5...");
+                } else if (manifest_tree.ready()) {
+                    manifest_tree.take_log(log_text);
+                    ImGui::Text("%zu archivos; estados de la última verificación del historial", manifest_tree.entries());
+                    const ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY |
+                                                  ImGuiTableFlags_Resizable;
+                    if (ImGui::BeginTable("ManifestTree", 4, flags)) {
+                        ImGui::TableSetupScrollFreeze(0, 1);
+                        ImGui::TableSetupColumn("Nombre", ImGuiTableColumnFlags_WidthStretch);
+                        ImGui::TableSetupColumn("Estado", ImGuiTableColumnFlags_WidthFixed, 110);
+                        ImGui::TableSetupColumn("Tamaño", ImGuiTableColumnFlags_WidthFixed, 110);
+                        ImGui::TableSetupColumn("Digest", ImGuiTableColumnFlags_WidthFixed, 280);
+                        ImGui::TableHeadersRow();
+                        // Solo se dibujan las filas visibles; expandir o colapsar
+                        // se aplica después de recorrerlas
+                        const auto& rows = manifest_tree.rows();
+                        size_t toggled = rows.size();
+                        ImGuiListClipper clipper;
+                        clipper.Begin((int)rows.size());
+                        while (clipper.Step()) {
+                            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                                const ManifestTree::Row& r = rows[(size_t)i];
+                                ImGui::TableNextRow();
+                                ImGui::TableNextColumn();
+                                ImGui::PushID(i);
+                                float indent = 16.0f * (float)r.depth;
+                                if (r.depth) ImGui::Indent(indent);
+                                std::string label(manifest_tree.expanded(r) ? "[-] " : r.dir ? "[+] " : "");
+                                label += manifest_tree.name(r);
+                                if (r.dir) {
+                                    if (ImGui::Selectable(label.c_str())) toggled = (size_t)i;
+                                } else {
+                                    ImGui::TextUnformatted(label.c_str());
+                                }
+                                if (r.depth) ImGui::Unindent(indent);
+                                ImGui::PopID();
+
+                                ImGui::TableNextColumn();
+                                const ImVec4 red(1.0f, 0.4f, 0.4f, 1.0f);
+                                if (r.dir) {
+                                    uint32_t bad = manifest_tree.dir_failures(r.id);
+                                    if (bad) ImGui::TextColored(red, "%u con fallos", bad);
+                                } else {
+                                    LineStatus st = manifest_tree.status(r.id);
+                                    if (st == LineStatus::Other) ImGui::TextDisabled("-");
+                                    else if (st == LineStatus::Ok) ImGui::Text("OK");
+                                    else ImGui::TextColored(red, "%s", line_status_name(st));
+                                }
+
+                                ImGui::TableNextColumn();
+                                if (r.dir) {
+                                    ImGui::TextDisabled("%u archivos", manifest_tree.dir_files(r.id));
+                                } else {
+                                    int64_t size = manifest_tree.file_size(r.id);
+                                    if (size < 0) ImGui::TextColored(red, "falta");
+                                    else ImGui::Text("%s", format_bytes((uint64_t)size).c_str());
+                                }
+
+                                ImGui::TableNextColumn();
+                                if (!r.dir) {
+                                    std::string_view d = manifest_tree.digest(r.id);
+                                    ImGui::TextUnformatted(d.data(), d.data() + d.size());
+                                }
+                            }
+                        }
+                        clipper.End();
+                        ImGui::EndTable();
+                        if (toggled < rows.size()) manifest_tree.toggle(toggled);
+                    }
+                }
+            }
+            ImGui::End();
+        }
+
+        if (show_memory) {
+            ImGui::SetNextWindowSize(ImVec2(520, 360), ImGuiCond_FirstUseEver);
+            if (ImGui::Begin("Memoria", &show_memory)) {
+                // Los tamaños se recorren (el índice del historial tiene un
+                // vector por trigrama): dos veces por segundo basta
+                double now = ImGui::GetTime();
+                if (now - memory_at > 0.5) {
+                    memory_at = now;
+                    mem_set_buffer("log", log_text.capacity());
+                    mem_set_buffer("pool de E/S", BufferPool::shared().bytes());
+                    mem_set_buffer("historial (mapeado)", history.is_open() ? history.size_bytes() : 0);
+                    mem_set_buffer("índice de búsqueda", history_index.memory_bytes());
+                    mem_set_buffer("árbol de manifiesto", manifest_tree.memory_bytes());
+                }
+                MemSnapshot snap = mem_snapshot();
+                ImGui::Text("RSS: %s   pico de la ejecución: %s", snap.rss ? format_bytes(snap.rss).c_str() : "n/d",
+                            snap.peak_rss ? format_bytes(snap.peak_rss).c_str() : "n/d");
+                if (!mem_accounting_enabled()) {
+                    ImGui::TextDisabled("Contabilidad por fase desactivada");
+                } else {
+                    ImGui::Text("Heap neto: %s%s (pico %s)", snap.heap_net < 0 ? "-" : "+",
+                                format_bytes((uint64_t)(snap.heap_net < 0 ? -snap.heap_net : snap.heap_net)).c_str(),
+                                format_bytes((uint64_t)std::max<int64_t>(0, snap.heap_peak)).c_str());
+                    if (ImGui::BeginTable("MemPhases", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                        ImGui::TableSetupColumn("Fase");
+                        ImGui::TableSetupColumn("Asignaciones");
+                        ImGui::TableSetupColumn("Bytes");
+                        ImGui::TableSetupColumn("Liberaciones");
+                        ImGui::TableHeadersRow();
+                        for (int i = 0; i <= (int)Phase::Count; ++i) {
+                            const MemPhaseStats& p = snap.phases[i];
+                            ImGui::TableNextRow();
+                            ImGui::TableNextColumn();
+                            ImGui::TextUnformatted(i < (int)Phase::Count ? phase_name((Phase)i) : "otros");
+                            ImGui::TableNextColumn();
+                            ImGui::Text("%llu", (unsigned long long)p.allocs);
+                            ImGui::TableNextColumn();
+                            ImGui::TextUnformatted(format_bytes(p.bytes).c_str());
+                            ImGui::TableNextColumn();
+                            ImGui::Text("%llu", (unsigned long long)p.frees);
+                        }
+                        ImGui::EndTable();
+                    }
+                }
+                ImGui::Separator();
+                ImGui::Text("Buffers");
+                for (auto& b : mem_buffers()) ImGui::BulletText("%s: %s", b.first.c_str(), format_bytes(b.second).c_str());
+            }
+            ImGui::End();
+        }
+
+        ui_prof.stop(UiProfiler::Windows);
+
+        if (ui_prof.enabled()) {
+            // Esquina superior derecha, sin decoración ni foco: no tapa el
+            // trabajo y se lee de un vistazo
+            ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x - 10.0f, 10.0f), ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+            ImGui::SetNextWindowBgAlpha(0.8f);
+            const ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                                           ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing |
+                                           ImGuiWindowFlags_NoNav;
+            if (ImGui::Begin("Perfil de la interfaz", nullptr, flags)) {
+                ImGui::Text("Frame: %.2f ms (media %.2f, máx %.2f en %zu frames)", ui_prof.last_frame(),
+                            ui_prof.average_frame(), ui_prof.max_frame(), ui_prof.count());
+                char overlay[32];
+                std::snprintf(overlay, sizeof(overlay), "%.1f ms", ui_prof.last_frame());
+                ImGui::PlotLines("##frames", ui_prof.frames(), (int)ui_prof.count(), (int)ui_prof.offset(), overlay, 0.0f,
+                                 std::max(33.3f, ui_prof.max_frame()), ImVec2(320, 50));
+                float buckets[UiProfiler::kBucketCount];
+                ui_prof.histogram(buckets);
+                ImGui::PlotHistogram("##hist", buckets, UiProfiler::kBucketCount, 0, nullptr, 0.0f, FLT_MAX,
+                                     ImVec2(320, 50));
+                std::string legend;
+                for (float b : UiProfiler::kBuckets) legend += "<" + std::to_string((int)(b + 0.5f)) + " ";
+                ImGui::TextDisabled("ms: %s>=250", legend.c_str());
+                if (ImGui::BeginTable("UiSections", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+                    ImGui::TableSetupColumn("Sección");
+                    ImGui::TableSetupColumn("Último");
+                    ImGui::TableSetupColumn("Media");
+                    ImGui::TableSetupColumn("En el peor");
+                    ImGui::TableHeadersRow();
+                    for (int i = 0; i < UiProfiler::kSections; ++i) {
+                        auto sec = (UiProfiler::Section)i;
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::TextUnformatted(UiProfiler::section_name(sec));
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.2f ms", ui_prof.last(sec));
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.2f ms", ui_prof.average(sec));
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.2f ms", ui_prof.worst(sec));
+                    }
+                    ImGui::EndTable();
+                }
+                ImGui::TextDisabled("Peor frame: %.2f ms; el render incluye la espera de vsync", ui_prof.worst_frame());
+            }
+            ImGui::End();
+        }
+
         // Rendering
+        ui_prof.start(UiProfiler::Render);
         ImGui::Render();
         int display_w, display_h;
         SDL_GL_GetDrawableSize(window, &display_w, &display_h);
@@ -338,6 +1359,7 @@ int main(int, char**)
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         SDL_GL_SwapWindow(window);
+        ui_prof.stop(UiProfiler::Render);
     }
 
     // Cleanup
@@ -0,0 +1,78 @@
+// src/manifest.cpp
+
+#include "manifest.h"
+#include "perf_counters.h"
+
+#include <fstream>
+
+bool is_manifest_artifact(const std::string& rel) {
+    for (const char* f : kManifestArtifacts)
+        if (rel == f) return true;
+    return false;
+}
+
+fs::path signed_document(const fs::path& repo) {
+    fs::path tree = repo / "hashes.tree";
+    return fs::exists(tree) ? tree : repo / "hashes.md5";
+}
+
+bool manifest_excludes(const std::string& rel) {
+    if (rel.rfind(".git", 0) == 0) return true; // empieza por .git
+    // hashes.verity sí tiene línea en hashes.md5, pero la añade write_verity_manifest
+    return is_manifest_artifact(rel);
+}
+
+bool parse_manifest_line(const std::string& line, ManifestEntry& e) {
+    size_t sp = line.find(' ');
+    if (sp == std::string::npos || sp + 1 >= line.size()) return false;
+    e.digest = line.substr(0, sp);
+    // md5sum usa "  " en modo texto y " *" en modo binario
+    size_t start = sp + 1;
+    if (line[start] == ' ' || line[start] == '*') ++start;
+    e.path = line.substr(start);
+    while (!e.path.empty() && (e.path.back() == '\n' || e.path.back() == '\r')) e.path.pop_back();
+    return !e.digest.empty() && !e.path.empty();
+}
+
+bool read_manifest(const fs::path& file, std::vector<ManifestEntry>& entries, std::string& out_log) {
+    return for_each_manifest_entry(file, [&](ManifestEntry&& e) { entries.push_back(std::move(e)); }, out_log);
+}
+
+bool for_each_manifest_entry(const fs::path& file, const std::function<void(ManifestEntry&&)>& fn,
+                             std::string& out_log) {
+    std::ifstream ifs(file);
+    if (!ifs.is_open()) {
+        out_log += "No se puede leer " + file.string() + "\n";
+        return false;
+    }
+    std::string line;
+    size_t lineno = 0;
+    while (std::getline(ifs, line)) {
+        ++lineno;
+        if (line.empty()) continue;
+        ManifestEntry e;
+        if (!parse_manifest_line(line, e)) {
+            out_log += file.string() + ":" + std::to_string(lineno) + ": línea mal formada\n";
+            continue;
+        }
+        fn(std::move(e));
+    }
+    // getline también para en un error de E/S: eso no es el final del archivo
+    if (ifs.bad()) {
+        out_log += "Error de lectura en " + file.string() + " tras la línea " + std::to_string(lineno) + "\n";
+        return false;
+    }
+    return true;
+}
+
+bool write_manifest(const fs::path& file, const std::vector<ManifestEntry>& entries, std::string& out_log) {
+    PhaseScope phase(Phase::Write);
+    std::ofstream ofs(file, std::ios::trunc);
+    if (!ofs.is_open()) {
+        out_log += "Error: no se puede crear " + file.string() + "\n";
+        return false;
+    }
+    for (auto& e : entries) ofs << e.digest << "  " << e.path << "\n";
+    ofs.close();
+    return true;
+}
@@ -0,0 +1,44 @@
+// src/manifest.h
+// Lectura/escritura de hashes.md5 en formato md5sum ("<hash>  ./ruta").
+
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct ManifestEntry {
+    std::string digest; // hex en minúsculas
+    std::string path;   // tal y como aparece en el manifiesto (./relpath)
+};
+
+// Lo que hashnsign deja en la raíz de cada repo: el manifiesto y sus firmas
+inline constexpr const char* kManifestArtifacts[] = {
+    "hashes.md5",  "hashes.md5.asc",  "hashes.md5.minisig",  "hashes.verity",
+    "hashes.tree", "hashes.tree.asc", "hashes.tree.minisig", "hashes.fleet", "hashes.fleet.asc",
+};
+
+bool is_manifest_artifact(const std::string& rel);
+
+// El documento que se firma: hashes.tree en modo árbol (tree_sign.h), si no
+// hashes.md5. Sus firmas son <documento>.asc y <documento>.minisig.
+fs::path signed_document(const fs::path& repo);
+
+// Rutas relativas que el recorrido no hashea: .git* y los propios manifiestos
+bool manifest_excludes(const std::string& rel);
+
+// Parsea una línea "<hash>  <ruta>" o "<hash> *<ruta>" (modo binario de md5sum).
+bool parse_manifest_line(const std::string& line, ManifestEntry& e);
+
+// Lee todas las entradas; las líneas mal formadas se anotan en out_log y se saltan.
+bool read_manifest(const fs::path& file, std::vector<ManifestEntry>& entries, std::string& out_log);
+
+// Igual que read_manifest pero sin cargarlo entero: llama a 'fn' por entrada.
+bool for_each_manifest_entry(const fs::path& file, const std::function<void(ManifestEntry&&)>& fn,
+                             std::string& out_log);
+
+// Escribe las entradas en orden, reemplazando el fichero.
+bool write_manifest(const fs::path& file, const std::vector<ManifestEntry>& entries, std::string& out_log);
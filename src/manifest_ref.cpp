@@ -0,0 +1,202 @@
+// src/manifest_ref.cpp
+
+#include "manifest_ref.h"
+#include "manifest.h"
+#include "process.h"
+
+#include <fstream>
+#include <set>
+#include <sstream>
+
+// El remoto de la rama actual, u origin
+static std::string push_remote(const fs::path& repo) {
+    std::string branch = git_line(repo, "symbolic-ref --short -q HEAD");
+    std::string remote = branch.empty() ? "" : git_line(repo, "config --get " + shell_quote("branch." + branch + ".remote"));
+    return remote.empty() ? "origin" : remote;
+}
+
+static void exclude_artifacts(const fs::path& repo) {
+    std::string info = git_line(repo, "rev-parse --git-path info/exclude");
+    if (info.empty()) return;
+    fs::path exclude = fs::path(info).is_absolute() ? fs::path(info) : repo / info;
+    std::string have;
+    {
+        std::ifstream ifs(exclude);
+        std::stringstream ss;
+        ss << ifs.rdbuf();
+        have = ss.str();
+    }
+    std::string add;
+    for (const char* f : kManifestArtifacts) {
+        std::string line = std::string("/") + f;
+        if (("\n" + have).find("\n" + line + "\n") == std::string::npos) add += line + "\n";
+    }
+    if (add.empty()) return;
+    std::error_code ec;
+    fs::create_directories(exclude.parent_path(), ec);
+    std::ofstream ofs(exclude, std::ios::app);
+    if (!have.empty() && have.back() != '\n') ofs << "\n";
+    ofs << add;
+}
+
+bool manifest_ref_publish(const fs::path& repo, bool push, std::string& out_log) {
+    std::string git = git_cmd(repo);
+    std::string tree_input;
+    for (const char* f : kManifestArtifacts) {
+        if (!fs::exists(repo / f)) continue;
+        auto [rc, out] = run_command_stdout(git + "hash-object -w -- " + shell_quote(f));
+        if (rc != 0) {
+            out_log += "git hash-object falló para " + (repo / f).string() + "\n";
+            return false;
+        }
+        tree_input += " " + shell_quote("100644 blob " + trim(out) + "\t" + f);
+    }
+    if (tree_input.empty()) {
+        out_log += "No hay manifiesto que guardar en " + repo.string() + "\n";
+        return false;
+    }
+    auto [rc_t, tree_out] = run_command_stdout("printf '%s\\n'" + tree_input + " | " + git + "mktree");
+    std::string tree = trim(tree_out);
+    if (rc_t != 0 || tree.empty()) {
+        out_log += "git mktree falló en " + repo.string() + "\n";
+        return false;
+    }
+
+    std::string parent = git_line(repo, std::string("rev-parse --verify -q ") + kManifestRef);
+    if (!parent.empty() && git_line(repo, "rev-parse " + parent + "^{tree}") == tree) {
+        out_log += "Manifiesto sin cambios en " + std::string(kManifestRef) + " (" + repo.string() + ")\n";
+    } else {
+        std::string head = git_line(repo, "rev-parse --verify -q HEAD");
+        std::string cmd = "commit-tree " + tree;
+        if (!parent.empty()) cmd += " -p " + parent;
+        cmd += " -m " + shell_quote("hashnsign: manifiesto de " + (head.empty() ? std::string("(sin HEAD)") : head.substr(0, 12)));
+        if (!head.empty()) cmd += " -m " + shell_quote("Hashnsign-Source: " + head);
+        auto [rc_c, commit_out] = run_command_capture(git + cmd);
+        std::string commit = trim(commit_out);
+        if (rc_c != 0 || commit.empty()) {
+            out_log += commit_out + "git commit-tree falló en " + repo.string() + "\n";
+            return false;
+        }
+        // Con el valor anterior: si otro proceso movió la ref entre medias, falla
+        auto [rc_u, out_u] = run_command_capture(git + "update-ref -m hashnsign " + kManifestRef + " " + commit +
+                                                 (parent.empty() ? "" : " " + parent));
+        if (rc_u != 0) {
+            out_log += out_u + "git update-ref falló en " + repo.string() + "\n";
+            return false;
+        }
+        out_log += "Guardado en " + std::string(kManifestRef) + ": " + commit.substr(0, 12) + " (" + repo.string() + ")\n";
+    }
+    exclude_artifacts(repo);
+
+    if (!push) return true;
+    std::string remote = push_remote(repo);
+    auto [rc_p, out_p] = run_command_capture(git + "push -q " + shell_quote(remote) + " " + kManifestRef + ":" +
+                                             kManifestRef);
+    out_log += out_p;
+    if (rc_p != 0) {
+        out_log += "git push de " + std::string(kManifestRef) + " falló en " + repo.string() + "\n";
+        return false;
+    }
+    out_log += "Push OK (" + std::string(kManifestRef) + ") para " + repo.string() + "\n";
+    return true;
+}
+
+// ¿Es 'a' antepasado de 'b' (o el mismo commit)?
+static bool is_ancestor(const fs::path& repo, const std::string& a, const std::string& b) {
+    return run_command_capture(git_cmd(repo) + "merge-base --is-ancestor " + a + " " + b).first == 0;
+}
+
+bool manifest_ref_restore(const fs::path& repo, std::string& out_log) {
+    std::string git = git_cmd(repo);
+    std::string remote = push_remote(repo);
+    // El remoto va a una ref de seguimiento, nunca encima de la local: una
+    // publicación cuyo push falló solo existe en la local
+    std::string tracking = "refs/remotes/" + remote + "/hashnsign/manifest";
+    if (run_command_capture("git check-ref-format " + shell_quote(tracking)).first != 0)
+        tracking = "refs/remotes/hashnsign/manifest";
+    // Sin remoto o sin red se usa la copia local de la ref
+    run_command_capture(git + "fetch -q " + shell_quote(remote) + " " + shell_quote(std::string("+") + kManifestRef +
+                                                                                  ":" + tracking));
+
+    std::string local = git_line(repo, std::string("rev-parse --verify -q ") + kManifestRef);
+    std::string fetched = git_line(repo, "rev-parse --verify -q " + shell_quote(tracking));
+    if (local.empty() && fetched.empty()) {
+        out_log += "No existe " + std::string(kManifestRef) + " en " + repo.string() + "\n";
+        return false;
+    }
+    if (!fetched.empty() && local != fetched) {
+        if (local.empty() || is_ancestor(repo, local, fetched)) {
+            // Avance rápido: el remoto tiene publicaciones que aquí no estaban
+            auto [rc_u, out_u] = run_command_capture(git + "update-ref -m hashnsign " + kManifestRef + " " + fetched +
+                                                     (local.empty() ? "" : " " + local));
+            if (rc_u != 0) {
+                out_log += out_u + "git update-ref falló en " + repo.string() + "\n";
+                return false;
+            }
+        } else if (is_ancestor(repo, fetched, local)) {
+            // Lo local es más nuevo (y es lo que hay en el árbol de trabajo)
+            out_log += std::string(kManifestRef) + " local va por delante de " + remote +
+                       " (¿falló el push?): se verifican los archivos del árbol de trabajo en " + repo.string() + "\n";
+            return true;
+        } else {
+            out_log += std::string(kManifestRef) + " local y el de " + remote + " han divergido en " + repo.string() +
+                       ": no se toca el árbol de trabajo\n";
+            return false;
+        }
+    }
+    auto [rc, listing] = run_command_stdout(git + "ls-tree -z " + kManifestRef);
+    if (rc != 0) {
+        out_log += "No existe " + std::string(kManifestRef) + " en " + repo.string() + "\n";
+        return false;
+    }
+    // "<modo> <tipo> <id>\t<nombre>\0"
+    size_t pos = 0;
+    std::set<std::string> restored;
+    while (pos < listing.size()) {
+        size_t end = listing.find('\0', pos);
+        if (end == std::string::npos) end = listing.size();
+        std::string rec = listing.substr(pos, end - pos);
+        pos = end + 1;
+        size_t tab = rec.find('\t');
+        if (tab == std::string::npos) continue;
+        std::istringstream meta(rec.substr(0, tab));
+        std::string mode, type, id, name = rec.substr(tab + 1);
+        meta >> mode >> type >> id;
+        // Solo nombres conocidos: la ref viene del remoto
+        if (type != "blob" || !is_manifest_artifact(name)) continue;
+        auto [rc_b, data] = run_command_stdout(git + "cat-file blob " + id);
+        if (rc_b != 0) {
+            out_log += "git cat-file falló para " + name + " en " + repo.string() + "\n";
+            return false;
+        }
+        std::ofstream ofs(repo / name, std::ios::binary | std::ios::trunc);
+        ofs << data;
+        if (!ofs) {
+            out_log += "Error: no se puede escribir " + (repo / name).string() + "\n";
+            return false;
+        }
+        restored.insert(name);
+    }
+    // Lo que no está en la ref es de otra publicación (p.ej. un .asc anterior
+    // a pasar a Ed25519) y tendría prioridad al verificar
+    std::error_code ec;
+    for (const char* f : kManifestArtifacts)
+        if (!restored.count(f)) fs::remove(repo / f, ec);
+    exclude_artifacts(repo);
+    out_log += "Leídos " + std::to_string(restored.size()) + " archivos de " + kManifestRef + " en " + repo.string() + "\n";
+    return !restored.empty();
+}
+
+bool manifest_ref_source(const fs::path& repo, std::string& source_commit, std::string& manifest_blob) {
+    std::string ref = kManifestRef;
+    if (git_line(repo, "rev-parse --verify -q " + ref).empty()) return false;
+    auto [rc, body] = run_command_stdout(git_cmd(repo) + "log -1 --format=%B " + ref + " --");
+    if (rc != 0) return false;
+    std::istringstream iss(body);
+    std::string line;
+    source_commit.clear();
+    while (std::getline(iss, line))
+        if (line.rfind("Hashnsign-Source: ", 0) == 0) source_commit = trim(line.substr(18));
+    manifest_blob = git_line(repo, "rev-parse --verify -q " + ref + ":hashes.md5");
+    return !source_commit.empty() && !manifest_blob.empty();
+}
@@ -0,0 +1,33 @@
+// src/manifest_ref.h
+// Manifiesto y firmas guardados en una ref propia (refs/hashnsign/manifest) en
+// vez de en un commit de la rama: se escriben como blobs directamente en la
+// base de objetos (hash-object, mktree, commit-tree, update-ref), así que no
+// hay commits nuevos en la rama, no salta la CI y un checkout no trae los
+// archivos. Cada publicación es un commit hijo de la anterior con el commit
+// de origen anotado ("Hashnsign-Source: <HEAD>"), de modo que el push es
+// fast-forward y el oráculo GitDiff sabe desde dónde comparar.
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+inline constexpr const char* kManifestRef = "refs/hashnsign/manifest";
+
+// Guarda los kManifestArtifacts que existan en 'repo' como un commit nuevo de
+// kManifestRef y, con 'push', lo sube al remoto de la rama actual. Los
+// archivos quedan en .git/info/exclude para que no aparezcan como sin seguir.
+bool manifest_ref_publish(const fs::path& repo, bool push, std::string& out_log);
+
+// Trae kManifestRef del remoto (si se puede) a refs/remotes/<remoto>/..., la
+// local avanza si es antepasada de la traída, y escribe sus archivos en el
+// árbol de trabajo para verificarlos. Si la local va por delante (un push que
+// falló) no toca el árbol de trabajo. false si la ref no existe o las dos han
+// divergido.
+bool manifest_ref_restore(const fs::path& repo, std::string& out_log);
+
+// Commit del que salió el último manifiesto guardado y id del blob de su
+// hashes.md5
+bool manifest_ref_source(const fs::path& repo, std::string& source_commit, std::string& manifest_blob);
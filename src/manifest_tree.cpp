@@ -0,0 +1,242 @@
+// src/manifest_tree.cpp
+#include "manifest_tree.h"
+
+#include <algorithm>
+#include <chrono>
+#include <system_error>
+
+namespace {
+
+bool starts_with(std::string_view s, std::string_view pre) { return s.compare(0, pre.size(), pre) == 0; }
+
+bool is_failure(LineStatus s) { return s != LineStatus::Other && s != LineStatus::Ok; }
+
+void wait_indexed(const MappedLog& log, const std::atomic<bool>& stop) {
+    while (log.indexing() && !stop.load()) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+}
+
+} // namespace
+
+fs::path latest_verify_log() {
+    for (auto& f : list_run_logs()) {
+        std::string name = f.filename().string();
+        if (name.size() > 14 && name.compare(name.size() - 14, 14, "-verificar.log") == 0) return f;
+    }
+    return {};
+}
+
+bool ManifestTree::open(const fs::path& repo, const fs::path& status_log, std::string& out_log) {
+    close();
+    repo_ = repo;
+    fs::path manifest = repo / "hashes.md5";
+    if (!fs::exists(manifest) && fs::exists(repo / "hashes.tree")) {
+        out_log += repo.string() + ": modo árbol, no hay manifiesto que explorar\n";
+        return false;
+    }
+    if (!manifest_.open(manifest, out_log)) return false;
+    loader_ = std::thread([this, status_log] { load(status_log); });
+    return true;
+}
+
+void ManifestTree::close() {
+    stop_.store(true);
+    if (loader_.joinable()) loader_.join();
+    stop_.store(false);
+    ready_.store(false);
+    manifest_.close();
+    entries_.clear();
+    bad_prefix_.clear();
+    dirs_.clear();
+    rows_.clear();
+    sizes_.clear();
+    std::lock_guard<std::mutex> lk(log_mu_);
+    load_log_.clear();
+}
+
+void ManifestTree::take_log(std::string& out_log) {
+    std::lock_guard<std::mutex> lk(log_mu_);
+    out_log += load_log_;
+    load_log_.clear();
+}
+
+std::string_view ManifestTree::path(uint32_t entry) const {
+    const Entry& e = entries_[entry];
+    return std::string_view(e.line + e.path_off, e.path_len);
+}
+
+std::string_view ManifestTree::digest(uint32_t entry) const {
+    const Entry& e = entries_[entry];
+    return std::string_view(e.line, e.digest_len);
+}
+
+void ManifestTree::load(fs::path status_log) {
+    wait_indexed(manifest_, stop_);
+    if (stop_.load()) return;
+
+    // Mismo formato que parse_manifest_line, pero sin copiar nada
+    uint64_t bad_lines = 0;
+    entries_.reserve(manifest_.lines());
+    manifest_.for_each_line(0, manifest_.lines(), [&](uint64_t, std::string_view t) {
+        size_t sp = t.find(' ');
+        if (sp == std::string_view::npos || sp + 1 >= t.size() || sp > 255) {
+            if (!t.empty()) ++bad_lines;
+            return true;
+        }
+        size_t start = sp + 1;
+        if (t[start] == ' ' || t[start] == '*') ++start;
+        if (t.compare(start, 2, "./") == 0) start += 2;
+        if (start >= t.size() || start > 0xffff) {
+            ++bad_lines;
+            return true;
+        }
+        entries_.push_back(Entry{ t.data(), (uint32_t)(t.size() - start), (uint16_t)start, (uint8_t)sp, 0 });
+        return !stop_.load();
+    });
+    if (stop_.load()) return;
+
+    // hashes.md5 sale en el orden del recorrido; ordenado, cada directorio es
+    // un rango contiguo
+    auto by_path = [this](const Entry& a, const Entry& b) {
+        return std::string_view(a.line + a.path_off, a.path_len) < std::string_view(b.line + b.path_off, b.path_len);
+    };
+    if (!std::is_sorted(entries_.begin(), entries_.end(), by_path))
+        std::sort(entries_.begin(), entries_.end(), by_path);
+    if (stop_.load()) return;
+
+    if (!status_log.empty()) apply_statuses(status_log);
+    bad_prefix_.assign(entries_.size() + 1, 0);
+    for (size_t i = 0; i < entries_.size(); ++i)
+        bad_prefix_[i + 1] = bad_prefix_[i] + (is_failure((LineStatus)entries_[i].status) ? 1 : 0);
+
+    dirs_.push_back(Dir{ 0, (uint32_t)entries_.size(), 0, 0, true, false, {} });
+    list_children(0, 0);
+    rows_ = dirs_[0].children;
+    if (bad_lines) {
+        std::lock_guard<std::mutex> lk(log_mu_);
+        load_log_ += repo_.string() + "/hashes.md5: " + std::to_string(bad_lines) + " líneas mal formadas\n";
+    }
+    ready_.store(true, std::memory_order_release);
+}
+
+// Estados del repo en un log de verificación: las líneas "./ruta: ..." tras
+// "Verificando: <repo>" y las "<repo>/ruta: ..." de la verificación
+// multiproceso
+void ManifestTree::apply_statuses(const fs::path& log_file) {
+    MappedLog log;
+    std::string tmp;
+    if (!log.open(log_file, tmp)) {
+        std::lock_guard<std::mutex> lk(log_mu_);
+        load_log_ += tmp;
+        return;
+    }
+    wait_indexed(log, stop_);
+    std::string repo = repo_.string();
+    std::string shard_prefix = repo + "/";
+    bool in_repo = false;
+    log.for_each_line(0, log.lines(), [&](uint64_t, std::string_view t) {
+        if (starts_with(t, "=== ")) {
+            in_repo = false;
+            return true;
+        }
+        if (starts_with(t, "Verificando: ")) {
+            in_repo = t.substr(13) == repo;
+            return true;
+        }
+        std::string_view p;
+        LineStatus st = classify_log_line(t, p);
+        if (p.empty()) return true;
+        if (in_repo && starts_with(p, "./")) p.remove_prefix(2);
+        else if (starts_with(p, shard_prefix)) p.remove_prefix(shard_prefix.size());
+        else return true;
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), p, [](const Entry& e, std::string_view key) {
+            return std::string_view(e.line + e.path_off, e.path_len) < key;
+        });
+        if (it != entries_.end() && std::string_view(it->line + it->path_off, it->path_len) == p) it->status = (uint8_t)st;
+        return !stop_.load();
+    });
+}
+
+// Hijos directos: los archivos del rango que no tienen más barras y, por
+// cada subdirectorio, un nodo cuyo rango se encuentra por búsqueda binaria
+void ManifestTree::list_children(uint32_t dir, uint16_t depth) {
+    uint32_t lo = dirs_[dir].lo, hi = dirs_[dir].hi, prefix_len = dirs_[dir].prefix_len;
+    std::vector<Row> children;
+    uint32_t i = lo;
+    while (i < hi) {
+        std::string_view p = path(i);
+        size_t slash = p.find('/', prefix_len);
+        if (slash == std::string_view::npos) {
+            children.push_back(Row{ i, depth, false });
+            ++i;
+            continue;
+        }
+        std::string_view prefix = p.substr(0, slash + 1);
+        auto end = std::partition_point(entries_.begin() + i, entries_.begin() + hi, [&](const Entry& e) {
+            return starts_with(std::string_view(e.line + e.path_off, e.path_len), prefix);
+        });
+        uint32_t j = (uint32_t)(end - entries_.begin());
+        children.push_back(Row{ (uint32_t)dirs_.size(), depth, true });
+        dirs_.push_back(Dir{ i, j, (uint32_t)(slash + 1), prefix_len, false, false, {} });
+        i = j;
+    }
+    dirs_[dir].children = std::move(children);
+    dirs_[dir].listed = true;
+}
+
+// Filas que se ven bajo un directorio expandido, respetando lo que ya
+// estuviera expandido dentro
+void ManifestTree::visible_rows(uint32_t dir, std::vector<Row>& out) {
+    for (const Row& r : dirs_[dir].children) {
+        out.push_back(r);
+        if (r.dir && dirs_[r.id].expanded) visible_rows(r.id, out);
+    }
+}
+
+void ManifestTree::toggle(size_t row) {
+    if (row >= rows_.size() || !rows_[row].dir) return;
+    Row r = rows_[row];
+    if (dirs_[r.id].expanded) {
+        size_t end = row + 1;
+        while (end < rows_.size() && rows_[end].depth > r.depth) ++end;
+        rows_.erase(rows_.begin() + (ptrdiff_t)row + 1, rows_.begin() + (ptrdiff_t)end);
+        dirs_[r.id].expanded = false;
+        return;
+    }
+    if (!dirs_[r.id].listed) list_children(r.id, (uint16_t)(r.depth + 1));
+    dirs_[r.id].expanded = true;
+    std::vector<Row> shown;
+    visible_rows(r.id, shown);
+    rows_.insert(rows_.begin() + (ptrdiff_t)row + 1, shown.begin(), shown.end());
+}
+
+std::string_view ManifestTree::name(const Row& r) const {
+    if (r.dir) {
+        const Dir& d = dirs_[r.id];
+        return path(d.lo).substr(d.name_off, d.prefix_len - 1 - d.name_off);
+    }
+    std::string_view p = path(r.id);
+    size_t slash = p.rfind('/');
+    return slash == std::string_view::npos ? p : p.substr(slash + 1);
+}
+
+int64_t ManifestTree::file_size(uint32_t entry) {
+    auto it = sizes_.find(entry);
+    if (it != sizes_.end()) return it->second;
+    std::error_code ec;
+    uintmax_t sz = fs::file_size(repo_ / fs::path(std::string(path(entry))), ec);
+    int64_t v = ec ? -1 : (int64_t)sz;
+    sizes_.emplace(entry, v);
+    return v;
+}
+
+uint32_t ManifestTree::dir_failures(uint32_t dir) const {
+    return bad_prefix_[dirs_[dir].hi] - bad_prefix_[dirs_[dir].lo];
+}
+
+uint64_t ManifestTree::memory_bytes() const {
+    if (!ready()) return 0;
+    uint64_t n = entries_.capacity() * sizeof(Entry) + bad_prefix_.capacity() * sizeof(uint32_t) +
+                 rows_.capacity() * sizeof(Row) + dirs_.capacity() * sizeof(Dir);
+    for (auto& d : dirs_) n += d.children.capacity() * sizeof(Row);
+    return n;
+}
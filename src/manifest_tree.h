@@ -0,0 +1,113 @@
+// src/manifest_tree.h
+// Explorador del manifiesto de un repo como árbol de directorios, con el
+// estado de la última verificación, el tamaño y el digest de cada archivo.
+//
+// hashes.md5 se abre con MappedLog (sin copiar las rutas) y en un hilo aparte
+// se ordenan sus entradas por ruta: así el contenido de cualquier directorio
+// es un rango contiguo [lo, hi) de entradas con el mismo prefijo. Los nodos
+// de directorio se crean solo al expandirlos: los hijos de un rango salen
+// saltando cada subdirectorio con una búsqueda binaria por su prefijo, sin
+// recorrer lo que hay debajo. La vista es una lista plana de filas visibles
+// que crece y encoge al expandir y colapsar, pensada para un clipper.
+
+#pragma once
+
+#include "log_search.h"
+#include "run_log.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// El log de verificación más reciente del historial ("" si no hay)
+fs::path latest_verify_log();
+
+class ManifestTree {
+public:
+    struct Row {
+        uint32_t id;    // índice del directorio (dir) o de la entrada (archivo)
+        uint16_t depth;
+        bool dir;
+    };
+
+    ManifestTree() = default;
+    ~ManifestTree() { close(); }
+    ManifestTree(const ManifestTree&) = delete;
+    ManifestTree& operator=(const ManifestTree&) = delete;
+
+    // Abre <repo>/hashes.md5 y empieza a cargarlo en segundo plano; si
+    // 'status_log' no está vacío, toma de él los estados de la verificación
+    // de este repo
+    bool open(const fs::path& repo, const fs::path& status_log, std::string& out_log);
+    void close();
+
+    bool is_open() const { return manifest_.is_open(); }
+    bool ready() const { return ready_.load(std::memory_order_acquire); }
+    const fs::path& repo() const { return repo_; }
+    // Mensajes de la carga (líneas mal formadas...); se vacía al leerlo
+    void take_log(std::string& out_log);
+
+    // Lo siguiente, solo con ready()
+    size_t entries() const { return entries_.size(); }
+    const std::vector<Row>& rows() const { return rows_; }
+    void toggle(size_t row); // expande o colapsa el directorio de la fila
+    bool expanded(const Row& r) const { return r.dir && dirs_[r.id].expanded; }
+
+    std::string_view name(const Row& r) const;
+    std::string_view path(uint32_t entry) const;
+    std::string_view digest(uint32_t entry) const;
+    LineStatus status(uint32_t entry) const { return (LineStatus)entries_[entry].status; }
+    // Tamaño en disco (stat la primera vez que se pide); -1 si no existe
+    int64_t file_size(uint32_t entry);
+    // Archivos bajo el directorio y cuántos no pasaron la verificación
+    uint32_t dir_files(uint32_t dir) const { return dirs_[dir].hi - dirs_[dir].lo; }
+    uint32_t dir_failures(uint32_t dir) const;
+
+    // Memoria de entradas, directorios y filas (0 mientras carga)
+    uint64_t memory_bytes() const;
+
+private:
+    // 16 bytes por entrada: la ruta y el digest se leen del mapeo
+    struct Entry {
+        const char* line;
+        uint32_t path_len;
+        uint16_t path_off; // desde el principio de la línea, sin el "./"
+        uint8_t digest_len;
+        uint8_t status;
+    };
+    struct Dir {
+        uint32_t lo, hi;     // entradas bajo el directorio
+        uint32_t prefix_len; // "a/b/" incluida la barra final
+        uint32_t name_off;   // el nombre es path(lo)[name_off, prefix_len - 1)
+        bool expanded;
+        bool listed;
+        std::vector<Row> children; // hijos directos, al expandirlo la primera vez
+    };
+
+    void load(fs::path status_log);
+    void apply_statuses(const fs::path& log_file);
+    void list_children(uint32_t dir, uint16_t depth);
+    void visible_rows(uint32_t dir, std::vector<Row>& out);
+
+    fs::path repo_;
+    MappedLog manifest_;
+    std::thread loader_;
+    std::atomic<bool> ready_{ false };
+    std::atomic<bool> stop_{ false };
+    std::mutex log_mu_;
+    std::string load_log_;
+
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> bad_prefix_; // fallos acumulados: bad_prefix_[i] = fallos en [0, i)
+    std::vector<Dir> dirs_;            // dirs_[0] es la raíz
+    std::vector<Row> rows_;
+    std::unordered_map<uint32_t, int64_t> sizes_;
+};
@@ -0,0 +1,218 @@
+// src/mem_stats.cpp
+#include "mem_stats.h"
+#include "hash_engine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <new>
+
+#if defined(__linux__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#elif defined(_WIN32)
+#include <malloc.h>
+#endif
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+constexpr int kOther = (int)Phase::Count;
+constexpr int kSlots = kOther + 1;
+
+// Una línea de caché por fase: los hilos de hash no se pisan con los de walk
+struct alignas(64) PhaseCounters {
+    std::atomic<uint64_t> allocs{ 0 };
+    std::atomic<uint64_t> bytes{ 0 };
+    std::atomic<uint64_t> frees{ 0 };
+};
+
+std::atomic<bool> g_enabled{ false };
+PhaseCounters g_phase[kSlots];
+std::atomic<int64_t> g_net{ 0 };
+std::atomic<int64_t> g_peak{ 0 };
+
+std::mutex g_buffers_mu;
+std::map<std::string, uint64_t>& buffers() {
+    static std::map<std::string, uint64_t> m;
+    return m;
+}
+
+size_t block_size(void* p) {
+#if defined(__linux__)
+    return malloc_usable_size(p);
+#elif defined(__APPLE__)
+    return malloc_size(p);
+#elif defined(_WIN32)
+    return _msize(p);
+#else
+    (void)p;
+    return 0;
+#endif
+}
+
+void count_alloc(void* p) {
+    if (!p || !g_enabled.load(std::memory_order_relaxed)) return;
+    int64_t n = (int64_t)block_size(p);
+    PhaseCounters& c = g_phase[t_phase >= 0 && t_phase < kOther ? t_phase : kOther];
+    c.allocs.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add((uint64_t)n, std::memory_order_relaxed);
+    int64_t net = g_net.fetch_add(n, std::memory_order_relaxed) + n;
+    int64_t peak = g_peak.load(std::memory_order_relaxed);
+    while (net > peak && !g_peak.compare_exchange_weak(peak, net, std::memory_order_relaxed)) {
+    }
+}
+
+void count_free(void* p) {
+    if (!p || !g_enabled.load(std::memory_order_relaxed)) return;
+    g_net.fetch_sub((int64_t)block_size(p), std::memory_order_relaxed);
+    g_phase[t_phase >= 0 && t_phase < kOther ? t_phase : kOther].frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* counted_alloc(std::size_t n) {
+    void* p = std::malloc(n ? n : 1);
+    count_alloc(p);
+    return p;
+}
+
+void* counted_alloc_or_throw(std::size_t n) {
+    for (;;) {
+        if (void* p = counted_alloc(n)) return p;
+        std::new_handler h = std::get_new_handler();
+        if (!h) throw std::bad_alloc();
+        h();
+    }
+}
+
+void counted_free(void* p) {
+    count_free(p);
+    std::free(p);
+}
+
+// VmRSS y VmHWM de /proc/self/status, en bytes
+#ifdef __linux__
+bool proc_status(uint64_t& rss, uint64_t& hwm) {
+    FILE* f = std::fopen("/proc/self/status", "r");
+    if (!f) return false;
+    char line[256];
+    rss = hwm = 0;
+    while (std::fgets(line, sizeof(line), f)) {
+        unsigned long long kb;
+        if (std::sscanf(line, "VmRSS: %llu kB", &kb) == 1) rss = kb << 10;
+        else if (std::sscanf(line, "VmHWM: %llu kB", &kb) == 1) hwm = kb << 10;
+    }
+    std::fclose(f);
+    return rss != 0;
+}
+#endif
+
+} // namespace
+
+// El hook: new/delete globales que cuentan cuando la contabilidad está activa
+void* operator new(std::size_t n) { return counted_alloc_or_throw(n); }
+void* operator new[](std::size_t n) { return counted_alloc_or_throw(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return counted_alloc(n); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept { return counted_alloc(n); }
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+
+void mem_accounting_enable(bool on) {
+    g_enabled.store(on, std::memory_order_relaxed);
+    set_phase_user(kPhaseMemory, on);
+}
+
+bool mem_accounting_enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+void mem_reset() {
+    for (auto& c : g_phase) {
+        c.allocs.store(0, std::memory_order_relaxed);
+        c.bytes.store(0, std::memory_order_relaxed);
+        c.frees.store(0, std::memory_order_relaxed);
+    }
+    g_net.store(0, std::memory_order_relaxed);
+    g_peak.store(0, std::memory_order_relaxed);
+#ifdef __linux__
+    // "5" reinicia VmHWM al RSS actual (Linux 4.0+)
+    if (FILE* f = std::fopen("/proc/self/clear_refs", "w")) {
+        std::fputs("5", f);
+        std::fclose(f);
+    }
+#endif
+}
+
+MemSnapshot mem_snapshot() {
+    MemSnapshot s;
+    for (int i = 0; i < kSlots; ++i) {
+        s.phases[i].allocs = g_phase[i].allocs.load(std::memory_order_relaxed);
+        s.phases[i].bytes = g_phase[i].bytes.load(std::memory_order_relaxed);
+        s.phases[i].frees = g_phase[i].frees.load(std::memory_order_relaxed);
+    }
+    s.heap_net = g_net.load(std::memory_order_relaxed);
+    s.heap_peak = g_peak.load(std::memory_order_relaxed);
+#if defined(__linux__)
+    proc_status(s.rss, s.peak_rss);
+#elif !defined(_WIN32)
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+#ifdef __APPLE__
+        s.peak_rss = (uint64_t)ru.ru_maxrss; // bytes
+#else
+        s.peak_rss = (uint64_t)ru.ru_maxrss << 10; // kB
+#endif
+    }
+#endif
+    return s;
+}
+
+void mem_set_buffer(const std::string& name, uint64_t bytes) {
+    std::lock_guard<std::mutex> lk(g_buffers_mu);
+    buffers()[name] = bytes;
+}
+
+std::vector<std::pair<std::string, uint64_t>> mem_buffers() {
+    std::lock_guard<std::mutex> lk(g_buffers_mu);
+    return std::vector<std::pair<std::string, uint64_t>>(buffers().begin(), buffers().end());
+}
+
+std::string mem_report() {
+    MemSnapshot s = mem_snapshot();
+    std::string out = "=== Memoria ===\n";
+    out += "RSS: " + (s.rss ? format_bytes(s.rss) : std::string("n/d")) +
+           ", pico: " + (s.peak_rss ? format_bytes(s.peak_rss) : std::string("n/d"));
+    if (mem_accounting_enabled()) {
+        out += ", heap neto: " + std::string(s.heap_net < 0 ? "-" : "+") +
+               format_bytes((uint64_t)(s.heap_net < 0 ? -s.heap_net : s.heap_net)) +
+               " (pico " + format_bytes((uint64_t)std::max<int64_t>(0, s.heap_peak)) + ")\n";
+        char buf[160];
+        std::snprintf(buf, sizeof(buf), "%-8s %14s %12s %14s\n", "fase", "asignaciones", "bytes", "liberaciones");
+        out += buf;
+        for (int i = 0; i < kSlots; ++i) {
+            const MemPhaseStats& p = s.phases[i];
+            if (!p.allocs && !p.frees) continue;
+            std::snprintf(buf, sizeof(buf), "%-8s %14llu %12s %14llu\n", i < kOther ? phase_name((Phase)i) : "otros",
+                          (unsigned long long)p.allocs, format_bytes(p.bytes).c_str(), (unsigned long long)p.frees);
+            out += buf;
+        }
+    } else {
+        out += "\n";
+    }
+    auto bufs = mem_buffers();
+    if (!bufs.empty()) {
+        out += "Buffers:";
+        for (size_t i = 0; i < bufs.size(); ++i)
+            out += (i ? ", " : " ") + bufs[i].first + " " + format_bytes(bufs[i].second);
+        out += "\n";
+    }
+    return out;
+}
@@ -0,0 +1,48 @@
+// src/mem_stats.h
+// Contabilidad de memoria para cazar crecimientos (log_text, salidas
+// capturadas, manifiestos...) antes de que la sesión llegue a varios GB:
+//  - asignaciones y bytes por fase (perf_counters.h), contados en el
+//    operator new/delete global de este módulo; lo que ocurre fuera de una
+//    fase (interfaz, armado del log) va a "otros";
+//  - RSS actual y pico por ejecución (en Linux el pico se reinicia al
+//    empezar cada una con /proc/self/clear_refs);
+//  - tamaño de los buffers grandes, que sus dueños publican con
+//    mem_set_buffer.
+// Desactivada, cada new/delete paga una lectura de un atómico.
+
+#pragma once
+
+#include "perf_counters.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+void mem_accounting_enable(bool on);
+bool mem_accounting_enabled();
+
+struct MemPhaseStats {
+    uint64_t allocs = 0;
+    uint64_t bytes = 0; // pedidos (tamaño útil del bloque)
+    uint64_t frees = 0;
+};
+
+struct MemSnapshot {
+    MemPhaseStats phases[(int)Phase::Count + 1]; // la última es "otros"
+    int64_t heap_net = 0;   // asignado - liberado desde mem_reset
+    int64_t heap_peak = 0;  // máximo de heap_net
+    uint64_t rss = 0;       // 0 = no disponible
+    uint64_t peak_rss = 0;  // desde mem_reset donde se puede; si no, del proceso
+};
+
+// Al empezar una ejecución: contadores a cero y pico de RSS reiniciado
+void mem_reset();
+MemSnapshot mem_snapshot();
+
+// Publica (o actualiza) el tamaño de un buffer grande por nombre
+void mem_set_buffer(const std::string& name, uint64_t bytes);
+std::vector<std::pair<std::string, uint64_t>> mem_buffers();
+
+// Sección "=== Memoria ===" para el log de la ejecución
+std::string mem_report();
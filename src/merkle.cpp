@@ -0,0 +1,160 @@
+// src/merkle.cpp
+
+#include "merkle.h"
+
+MerkleHash merkle_leaf_hash(const std::string& data) {
+    Sha256 h;
+    const uint8_t prefix = 0x00;
+    h.update(&prefix, 1);
+    h.update(data.data(), data.size());
+    return h.final();
+}
+
+MerkleHash merkle_node_hash(const MerkleHash& left, const MerkleHash& right) {
+    Sha256 h;
+    const uint8_t prefix = 0x01;
+    h.update(&prefix, 1);
+    h.update(left.data(), left.size());
+    h.update(right.data(), right.size());
+    return h.final();
+}
+
+// Mayor potencia de 2 estrictamente menor que n (n >= 2)
+static uint64_t split_point(uint64_t n) {
+    uint64_t k = 1;
+    while (k << 1 < n) k <<= 1;
+    return k;
+}
+
+MerkleHash merkle_root(const std::vector<MerkleHash>& leaves, size_t begin, size_t end) {
+    size_t n = end - begin;
+    if (n == 0) return Sha256().final();
+    if (n == 1) return leaves[begin];
+    size_t k = split_point(n);
+    return merkle_node_hash(merkle_root(leaves, begin, begin + k), merkle_root(leaves, begin + k, end));
+}
+
+static void inclusion_path(const MerkleSubtreeFn& subtree, uint64_t m, uint64_t begin, uint64_t end,
+                           std::vector<MerkleHash>& out) {
+    uint64_t n = end - begin;
+    if (n <= 1) return;
+    uint64_t k = split_point(n);
+    if (m < k) {
+        inclusion_path(subtree, m, begin, begin + k, out);
+        out.push_back(subtree(begin + k, end));
+    } else {
+        inclusion_path(subtree, m - k, begin + k, end, out);
+        out.push_back(subtree(begin, begin + k));
+    }
+}
+
+std::vector<MerkleHash> merkle_inclusion_path(const MerkleSubtreeFn& subtree, uint64_t index, uint64_t size) {
+    std::vector<MerkleHash> out;
+    if (index < size) inclusion_path(subtree, index, 0, size, out);
+    return out;
+}
+
+std::vector<MerkleHash> merkle_inclusion_path(const std::vector<MerkleHash>& leaves, size_t index) {
+    return merkle_inclusion_path([&](uint64_t b, uint64_t e) { return merkle_root(leaves, b, e); }, index,
+                                 leaves.size());
+}
+
+// SUBPROOF(m, D[begin:end], b)
+static void consistency_proof(const MerkleSubtreeFn& subtree, uint64_t m, uint64_t begin, uint64_t end,
+                              bool whole, std::vector<MerkleHash>& out) {
+    uint64_t n = end - begin;
+    if (m == n) {
+        if (!whole) out.push_back(subtree(begin, end));
+        return;
+    }
+    uint64_t k = split_point(n);
+    if (m <= k) {
+        consistency_proof(subtree, m, begin, begin + k, whole, out);
+        out.push_back(subtree(begin + k, end));
+    } else {
+        consistency_proof(subtree, m - k, begin + k, end, false, out);
+        out.push_back(subtree(begin, begin + k));
+    }
+}
+
+std::vector<MerkleHash> merkle_consistency_proof(const MerkleSubtreeFn& subtree, uint64_t m, uint64_t n) {
+    std::vector<MerkleHash> out;
+    if (m > 0 && m <= n) consistency_proof(subtree, m, 0, n, true, out);
+    return out;
+}
+
+bool merkle_verify_inclusion(const MerkleHash& leaf, uint64_t index, uint64_t size,
+                             const std::vector<MerkleHash>& path, const MerkleHash& root) {
+    if (index >= size) return false;
+    uint64_t fn = index, sn = size - 1;
+    MerkleHash r = leaf;
+    for (const MerkleHash& p : path) {
+        if (sn == 0) return false;
+        if ((fn & 1) || fn == sn) {
+            r = merkle_node_hash(p, r);
+            while (!(fn & 1) && fn != 0) {
+                fn >>= 1;
+                sn >>= 1;
+            }
+        } else {
+            r = merkle_node_hash(r, p);
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+    return sn == 0 && r == root;
+}
+
+// RFC 9162 §2.1.4.2
+bool merkle_verify_consistency(uint64_t m, uint64_t n, const MerkleHash& old_root, const MerkleHash& new_root,
+                               const std::vector<MerkleHash>& proof) {
+    if (m == 0 || m > n) return false;
+    if (m == n) return proof.empty() && old_root == new_root;
+    std::vector<MerkleHash> path;
+    // Si m es potencia de 2 el árbol viejo es un subárbol entero del nuevo
+    if ((m & (m - 1)) == 0) path.push_back(old_root);
+    path.insert(path.end(), proof.begin(), proof.end());
+    if (path.empty()) return false;
+    uint64_t fn = m - 1, sn = n - 1;
+    while (fn & 1) {
+        fn >>= 1;
+        sn >>= 1;
+    }
+    MerkleHash fr = path[0], sr = path[0];
+    for (size_t i = 1; i < path.size(); ++i) {
+        if (sn == 0) return false;
+        if ((fn & 1) || fn == sn) {
+            fr = merkle_node_hash(path[i], fr);
+            sr = merkle_node_hash(path[i], sr);
+            while (!(fn & 1) && fn != 0) {
+                fn >>= 1;
+                sn >>= 1;
+            }
+        } else {
+            sr = merkle_node_hash(sr, path[i]);
+        }
+        fn >>= 1;
+        sn >>= 1;
+    }
+    return sn == 0 && fr == old_root && sr == new_root;
+}
+
+std::string merkle_hex(const MerkleHash& h) {
+    return to_hex(h.data(), h.size());
+}
+
+bool merkle_from_hex(const std::string& hex, MerkleHash& h) {
+    if (hex.size() != h.size() * 2) return false;
+    auto nib = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i < h.size(); ++i) {
+        int hi = nib(hex[2 * i]), lo = nib(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        h[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+// src/merkle.h
+// Árbol de Merkle de RFC 6962 (Certificate Transparency) sobre SHA-256:
+// hoja = SHA-256(0x00 || datos), nodo = SHA-256(0x01 || izq || der), y el
+// árbol de n hojas parte por la mayor potencia de 2 menor que n. Las pruebas
+// de inclusión son las de RFC 6962 §2.1.1 y se comprueban como en RFC 9162.
+
+#pragma once
+
+#include "hash_algos.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+using MerkleHash = Sha256::Digest;
+
+MerkleHash merkle_leaf_hash(const std::string& data);
+MerkleHash merkle_node_hash(const MerkleHash& left, const MerkleHash& right);
+
+// MTH(D[begin:end]) sobre hashes de hoja ya calculados (SHA-256("") si vacío)
+MerkleHash merkle_root(const std::vector<MerkleHash>& leaves, size_t begin, size_t end);
+inline MerkleHash merkle_root(const std::vector<MerkleHash>& leaves) {
+    return merkle_root(leaves, 0, leaves.size());
+}
+
+// PATH(index, D[n]): hermanos desde la hoja hasta la raíz
+std::vector<MerkleHash> merkle_inclusion_path(const std::vector<MerkleHash>& leaves, size_t index);
+
+bool merkle_verify_inclusion(const MerkleHash& leaf, uint64_t index, uint64_t size,
+                             const std::vector<MerkleHash>& path, const MerkleHash& root);
+
+// Las mismas pruebas sobre un árbol que no está entero en memoria:
+// 'subtree(begin, end)' da MTH(D[begin:end]) (translog.h lo saca de sus tiles)
+using MerkleSubtreeFn = std::function<MerkleHash(uint64_t begin, uint64_t end)>;
+
+std::vector<MerkleHash> merkle_inclusion_path(const MerkleSubtreeFn& subtree, uint64_t index, uint64_t size);
+
+// PROOF(m, D[n]) de RFC 6962 §2.1.2: el árbol de tamaño n extiende al de
+// tamaño m (0 < m <= n)
+std::vector<MerkleHash> merkle_consistency_proof(const MerkleSubtreeFn& subtree, uint64_t m, uint64_t n);
+
+bool merkle_verify_consistency(uint64_t m, uint64_t n, const MerkleHash& old_root, const MerkleHash& new_root,
+                               const std::vector<MerkleHash>& proof);
+
+std::string merkle_hex(const MerkleHash& h);
+bool merkle_from_hex(const std::string& hex, MerkleHash& h);
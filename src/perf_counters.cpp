@@ -0,0 +1,285 @@
+// src/perf_counters.cpp
+#include "perf_counters.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+std::atomic<unsigned> g_phase_users{ 0 };
+thread_local int t_phase = -1;
+
+namespace {
+
+enum Event { Cycles, Instructions, CacheMisses, BranchMisses, ContextSwitches, kEvents };
+constexpr const char* kEventNames[kEvents] = { "ciclos", "instrucc.", "fallos caché", "fallos salto", "cambios ctx" };
+constexpr int kPhases = (int)Phase::Count;
+
+struct PhaseTotals {
+    uint64_t ns = 0;
+    uint64_t entries = 0;
+    uint64_t ev[kEvents] = {};
+};
+
+struct ThreadCounters {
+    std::mutex mu; // el hilo suma; perf_reset y perf_report leen desde otro
+    long tid = 0;
+    bool alive = true;
+    int fds[kEvents];
+    int slot[kEvents]; // posición en la lectura del grupo, -1 = no abierto
+    int leader = -1;
+    int opened = 0;
+    uint64_t last[kEvents] = {};
+    std::chrono::steady_clock::time_point last_t;
+    int current = -1;
+    PhaseTotals totals[kPhases];
+};
+
+std::mutex g_registry_mu;
+std::vector<std::shared_ptr<ThreadCounters>> g_registry;
+std::string g_open_note; // por qué faltan contadores (una vez)
+
+uint64_t now_ns(std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count();
+}
+
+#ifdef __linux__
+int open_event(uint32_t type, uint64_t config, int group_fd, bool exclude_kernel) {
+    perf_event_attr pe;
+    std::memset(&pe, 0, sizeof(pe));
+    pe.size = sizeof(pe);
+    pe.type = type;
+    pe.config = config;
+    pe.read_format = PERF_FORMAT_GROUP;
+    pe.disabled = group_fd == -1 ? 1 : 0;
+    pe.exclude_kernel = exclude_kernel ? 1 : 0;
+    pe.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &pe, 0, -1, group_fd, 0);
+}
+
+// Abre el grupo del hilo; el primer contador que se abre es el líder. Si el
+// kernel no deja contar en modo kernel (perf_event_paranoid), solo usuario.
+void open_group(ThreadCounters& tc) {
+    static const struct {
+        uint32_t type;
+        uint64_t config;
+    } kSpec[kEvents] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+    };
+    std::string note;
+    for (bool exclude_kernel : { false, true }) {
+        tc.leader = -1;
+        tc.opened = 0;
+        for (int e = 0; e < kEvents; ++e) {
+            tc.fds[e] = open_event(kSpec[e].type, kSpec[e].config, tc.leader, exclude_kernel);
+            tc.slot[e] = tc.fds[e] >= 0 ? tc.opened++ : -1;
+            if (tc.fds[e] < 0 && note.empty())
+                note = std::string("sin ") + kEventNames[e] + ": " + std::strerror(errno);
+            if (tc.fds[e] >= 0 && tc.leader < 0) tc.leader = tc.fds[e];
+        }
+        if (tc.opened > 0) {
+            if (exclude_kernel) note = "solo modo usuario (perf_event_paranoid)" + (note.empty() ? "" : "; " + note);
+            break;
+        }
+    }
+    if (tc.leader >= 0) {
+        ioctl(tc.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(tc.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    if (!note.empty()) {
+        std::lock_guard<std::mutex> lk(g_registry_mu);
+        if (g_open_note.empty()) g_open_note = note;
+    }
+}
+
+void read_group(ThreadCounters& tc, uint64_t* values) {
+    for (int e = 0; e < kEvents; ++e) values[e] = tc.last[e];
+    if (tc.leader < 0) return;
+    uint64_t buf[1 + kEvents];
+    if (read(tc.leader, buf, sizeof(buf)) < (ssize_t)sizeof(uint64_t)) return;
+    for (int e = 0; e < kEvents; ++e)
+        if (tc.slot[e] >= 0 && (uint64_t)tc.slot[e] < buf[0]) values[e] = buf[1 + tc.slot[e]];
+}
+
+void close_group(ThreadCounters& tc) {
+    for (int e = 0; e < kEvents; ++e)
+        if (tc.fds[e] >= 0) close(tc.fds[e]);
+    tc.leader = -1;
+}
+#else
+void open_group(ThreadCounters& tc) {
+    tc.leader = -1;
+    for (int e = 0; e < kEvents; ++e) tc.slot[e] = -1;
+    std::lock_guard<std::mutex> lk(g_registry_mu);
+    if (g_open_note.empty()) g_open_note = "sin perf_event_open en esta plataforma";
+}
+void read_group(ThreadCounters& tc, uint64_t* values) {
+    for (int e = 0; e < kEvents; ++e) values[e] = tc.last[e];
+}
+void close_group(ThreadCounters&) {}
+#endif
+
+// El grupo vive lo que el hilo; lo acumulado sigue en el registro
+struct Holder {
+    std::shared_ptr<ThreadCounters> tc;
+    ~Holder() {
+        if (!tc) return;
+        std::lock_guard<std::mutex> lk(tc->mu);
+        close_group(*tc);
+        tc->alive = false;
+    }
+};
+thread_local Holder t_counters;
+
+ThreadCounters& this_thread_counters() {
+    if (!t_counters.tc) {
+        auto tc = std::make_shared<ThreadCounters>();
+        for (int e = 0; e < kEvents; ++e) tc->fds[e] = -1;
+#ifdef __linux__
+        tc->tid = (long)syscall(SYS_gettid);
+#endif
+        open_group(*tc);
+        read_group(*tc, tc->last);
+        tc->last_t = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lk(g_registry_mu);
+        g_registry.push_back(tc);
+        t_counters.tc = std::move(tc);
+    }
+    return *t_counters.tc;
+}
+
+// Suma a la fase activa lo contado desde la última lectura
+void flush(ThreadCounters& tc) {
+    uint64_t now[kEvents];
+    read_group(tc, now);
+    auto t = std::chrono::steady_clock::now();
+    if (tc.current >= 0) {
+        PhaseTotals& pt = tc.totals[tc.current];
+        pt.ns += now_ns(tc.last_t, t);
+        for (int e = 0; e < kEvents; ++e) pt.ev[e] += now[e] - tc.last[e];
+    }
+    for (int e = 0; e < kEvents; ++e) tc.last[e] = now[e];
+    tc.last_t = t;
+}
+
+void format_row(std::string& out, const char* label, const PhaseTotals& pt, const bool* have) {
+    char buf[256];
+    std::snprintf(buf, sizeof(buf), "%-22s %10.3f s %9llu", label, (double)pt.ns / 1e9, (unsigned long long)pt.entries);
+    out += buf;
+    for (int e = 0; e < kEvents; ++e) {
+        if (have[e]) std::snprintf(buf, sizeof(buf), " %14llu", (unsigned long long)pt.ev[e]);
+        else std::snprintf(buf, sizeof(buf), " %14s", "-");
+        out += buf;
+    }
+    if (have[Cycles] && have[Instructions] && pt.ev[Cycles])
+        std::snprintf(buf, sizeof(buf), " %6.2f\n", (double)pt.ev[Instructions] / (double)pt.ev[Cycles]);
+    else
+        std::snprintf(buf, sizeof(buf), " %6s\n", "-");
+    out += buf;
+}
+
+} // namespace
+
+const char* phase_name(Phase p) {
+    switch (p) {
+    case Phase::Walk: return "walk";
+    case Phase::Read: return "read";
+    case Phase::Hash: return "hash";
+    case Phase::Write: return "write";
+    case Phase::Sign: return "sign";
+    case Phase::Git: return "git";
+    default: return "?";
+    }
+}
+
+void set_phase_user(PhaseUser u, bool on) {
+    if (on) g_phase_users.fetch_or(u, std::memory_order_relaxed);
+    else g_phase_users.fetch_and(~(unsigned)u, std::memory_order_relaxed);
+}
+
+int perf_enter(Phase p) {
+    int prev = t_phase;
+    t_phase = (int)p;
+    if (!perf_enabled()) return prev;
+    ThreadCounters& tc = this_thread_counters();
+    std::lock_guard<std::mutex> lk(tc.mu);
+    flush(tc);
+    tc.current = (int)p;
+    tc.totals[tc.current].entries++;
+    return prev;
+}
+
+void perf_leave(int previous) {
+    t_phase = previous;
+    if (!perf_enabled()) return;
+    ThreadCounters& tc = this_thread_counters();
+    std::lock_guard<std::mutex> lk(tc.mu);
+    flush(tc);
+    tc.current = previous;
+}
+
+void perf_reset() {
+    std::lock_guard<std::mutex> lk(g_registry_mu);
+    std::vector<std::shared_ptr<ThreadCounters>> alive;
+    for (auto& tc : g_registry) {
+        std::lock_guard<std::mutex> tl(tc->mu);
+        if (!tc->alive) continue;
+        for (auto& pt : tc->totals) pt = PhaseTotals{};
+        alive.push_back(tc);
+    }
+    g_registry.swap(alive);
+}
+
+std::string perf_report() {
+    std::lock_guard<std::mutex> lk(g_registry_mu);
+    PhaseTotals sum[kPhases];
+    bool have[kEvents] = {};
+    std::string trace;
+    for (auto& tc : g_registry) {
+        std::lock_guard<std::mutex> tl(tc->mu);
+        bool mine[kEvents];
+        for (int e = 0; e < kEvents; ++e) {
+            mine[e] = tc->slot[e] >= 0;
+            have[e] = have[e] || mine[e];
+        }
+        for (int p = 0; p < kPhases; ++p) {
+            const PhaseTotals& pt = tc->totals[p];
+            if (!pt.entries) continue;
+            sum[p].ns += pt.ns;
+            sum[p].entries += pt.entries;
+            for (int e = 0; e < kEvents; ++e) sum[p].ev[e] += pt.ev[e];
+            char label[64];
+            std::snprintf(label, sizeof(label), "  hilo %ld %s", tc->tid, phase_name((Phase)p));
+            format_row(trace, label, pt, mine);
+        }
+    }
+
+    std::string out = "=== Contadores por fase (perf_event_open) ===\n";
+    if (!g_open_note.empty()) out += "Aviso: " + g_open_note + "\n";
+    char buf[256];
+    std::snprintf(buf, sizeof(buf), "%-22s %12s %9s", "fase", "tiempo", "entradas");
+    out += buf;
+    for (const char* n : kEventNames) {
+        std::snprintf(buf, sizeof(buf), " %14s", n);
+        out += buf;
+    }
+    out += "    IPC\n";
+    for (int p = 0; p < kPhases; ++p)
+        if (sum[p].entries) format_row(out, phase_name((Phase)p), sum[p], have);
+    if (!trace.empty()) out += "Traza por hilo:\n" + trace;
+    return out;
+}
@@ -0,0 +1,65 @@
+// src/perf_counters.h
+// Modo de instrumentación: contadores hardware por hilo (perf_event_open en
+// Linux) atribuidos a las fases de una ejecución, sin profiler externo.
+//
+// Cada hilo que entra en una fase abre, la primera vez, un grupo de
+// contadores propio: ciclos, instrucciones, fallos de caché, fallos de
+// predicción de saltos y cambios de contexto. PhaseScope lee el grupo al
+// entrar y al salir y suma la diferencia a la fase activa; las fases
+// anidadas son exclusivas (lo que pasa dentro de Hash no cuenta en Read).
+// Desactivado, PhaseScope es una comprobación de un atómico. Los procesos
+// hijos (git, gpg) no se cuentan: en Git y Sign se ve la espera del padre.
+// Donde no hay perf_event_open (Windows, kernels o contenedores que no lo
+// permiten) solo se mide el tiempo de pared por fase.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+enum class Phase : uint8_t { Walk, Read, Hash, Write, Sign, Git, Count };
+
+const char* phase_name(Phase p);
+
+// Quién necesita la fase de cada hilo: estos contadores y la contabilidad de
+// memoria (mem_stats.h). Sin ninguno, PhaseScope no hace nada.
+enum PhaseUser : unsigned { kPhaseCounters = 1, kPhaseMemory = 2 };
+extern std::atomic<unsigned> g_phase_users;
+void set_phase_user(PhaseUser u, bool on);
+
+// Fase activa del hilo (-1 = ninguna), mantenida por PhaseScope
+extern thread_local int t_phase;
+
+inline bool perf_enabled() { return g_phase_users.load(std::memory_order_relaxed) & kPhaseCounters; }
+inline void perf_enable(bool on) { set_phase_user(kPhaseCounters, on); }
+
+// Pone a cero lo acumulado (al empezar cada ejecución) y olvida los hilos
+// que ya terminaron
+void perf_reset();
+
+// Tabla por fase (todos los hilos) y traza por hilo y fase
+std::string perf_report();
+
+// Para PhaseScope: cambia la fase del hilo y devuelve la anterior (-1 = ninguna)
+int perf_enter(Phase p);
+void perf_leave(int previous);
+
+class PhaseScope {
+public:
+    explicit PhaseScope(Phase p) {
+        if (g_phase_users.load(std::memory_order_relaxed)) {
+            active_ = true;
+            prev_ = perf_enter(p);
+        }
+    }
+    ~PhaseScope() {
+        if (active_) perf_leave(prev_);
+    }
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+private:
+    bool active_ = false;
+    int prev_ = -1;
+};
@@ -0,0 +1,113 @@
+// src/process.cpp
+
+#include "process.h"
+#include "perf_counters.h"
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+static std::pair<int, std::string> popen_capture(const std::string& full_cmd) {
+    std::array<char, 4096> buffer;
+    std::string result;
+
+#ifdef _WIN32
+    // On Windows, use "bash -lc" if user wants to run in Git Bash environment:
+    // But here we call popen directly; user must ensure md5sum/gpg are in PATH for the process.
+    FILE* pipe = _popen(full_cmd.c_str(), "rb");
+#else
+    FILE* pipe = popen(full_cmd.c_str(), "r");
+#endif
+    if (!pipe) return { -1, "popen failed" };
+    size_t n;
+    while ((n = fread(buffer.data(), 1, buffer.size(), pipe)) > 0) {
+        result.append(buffer.data(), n);
+    }
+#ifdef _WIN32
+    int rc = _pclose(pipe);
+#else
+    int rc = pclose(pipe);
+#endif
+    return { rc, result };
+}
+
+// Con los contadores activos, lo que se espera a git cuenta en la fase git
+static std::pair<int, std::string> run_popen(const std::string& full_cmd) {
+    if (full_cmd.rfind("git ", 0) == 0 || full_cmd.find("&& git ") != std::string::npos) {
+        PhaseScope phase(Phase::Git);
+        return popen_capture(full_cmd);
+    }
+    return popen_capture(full_cmd);
+}
+
+std::pair<int, std::string> run_command_capture(const std::string& cmd) {
+    return run_popen(cmd + " 2>&1");
+}
+
+std::pair<int, std::string> run_command_stdout(const std::string& cmd) {
+    return run_popen(cmd);
+}
+
+std::pair<int, std::string> run_command_split(const std::string& cmd, std::string& err) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path dir = fs::temp_directory_path(ec);
+    if (ec) return { -1, "sin directorio temporal" };
+#ifdef _WIN32
+    char name[L_tmpnam_s];
+    if (tmpnam_s(name, sizeof(name)) != 0) return { -1, "tmpnam_s failed" };
+    fs::path tmp = name;
+#else
+    // mkstemp: creado en exclusiva, nadie más puede haberlo preparado
+    std::string templ = (dir / "hashnsign-stderr-XXXXXX").string();
+    int fd = mkstemp(templ.data());
+    if (fd < 0) return { -1, "mkstemp failed" };
+    close(fd);
+    fs::path tmp = templ;
+#endif
+    auto result = run_popen(cmd + " 2>" + shell_quote(tmp.string()));
+    {
+        std::ifstream ifs(tmp, std::ios::binary);
+        std::ostringstream ss;
+        ss << ifs.rdbuf();
+        err = ss.str();
+    }
+    fs::remove(tmp, ec);
+    return result;
+}
+
+std::string shell_quote(const std::string& s) {
+#ifdef _WIN32
+    return "\"" + s + "\"";
+#else
+    std::string q = "'";
+    for (char c : s) {
+        if (c == '\'') q += "'\\''";
+        else q += c;
+    }
+    return q + "'";
+#endif
+}
+
+std::string trim(const std::string& s) {
+    size_t a = s.find_first_not_of(" \t\r\n");
+    if (a == std::string::npos) return "";
+    size_t b = s.find_last_not_of(" \t\r\n");
+    return s.substr(a, b - a + 1);
+}
+
+std::string git_cmd(const std::filesystem::path& repo) {
+    return "git -C " + shell_quote(repo.string()) + " ";
+}
+
+std::string git_line(const std::filesystem::path& repo, const std::string& args) {
+    auto [rc, out] = run_command_stdout(git_cmd(repo) + args);
+    return rc == 0 ? trim(out) : std::string();
+}
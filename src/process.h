@@ -0,0 +1,33 @@
+// src/process.h
+// Lanzar comandos externos (md5sum, gpg, git) capturando su salida.
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <utility>
+
+// Ejecuta un comando y captura stdout+stderr (retorna pair: exit_code, output).
+// La captura es binaria: conserva los NUL de salidas tipo "git ... -z".
+std::pair<int, std::string> run_command_capture(const std::string& cmd);
+
+// Igual pero solo stdout; stderr va al del proceso. Útil cuando la salida se
+// parsea y un aviso de git la estropearía.
+std::pair<int, std::string> run_command_stdout(const std::string& cmd);
+
+// stdout y stderr por separado: stdout es el dato (el texto que gpg acaba de
+// verificar, por ejemplo) y 'err' el diagnóstico. stderr pasa por un archivo
+// temporal propio.
+std::pair<int, std::string> run_command_split(const std::string& cmd, std::string& err);
+
+// Comilla un argumento para /bin/sh: 'a'\''b'
+std::string shell_quote(const std::string& s);
+
+// Sin espacios ni saltos de línea a los lados
+std::string trim(const std::string& s);
+
+// "git -C '<repo>' " para anteponer a los argumentos
+std::string git_cmd(const std::filesystem::path& repo);
+
+// Salida de un comando git de una línea ("" si falla); stderr no se captura
+std::string git_line(const std::filesystem::path& repo, const std::string& args);
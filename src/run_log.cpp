@@ -0,0 +1,203 @@
+// src/run_log.cpp
+
+#include "run_log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+fs::path run_log_dir() {
+#ifdef _WIN32
+    if (const char* a = std::getenv("LOCALAPPDATA"); a && *a) return fs::path(a) / "hashnsign" / "runs";
+#else
+    if (const char* x = std::getenv("XDG_STATE_HOME"); x && *x) return fs::path(x) / "hashnsign" / "runs";
+    if (const char* h = std::getenv("HOME"); h && *h) return fs::path(h) / ".local" / "state" / "hashnsign" / "runs";
+#endif
+    return fs::path("hashnsign-runs");
+}
+
+bool RunLogWriter::open(const std::string& op) {
+    close();
+    std::error_code ec;
+    fs::path dir = run_log_dir();
+    fs::create_directories(dir, ec);
+    std::time_t now = std::time(nullptr);
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &now);
+#else
+    localtime_r(&now, &tm);
+#endif
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+    fs::path file = dir / (std::string(stamp) + "-" + op + ".log");
+    for (int n = 2; fs::exists(file, ec); ++n) file = dir / (std::string(stamp) + "-" + op + "-" + std::to_string(n) + ".log");
+    ofs_.clear();
+    ofs_.open(file, std::ios::binary | std::ios::trunc);
+    path_ = file;
+    return ofs_.is_open();
+}
+
+void RunLogWriter::write(std::string_view text) {
+    if (ofs_.is_open()) ofs_.write(text.data(), (std::streamsize)text.size());
+}
+
+fs::path RunLogWriter::close() {
+    if (!ofs_.is_open()) return {};
+    ofs_.close();
+    fs::path file = std::move(path_);
+    path_.clear();
+    return ofs_.fail() ? fs::path() : file;
+}
+
+fs::path save_run_log(const std::string& op, std::string_view text) {
+    RunLogWriter w;
+    if (!w.open(op)) return {};
+    w.write(text);
+    return w.close();
+}
+
+std::vector<fs::path> list_run_logs() {
+    std::vector<fs::path> logs;
+    std::error_code ec;
+    for (auto it = fs::directory_iterator(run_log_dir(), ec); !ec && it != fs::directory_iterator(); it.increment(ec))
+        if (it->path().extension() == ".log") logs.push_back(it->path());
+    // El nombre empieza por la fecha
+    std::sort(logs.begin(), logs.end(), [](const fs::path& a, const fs::path& b) { return a.filename() > b.filename(); });
+    return logs;
+}
+
+MappedLog::~MappedLog() {
+    close();
+}
+
+void MappedLog::close() {
+    stop_.store(true);
+    if (indexer_.joinable()) indexer_.join();
+#ifndef _WIN32
+    if (data_ && heap_.empty() && size_) munmap(const_cast<char*>(data_), size_);
+#endif
+    heap_.clear();
+    heap_.shrink_to_fit();
+    chunks_.clear();
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+    lines_.store(0);
+    scanned_.store(0);
+    done_.store(true);
+    stop_.store(false);
+}
+
+bool MappedLog::open(const fs::path& file, std::string& out_log) {
+    close();
+#ifndef _WIN32
+    int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) ::close(fd);
+        out_log += "No se puede abrir " + file.string() + "\n";
+        return false;
+    }
+    size_ = (uint64_t)st.st_size;
+    if (size_) {
+        void* m = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (m == MAP_FAILED) {
+            ::close(fd);
+            size_ = 0;
+            out_log += "mmap falló para " + file.string() + "\n";
+            return false;
+        }
+        // El índice lo recorre entero una vez, de principio a fin
+        madvise(m, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(m);
+    }
+    ::close(fd);
+#else
+    std::ifstream ifs(file, std::ios::binary);
+    if (!ifs.is_open()) {
+        out_log += "No se puede abrir " + file.string() + "\n";
+        return false;
+    }
+    heap_.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    size_ = heap_.size();
+    data_ = heap_.data();
+#endif
+    path_ = file;
+    open_ = true;
+    // Como mucho una línea por byte, más la última sin salto
+    chunks_.resize((size_ + 1) / kLineStride / kChunk + 1);
+    chunks_[0].reset(new uint64_t[kChunk]);
+    chunks_[0][0] = 0;
+    done_.store(false);
+    indexer_ = std::thread([this] { build_index(); });
+    return true;
+}
+
+void MappedLog::build_index() {
+    const char* p = data_;
+    const char* end = data_ + size_;
+    uint64_t n = 0;
+    while (p < end && !stop_.load(std::memory_order_relaxed)) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', (size_t)(end - p)));
+        p = nl ? nl + 1 : end;
+        ++n;
+        if (n % kLineStride == 0 && p < end) {
+            uint64_t k = n / kLineStride;
+            if (k % kChunk == 0) chunks_[k / kChunk].reset(new uint64_t[kChunk]);
+            chunks_[k / kChunk][k % kChunk] = (uint64_t)(p - data_);
+        }
+        // Publicar de vez en cuando: lo ya indexado se puede mostrar
+        if (n % 65536 == 0 || p == end) {
+            scanned_.store((uint64_t)(p - data_), std::memory_order_relaxed);
+            lines_.store(n, std::memory_order_release);
+        }
+    }
+    done_.store(true, std::memory_order_release);
+}
+
+// Principio de la línea 'i' (< lines())
+const char* MappedLog::line_start(uint64_t i) const {
+    const char* end = data_ + size_;
+    const char* p = data_ + checkpoint(i / kLineStride);
+    for (uint64_t skip = i % kLineStride; skip > 0; --skip) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', (size_t)(end - p)));
+        if (!nl) return end;
+        p = nl + 1;
+    }
+    return p;
+}
+
+std::string_view MappedLog::line(uint64_t i) const {
+    if (i >= lines()) return {};
+    const char* end = data_ + size_;
+    const char* p = line_start(i);
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', (size_t)(end - p)));
+    const char* e = nl ? nl : end;
+    if (e > p && e[-1] == '\r') --e;
+    return std::string_view(p, (size_t)(e - p));
+}
+
+void MappedLog::for_each_line(uint64_t first, uint64_t last,
+                              const std::function<bool(uint64_t, std::string_view)>& fn) const {
+    last = std::min(last, lines());
+    if (first >= last) return;
+    const char* end = data_ + size_;
+    const char* p = line_start(first);
+    for (uint64_t i = first; i < last && p < end; ++i) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', (size_t)(end - p)));
+        const char* e = nl ? nl : end;
+        const char* t = e > p && e[-1] == '\r' ? e - 1 : e;
+        if (!fn(i, std::string_view(p, (size_t)(t - p)))) return;
+        p = nl ? nl + 1 : end;
+    }
+}
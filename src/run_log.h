@@ -0,0 +1,98 @@
+// src/run_log.h
+// Historial de ejecuciones: el log de cada Generar/Verificar/... se guarda en
+// un archivo y se consulta después con MappedLog, que lo abre con mmap y
+// construye el índice de líneas en un hilo aparte mientras ya se puede leer.
+// El índice guarda el offset de una de cada kLineStride líneas (8 bytes cada
+// 64 líneas); una línea concreta se encuentra desde su punto de control con
+// memchr, así que ir a cualquier línea de un log de varios GB es inmediato.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// $XDG_STATE_HOME/hashnsign/runs (o ~/.local/state/...)
+fs::path run_log_dir();
+
+// Log de una ejecución que se escribe en <run_log_dir>/<AAAAMMDD-HHMMSS>-<op>.log
+// a medida que se produce: la operación no tiene que guardar toda su salida
+// en memoria hasta el final
+class RunLogWriter {
+public:
+    bool open(const std::string& op);
+    bool is_open() const { return ofs_.is_open(); }
+    void write(std::string_view text);
+    // Cierra y devuelve la ruta ("" si no se pudo abrir o escribir)
+    fs::path close();
+
+private:
+    std::ofstream ofs_;
+    fs::path path_;
+};
+
+// Guarda 'text' de una vez y devuelve la ruta ("" si no se pudo)
+fs::path save_run_log(const std::string& op, std::string_view text);
+
+// Logs guardados, el más reciente primero
+std::vector<fs::path> list_run_logs();
+
+class MappedLog {
+public:
+    static constexpr uint64_t kLineStride = 64;
+
+    MappedLog() = default;
+    ~MappedLog();
+    MappedLog(const MappedLog&) = delete;
+    MappedLog& operator=(const MappedLog&) = delete;
+
+    // Mapea 'file' y arranca el índice en segundo plano
+    bool open(const fs::path& file, std::string& out_log);
+    void close();
+
+    bool is_open() const { return open_; }
+    const fs::path& path() const { return path_; }
+    uint64_t size_bytes() const { return size_; }
+
+    // Líneas ya indexadas (crece mientras indexing()); todas son legibles
+    uint64_t lines() const { return lines_.load(std::memory_order_acquire); }
+    bool indexing() const { return !done_.load(std::memory_order_acquire); }
+    uint64_t indexed_bytes() const { return scanned_.load(std::memory_order_relaxed); }
+
+    // Texto de la línea 'i' (< lines()), sin el salto de línea
+    std::string_view line(uint64_t i) const;
+
+    // Recorre en orden las líneas [first, last) (last <= lines()); para si
+    // 'fn' devuelve false
+    void for_each_line(uint64_t first, uint64_t last, const std::function<bool(uint64_t, std::string_view)>& fn) const;
+
+private:
+    static constexpr uint64_t kChunk = 4096; // puntos de control por bloque
+
+    void build_index();
+    const char* line_start(uint64_t i) const;
+    uint64_t checkpoint(uint64_t k) const { return chunks_[k / kChunk][k % kChunk]; }
+
+    fs::path path_;
+    bool open_ = false;
+    const char* data_ = nullptr;
+    uint64_t size_ = 0;
+    std::vector<char> heap_; // donde no hay mmap
+    // Bloques de tamaño fijo reservados de antemano: el hilo del índice los
+    // rellena sin mover nada que el de la interfaz pueda estar leyendo
+    std::vector<std::unique_ptr<uint64_t[]>> chunks_;
+    std::atomic<uint64_t> lines_{ 0 };
+    std::atomic<uint64_t> scanned_{ 0 };
+    std::atomic<bool> done_{ true };
+    std::atomic<bool> stop_{ false };
+    std::thread indexer_;
+};
@@ -0,0 +1,514 @@
+// src/shard_verify.cpp
+//
+// Protocolo (texto, una orden por línea):
+//   coordinador -> worker:  "shard <i> <n>",
+//                           "opt <algo> <backend> <sparse> <huge> <numa> <threads> <cache> <resume>
+//                            <retries>",
+//                           "repo <ruta>"..., "end"
+//   worker -> coordinador:  "F\t<repo>\t<FAILED|UNREADABLE>\t<ruta>\t<error>"  por archivo malo
+//                           "C\t<repo>\t<ok>\t<failed>\t<unreadable>\t<bytes>"   al terminar cada repo
+//                           "M\t<repo>"                                           si falta hashes.md5
+//                           "E\t<repo>\t<error>"                                  si no se pudo leer
+//                           "W\t<repo>\t<aviso>"                                  líneas mal formadas...
+//                           "done"
+// Repos, rutas y mensajes van escapados (\\ \t \n \r): una ruta con un
+// tabulador o un salto de línea no rompe el registro.
+// Solo viajan los fallos y los contadores: con manifiestos de ~1 GB el
+// coordinador nunca carga las entradas, cada worker lee los manifiestos y se
+// queda con las suyas (hash de la ruta módulo n).
+
+#include "shard_verify.h"
+#include "manifest.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Archivos por llamada a hash_files en el worker: acota la memoria aunque el
+// manifiesto tenga millones de líneas
+static constexpr size_t kWorkerBatch = 4096;
+
+// FNV-1a: reparto estable de rutas entre shards
+static uint64_t path_shard_hash(const std::string& s) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Un campo del protocolo: sin tabuladores ni saltos de línea en crudo
+static std::string escape_field(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s) {
+        switch (c) {
+        case '\\': out += "\\\\"; break;
+        case '\t': out += "\\t"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        default: out += c;
+        }
+    }
+    return out;
+}
+
+static std::string unescape_field(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] != '\\' || i + 1 == s.size()) {
+            out += s[i];
+            continue;
+        }
+        char c = s[++i];
+        out += c == 't' ? '\t' : c == 'n' ? '\n' : c == 'r' ? '\r' : c;
+    }
+    return out;
+}
+
+// Campos de un registro, ya sin escapar
+static std::vector<std::string> split_tabs(const std::string& line) {
+    std::vector<std::string> f;
+    size_t pos = 0;
+    for (;;) {
+        size_t tab = line.find('\t', pos);
+        f.push_back(unescape_field(line.substr(pos, tab == std::string::npos ? std::string::npos : tab - pos)));
+        if (tab == std::string::npos) break;
+        pos = tab + 1;
+    }
+    return f;
+}
+
+// Entero sin signo de la salida de un worker; lo mal formado no se acepta
+// (la salida viene de otro proceso, quizá de otra máquina)
+static bool parse_u64(const std::string& s, uint64_t& v) {
+    if (s.empty() || s[0] < '0' || s[0] > '9') return false;
+    errno = 0;
+    char* end = nullptr;
+    unsigned long long n = std::strtoull(s.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0') return false;
+    v = n;
+    return true;
+}
+
+// ------------------------------------------------------------------ worker
+
+static void verify_batch(const std::string& repo, std::vector<ManifestEntry>& batch, const HashOptions& opts,
+                         RepoVerifyResult& r, FILE* out) {
+    std::vector<HashJob> jobs;
+    jobs.reserve(batch.size());
+    for (auto& e : batch) jobs.push_back(HashJob(fs::path(repo) / e.path));
+    HashStats stats;
+    hash_files(jobs, opts, stats);
+    r.bytes_read += stats.bytes_read;
+    std::string erepo = escape_field(repo);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (!jobs[i].ok) {
+            ++r.unreadable;
+            std::fprintf(out, "F\t%s\tUNREADABLE\t%s\t%s\n", erepo.c_str(), escape_field(batch[i].path).c_str(),
+                         escape_field(jobs[i].err).c_str());
+        } else if (jobs[i].hex != batch[i].digest) {
+            ++r.failed;
+            std::fprintf(out, "F\t%s\tFAILED\t%s\t\n", erepo.c_str(), escape_field(batch[i].path).c_str());
+        } else {
+            ++r.ok;
+        }
+    }
+    batch.clear();
+}
+
+int run_verify_shard_worker(FILE* in, FILE* out) {
+    uint64_t index = 0, count = 1;
+    HashOptions opts;
+    std::vector<std::string> repos;
+
+    char buf[4096];
+    while (std::fgets(buf, sizeof(buf), in)) {
+        std::string line(buf);
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+        if (line == "end") break;
+        std::istringstream iss(line);
+        std::string cmd;
+        iss >> cmd;
+        if (cmd == "shard") {
+            iss >> index >> count;
+        } else if (cmd == "opt") {
+            int algo = 0, backend = 0, sparse = 1, huge = 1, numa = 1, cache = 0, resume = 0;
+            unsigned threads = 0, retries = opts.change_retries;
+            iss >> algo >> backend >> sparse >> huge >> numa >> threads >> cache >> resume >> retries;
+            opts.algo = (HashAlgo)algo;
+            opts.backend = (ReadBackend)backend;
+            opts.sparse = sparse != 0;
+            opts.huge_pages = huge != 0;
+            opts.numa = numa != 0;
+            opts.threads = threads;
+            opts.digest_cache = cache != 0;
+            opts.resume_appends = resume != 0;
+            opts.change_retries = retries;
+        } else if (cmd == "repo") {
+            repos.push_back(unescape_field(line.substr(5)));
+        }
+    }
+    if (count == 0 || index >= count) {
+        std::fprintf(out, "done\n");
+        return 2;
+    }
+    opts = verify_hash_options(opts);
+
+    for (auto& repo : repos) {
+        fs::path hashes = fs::path(repo) / "hashes.md5";
+        std::string erepo = escape_field(repo);
+        if (!fs::exists(hashes)) {
+            std::fprintf(out, "M\t%s\n", erepo.c_str());
+            continue;
+        }
+        RepoVerifyResult r;
+        std::vector<ManifestEntry> batch;
+        std::string log;
+        bool read_ok = for_each_manifest_entry(hashes, [&](ManifestEntry&& e) {
+            if (path_shard_hash(e.path) % count != index) return;
+            batch.push_back(std::move(e));
+            if (batch.size() >= kWorkerBatch) verify_batch(repo, batch, opts, r, out);
+        }, log);
+        // Todos los shards leen el manifiesto entero: sus avisos los manda solo
+        // el primero para no repetirlos n veces; el error va en la "E"
+        std::vector<std::string> msgs;
+        std::istringstream lines(log);
+        for (std::string msg; std::getline(lines, msg);) msgs.push_back(msg);
+        for (size_t i = 0; i + (read_ok ? 0 : 1) < msgs.size(); ++i)
+            if (index == 0) std::fprintf(out, "W\t%s\t%s\n", erepo.c_str(), escape_field(msgs[i]).c_str());
+        if (!read_ok) {
+            // Un manifiesto a medio leer no es "0 archivos, todo OK"
+            std::fprintf(out, "E\t%s\t%s\n", erepo.c_str(),
+                         escape_field(msgs.empty() ? "error de lectura" : msgs.back()).c_str());
+            std::fflush(out);
+            continue;
+        }
+        if (!batch.empty()) verify_batch(repo, batch, opts, r, out);
+        std::fprintf(out, "C\t%s\t%llu\t%llu\t%llu\t%llu\n", erepo.c_str(), (unsigned long long)r.ok,
+                     (unsigned long long)r.failed, (unsigned long long)r.unreadable,
+                     (unsigned long long)r.bytes_read);
+        std::fflush(out);
+    }
+    std::fprintf(out, "done\n");
+    std::fflush(out);
+    return 0;
+}
+
+// ------------------------------------------------------------- coordinador
+
+#ifndef _WIN32
+
+struct WorkerProc {
+    pid_t pid = -1;
+    int out_fd = -1;      // stdout del worker
+    std::string pending;  // línea incompleta
+    std::string label;    // "grupo 0 shard 1/2" para el log
+    bool done = false;
+    std::set<std::string> reported; // repos con su "C" o "M"
+};
+
+static std::string self_exe() {
+    char path[4096];
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (n <= 0) return "hash_gpg_gui";
+    path[n] = '\0';
+    return path;
+}
+
+// write() completo sin que un lector cerrado mate al proceso con SIGPIPE. La
+// señal se bloquea solo en este hilo y la que genere la escritura se descarta:
+// los manejadores del resto del programa no se tocan
+static bool write_all_nosigpipe(int fd, const char* p, size_t left) {
+    sigset_t pipe_set, old_mask, pending;
+    sigemptyset(&pipe_set);
+    sigaddset(&pipe_set, SIGPIPE);
+    sigpending(&pending);
+    bool was_pending = sigismember(&pending, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe_set, &old_mask);
+    bool ok = true;
+    while (left > 0) {
+        ssize_t n = write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+        p += n;
+        left -= (size_t)n;
+    }
+    if (!ok && errno == EPIPE && !was_pending) {
+        timespec zero = {0, 0};
+        while (sigtimedwait(&pipe_set, nullptr, &zero) < 0 && errno == EINTR) {
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+    return ok;
+}
+
+static bool spawn_worker(const std::vector<std::string>& argv, const std::string& assignment, WorkerProc& w,
+                         std::string& out_log) {
+    int in_pipe[2], out_pipe[2];
+    if (pipe2(in_pipe, O_CLOEXEC) != 0) {
+        out_log += std::string("pipe: ") + std::strerror(errno) + "\n";
+        return false;
+    }
+    if (pipe2(out_pipe, O_CLOEXEC) != 0) {
+        out_log += std::string("pipe: ") + std::strerror(errno) + "\n";
+        close(in_pipe[0]);
+        close(in_pipe[1]);
+        return false;
+    }
+    // argv preparado antes de fork: en el hijo solo llamadas seguras
+    std::vector<char*> cargv;
+    for (auto& a : argv) cargv.push_back(const_cast<char*>(a.c_str()));
+    cargv.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        out_log += std::string("fork: ") + std::strerror(errno) + "\n";
+        close(in_pipe[0]); close(in_pipe[1]); close(out_pipe[0]); close(out_pipe[1]);
+        return false;
+    }
+    if (pid == 0) {
+        dup2(in_pipe[0], 0);
+        dup2(out_pipe[1], 1);
+        close(in_pipe[0]); close(in_pipe[1]); close(out_pipe[0]); close(out_pipe[1]);
+        execvp(cargv[0], cargv.data());
+        _exit(127);
+    }
+    close(in_pipe[0]);
+    close(out_pipe[1]);
+
+    // La asignación es pequeña (unas líneas por repo): cabe en el buffer del
+    // pipe. Si el worker ya murió, la escritura da EPIPE y el worker cuenta
+    // como terminado mal al esperarlo
+    write_all_nosigpipe(in_pipe[1], assignment.data(), assignment.size());
+    close(in_pipe[1]);
+
+    w.pid = pid;
+    w.out_fd = out_pipe[0];
+    return true;
+}
+
+bool verify_sharded(const std::vector<fs::path>& repos, const ShardOptions& opt,
+                    std::vector<RepoVerifyResult>& results, std::string& out_log) {
+    // Grupos de disco: repos cuyo directorio está en el mismo dispositivo
+    std::map<dev_t, std::vector<fs::path>> groups;
+    for (auto& r : repos) {
+        struct stat st;
+        dev_t dev = (stat(r.c_str(), &st) == 0) ? st.st_dev : 0;
+        groups[dev].push_back(r);
+    }
+
+    unsigned per_group = opt.workers_per_group ? opt.workers_per_group : 1;
+    unsigned total = (unsigned)groups.size() * per_group;
+    HashOptions ho = verify_hash_options(opt.hash);
+    if (ho.threads == 0) {
+        unsigned hw = std::thread::hardware_concurrency();
+        ho.threads = (hw > total) ? hw / total : 1;
+    }
+
+    std::vector<std::string> argv;
+    {
+        std::istringstream iss(opt.launcher);
+        std::string tok;
+        while (iss >> tok) argv.push_back(tok);
+        argv.push_back(self_exe());
+        argv.push_back("--verify-shard");
+    }
+
+    std::vector<WorkerProc> workers;
+    bool ok = true;
+    size_t gi = 0;
+    for (auto& [dev, group] : groups) {
+        for (unsigned i = 0; i < per_group; ++i) {
+            std::string a = "shard " + std::to_string(i) + " " + std::to_string(per_group) + "\n";
+            a += "opt " + std::to_string((int)ho.algo) + " " + std::to_string((int)ho.backend) + " " +
+                 std::to_string(ho.sparse) + " " + std::to_string(ho.huge_pages) + " " +
+                 std::to_string(ho.numa) + " " + std::to_string(ho.threads) + " " +
+                 std::to_string(ho.digest_cache) + " " + std::to_string(ho.resume_appends) + " " +
+                 std::to_string(ho.change_retries) + "\n";
+            for (auto& r : group) a += "repo " + escape_field(r.string()) + "\n";
+            a += "end\n";
+            WorkerProc w;
+            w.label = "grupo " + std::to_string(gi) + " shard " + std::to_string(i + 1) + "/" + std::to_string(per_group);
+            if (!spawn_worker(argv, a, w, out_log)) {
+                out_log += "No se pudo lanzar el worker " + w.label + "\n";
+                ok = false;
+                continue;
+            }
+            workers.push_back(std::move(w));
+        }
+        ++gi;
+    }
+    out_log += "Verificación multiproceso: " + std::to_string(workers.size()) + " workers en " +
+               std::to_string(groups.size()) + " grupo(s) de disco, " + std::to_string(ho.threads) +
+               " hilos por worker\n";
+
+    // Cada repo lo cubren los per_group workers de su grupo; solo cuentan
+    // los que informan del repo y terminan bien
+    std::map<std::string, RepoVerifyResult> merged;
+    for (auto& r : repos) {
+        RepoVerifyResult& m = merged[r.string()];
+        m.repo = r;
+        m.shards_expected = per_group;
+    }
+
+    auto handle_line = [&](WorkerProc& w, const std::string& line) {
+        if (line == "done") {
+            w.done = true;
+            return;
+        }
+        if (line.size() < 2 || line[1] != '\t') return;
+        if (line[0] == 'F') {
+            auto f = split_tabs(line);
+            if (f.size() != 5) return;
+            // Misma forma que md5sum -c, con la ruta del repo delante
+            out_log += f[1] + "/" + f[3].substr(f[3].rfind("./", 0) == 0 ? 2 : 0) + ": " +
+                       (f[2] == "FAILED" ? "FAILED" : "FAILED open or read (" + f[4] + ")") + "\n";
+        } else if (line[0] == 'C') {
+            auto f = split_tabs(line);
+            uint64_t n[4];
+            auto it = f.size() != 6 ? merged.end() : merged.find(f[1]);
+            if (it == merged.end() || !parse_u64(f[2], n[0]) || !parse_u64(f[3], n[1]) ||
+                !parse_u64(f[4], n[2]) || !parse_u64(f[5], n[3])) {
+                out_log += "Worker " + w.label + ": línea de resultados mal formada\n";
+                return;
+            }
+            RepoVerifyResult& r = it->second;
+            r.ok += n[0];
+            r.failed += n[1];
+            r.unreadable += n[2];
+            r.bytes_read += n[3];
+            w.reported.insert(f[1]);
+        } else if (line[0] == 'M') {
+            auto it = merged.find(unescape_field(line.substr(2)));
+            if (it == merged.end()) return;
+            it->second.manifest_missing = true;
+            w.reported.insert(it->first);
+        } else if (line[0] == 'E' || line[0] == 'W') {
+            auto f = split_tabs(line);
+            auto it = f.size() != 3 ? merged.end() : merged.find(f[1]);
+            if (it == merged.end()) {
+                out_log += "Worker " + w.label + ": línea de resultados mal formada\n";
+                return;
+            }
+            if (line[0] == 'W') {
+                out_log += f[2] + "\n";
+                return;
+            }
+            if (!it->second.manifest_unreadable) out_log += f[2] + "\n";
+            it->second.manifest_unreadable = true;
+            w.reported.insert(it->first);
+        }
+    };
+
+    // Lee de todos los workers a la vez para que ninguno se bloquee con el pipe lleno
+    size_t open_fds = workers.size();
+    std::vector<pollfd> pfds(workers.size());
+    while (open_fds > 0) {
+        for (size_t i = 0; i < workers.size(); ++i) {
+            pfds[i].fd = workers[i].out_fd;
+            pfds[i].events = POLLIN;
+            pfds[i].revents = 0;
+        }
+        if (poll(pfds.data(), pfds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            out_log += std::string("poll: ") + std::strerror(errno) + "\n";
+            ok = false;
+            // Lo que quede por leer se pierde: ningún worker cuenta como terminado
+            for (auto& w : workers) {
+                if (w.out_fd >= 0) close(w.out_fd);
+                w.out_fd = -1;
+                w.done = false;
+            }
+            break;
+        }
+        for (size_t i = 0; i < workers.size(); ++i) {
+            if (workers[i].out_fd < 0 || !(pfds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            char buf[65536];
+            ssize_t n = read(workers[i].out_fd, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                close(workers[i].out_fd);
+                workers[i].out_fd = -1;
+                --open_fds;
+                continue;
+            }
+            WorkerProc& w = workers[i];
+            w.pending.append(buf, (size_t)n);
+            size_t start = 0, nl;
+            while ((nl = w.pending.find('\n', start)) != std::string::npos) {
+                handle_line(w, w.pending.substr(start, nl - start));
+                start = nl + 1;
+            }
+            w.pending.erase(0, start);
+        }
+    }
+
+    for (auto& w : workers) {
+        int status = 0;
+        waitpid(w.pid, &status, 0);
+        if (!w.done || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            out_log += "Worker " + w.label + " terminó mal (status=" + std::to_string(status) +
+                       "): sus resultados están incompletos\n";
+            ok = false;
+            continue;
+        }
+        for (auto& r : w.reported) merged[r].shards_done++;
+    }
+
+    results.clear();
+    for (auto& r : repos) {
+        RepoVerifyResult& m = merged[r.string()];
+        if (m.manifest_missing) {
+            out_log += "No existe " + (r / "hashes.md5").string() + "\n";
+        } else if (m.manifest_unreadable) {
+            out_log += "Integridad FALLIDA en " + r.string() + ": no se pudo leer " +
+                       (r / "hashes.md5").string() + "\n";
+        } else if (!m.complete()) {
+            // Un worker que no arrancó o murió deja sin verificar su parte
+            out_log += "Integridad FALLIDA en " + r.string() + ": verificación incompleta (" +
+                       std::to_string(m.shards_done) + " de " + std::to_string(m.shards_expected) +
+                       " workers terminaron; " + std::to_string(m.failed) + " distintos, " +
+                       std::to_string(m.unreadable) + " ilegibles en lo verificado)\n";
+        } else if (m.good()) {
+            out_log += "Integridad OK en " + r.string() + " (" + std::to_string(m.ok) + " archivos, " +
+                       format_bytes(m.bytes_read) + ")\n";
+        } else {
+            out_log += "Integridad FALLIDA (" + std::to_string(m.failed) + " distintos, " +
+                       std::to_string(m.unreadable) + " ilegibles) en " + r.string() + "\n";
+        }
+        if (!m.good()) ok = false;
+        results.push_back(m);
+    }
+    return ok;
+}
+
+#else
+
+bool verify_sharded(const std::vector<fs::path>&, const ShardOptions&, std::vector<RepoVerifyResult>&,
+                    std::string& out_log) {
+    out_log += "La verificación multiproceso solo está disponible en Linux\n";
+    return false;
+}
+
+#endif
@@ -0,0 +1,56 @@
+// src/shard_verify.h
+// Verificación multiproceso: un coordinador reparte las entradas de los
+// manifiestos en shards y lanza un proceso worker por shard. Cada grupo de
+// disco (repos en el mismo st_dev) tiene sus propios workers, así que cada
+// disco se verifica en espacios de direcciones separados.
+//
+// Los workers son este mismo ejecutable con --verify-shard y hablan con el
+// coordinador por stdin/stdout (pipes), de modo que un lanzador como
+// "ssh nodo1" sirve igual que un proceso local.
+
+#pragma once
+
+#include "hash_engine.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct ShardOptions {
+    unsigned workers_per_group = 2;
+    // Prefijo para lanzar cada worker ("ssh nodo1", "env NODE=a" como sustituto
+    // local de un nodo remoto...). Vacío: se ejecuta directamente.
+    std::string launcher;
+    HashOptions hash;
+};
+
+struct RepoVerifyResult {
+    fs::path repo;
+    uint64_t ok = 0;
+    uint64_t failed = 0;
+    uint64_t unreadable = 0;
+    uint64_t bytes_read = 0;
+    bool manifest_missing = false;
+    bool manifest_unreadable = false; // algún worker no pudo leerlo entero
+    // Shards del repo cuyo worker informó y terminó bien, de los que tocaban;
+    // si falta alguno, parte del manifiesto no se verificó
+    unsigned shards_done = 0;
+    unsigned shards_expected = 0;
+
+    bool complete() const { return shards_done >= shards_expected; }
+    bool good() const { return complete() && !manifest_missing && !manifest_unreadable && failed == 0 && unreadable == 0; }
+};
+
+// Coordinador: verifica hashes.md5 de todos los repos repartiendo el trabajo
+// entre procesos y funde los resultados en un único informe (out_log).
+// Devuelve false si algún repo falla o algún worker no termina bien.
+bool verify_sharded(const std::vector<fs::path>& repos, const ShardOptions& opt,
+                    std::vector<RepoVerifyResult>& results, std::string& out_log);
+
+// Punto de entrada del worker (--verify-shard): lee la asignación de 'in' y
+// escribe los resultados en 'out'. Devuelve el código de salida del proceso.
+int run_verify_shard_worker(FILE* in, FILE* out);
@@ -0,0 +1,423 @@
+// src/translog.cpp
+
+#include "translog.h"
+#include "hash_engine.h"
+#include "manifest.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+static constexpr uint64_t kTileWidth = 256; // hashes por tile
+static constexpr int kTileHeight = 8;       // log2(kTileWidth)
+static constexpr int kMaxLevels = 64 / kTileHeight;
+
+fs::path translog_default_dir() {
+#ifdef _WIN32
+    if (const char* a = std::getenv("LOCALAPPDATA"); a && *a) return fs::path(a) / "hashnsign" / "translog";
+#else
+    if (const char* x = std::getenv("XDG_DATA_HOME"); x && *x) return fs::path(x) / "hashnsign" / "translog";
+    if (const char* h = std::getenv("HOME"); h && *h) return fs::path(h) / ".local" / "share" / "hashnsign" / "translog";
+#endif
+    return fs::path("hashnsign-translog");
+}
+
+std::string translog_head_text(const TransLogHead& head) {
+    return "hashnsign-translog v1\nsize " + std::to_string(head.size) + "\nroot " + merkle_hex(head.root) + "\n";
+}
+
+bool translog_parse_head(const std::string& text, TransLogHead& head) {
+    std::istringstream iss(text);
+    std::string line;
+    bool magic = false, have_size = false, have_root = false;
+    while (std::getline(iss, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line == "hashnsign-translog v1") magic = true;
+        else if (line.rfind("size ", 0) == 0) {
+            char* end = nullptr;
+            head.size = std::strtoull(line.c_str() + 5, &end, 10);
+            have_size = end && *end == '\0' && line.size() > 5;
+        } else if (line.rfind("root ", 0) == 0) {
+            have_root = merkle_from_hex(line.substr(5), head.root);
+        }
+    }
+    return magic && have_size && have_root;
+}
+
+// Hashes en el nivel 'level' de tiles de un registro de 'size' hojas
+static uint64_t level_count(uint64_t size, int level) {
+    return level < kMaxLevels ? size >> (kTileHeight * level) : 0;
+}
+
+static std::string read_file(const fs::path& p) {
+    std::ifstream ifs(p, std::ios::binary);
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+fs::path TransLog::tile_path(int level, uint64_t n) const {
+    return dir_ / "tile" / std::to_string(level) / std::to_string(n);
+}
+
+bool TransLog::read_tile(int level, uint64_t n, std::vector<MerkleHash>& hashes) {
+    auto it = tiles_.find({ level, n });
+    if (it != tiles_.end()) {
+        hashes = it->second;
+        return true;
+    }
+    uint64_t count = level_count(head_.size, level);
+    uint64_t want = count > n * kTileWidth ? std::min(kTileWidth, count - n * kTileWidth) : 0;
+    std::ifstream ifs(tile_path(level, n), std::ios::binary);
+    hashes.assign(want, MerkleHash{});
+    for (auto& h : hashes)
+        if (!ifs.read(reinterpret_cast<char*>(h.data()), (std::streamsize)h.size())) return false;
+    // Un tile completo ya no cambia; el último se vuelve a leer
+    if (want == kTileWidth) tiles_[{ level, n }] = hashes;
+    return true;
+}
+
+bool TransLog::append_hash(int level, const MerkleHash& h) {
+    uint64_t index = level_count(head_.size + 1, level) - 1;
+    fs::path p = tile_path(level, index / kTileWidth);
+    std::error_code ec;
+    fs::create_directories(p.parent_path(), ec);
+    std::ofstream ofs(p, std::ios::binary | std::ios::app);
+    ofs.write(reinterpret_cast<const char*>(h.data()), (std::streamsize)h.size());
+    return (bool)ofs;
+}
+
+// Subárbol completo de 2^height hojas número 'index': sus hashes están en un
+// solo tile del nivel height / 8 y se combinan height % 8 veces
+MerkleHash TransLog::stored_subtree(int height, uint64_t index) {
+    int level = height / kTileHeight, up = height % kTileHeight;
+    uint64_t first = index << up;
+    std::vector<MerkleHash> tile;
+    if (!read_tile(level, first / kTileWidth, tile) || (first % kTileWidth) + (uint64_t(1) << up) > tile.size()) {
+        tile_error_ = true;
+        return MerkleHash{};
+    }
+    std::vector<MerkleHash> row(tile.begin() + (first % kTileWidth),
+                                tile.begin() + (first % kTileWidth) + (uint64_t(1) << up));
+    for (; row.size() > 1;) {
+        for (size_t i = 0; i < row.size() / 2; ++i) row[i] = merkle_node_hash(row[2 * i], row[2 * i + 1]);
+        row.resize(row.size() / 2);
+    }
+    return row[0];
+}
+
+MerkleHash TransLog::subtree(uint64_t begin, uint64_t end) {
+    uint64_t n = end - begin;
+    if (n == 0) return Sha256().final();
+    if ((n & (n - 1)) == 0 && begin % n == 0) {
+        int height = 0;
+        while ((uint64_t(1) << height) < n) ++height;
+        return stored_subtree(height, begin >> height);
+    }
+    uint64_t k = 1;
+    while (k << 1 < n) k <<= 1;
+    return merkle_node_hash(subtree(begin, begin + k), subtree(begin + k, end));
+}
+
+bool TransLog::write_head(std::string& out_log) {
+    fs::path p = dir_ / "checkpoint", tmp = dir_ / "checkpoint.tmp";
+    {
+        std::ofstream ofs(tmp, std::ios::trunc);
+        ofs << translog_head_text(head_) << "entries " << entries_bytes_ << "\n";
+        if (!ofs) {
+            out_log += "Error: no se puede escribir " + tmp.string() + "\n";
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, p, ec);
+    if (ec) {
+        out_log += "Error: no se puede reemplazar " + p.string() + ": " + ec.message() + "\n";
+        return false;
+    }
+    return true;
+}
+
+bool TransLog::open(const fs::path& dir, std::string& out_log) {
+    return load(dir, false, out_log);
+}
+
+bool TransLog::load(const fs::path& dir, bool trim, std::string& out_log) {
+    dir_ = dir;
+    head_ = TransLogHead{};
+    head_.root = Sha256().final();
+    entries_bytes_ = 0;
+    tiles_.clear();
+    tile_error_ = false;
+    std::error_code ec;
+    fs::create_directories(dir_ / "tile", ec);
+    if (ec) {
+        out_log += "Registro: no se puede crear " + dir_.string() + ": " + ec.message() + "\n";
+        return false;
+    }
+
+    fs::path cp = dir_ / "checkpoint";
+    if (fs::exists(cp)) {
+        std::string text = read_file(cp);
+        size_t at = text.find("\nentries ");
+        if (!translog_parse_head(text, head_) || at == std::string::npos) {
+            out_log += "Registro: " + cp.string() + " mal formado\n";
+            return false;
+        }
+        entries_bytes_ = std::strtoull(text.c_str() + at + 9, nullptr, 10);
+    }
+
+    // Lo añadido tras la última cabecera es un alta que no llegó a terminar o
+    // que otro proceso está escribiendo: los lectores lo ignoran y solo quien
+    // tiene el cerrojo de append lo recorta
+    auto trim_to = [&](const fs::path& p, uint64_t bytes) {
+        uint64_t have = fs::exists(p) ? fs::file_size(p, ec) : 0;
+        if (have < bytes) return false;
+        if (trim && have > bytes) fs::resize_file(p, bytes, ec);
+        return !ec;
+    };
+    bool ok = trim_to(dir_ / "entries", entries_bytes_);
+    for (int level = 0; ok && level < kMaxLevels; ++level) {
+        uint64_t count = level_count(head_.size, level);
+        uint64_t last = count ? (count - 1) / kTileWidth : 0;
+        if (count) ok = trim_to(tile_path(level, last), (count - last * kTileWidth) * sizeof(MerkleHash));
+        if (trim) fs::remove(tile_path(level, count ? last + 1 : 0), ec);
+    }
+    if (ok && head_.size && subtree(0, head_.size) != head_.root) ok = false;
+    if (!ok || tile_error_) {
+        out_log += "Registro: " + dir_.string() + " está dañado (faltan datos o la raíz no coincide)\n";
+        return false;
+    }
+    return true;
+}
+
+bool TransLog::append(const std::string& entry, uint64_t& index, std::string& out_log) {
+    if (entry.find('\n') != std::string::npos) {
+        out_log += "Registro: una entrada no puede tener saltos de línea\n";
+        return false;
+    }
+#ifndef _WIN32
+    // Otro proceso puede estar añadiendo: bajo el cerrojo se relee la cabecera
+    int lock = ::open((dir_ / "lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lock < 0 || flock(lock, LOCK_EX) != 0) {
+        if (lock >= 0) ::close(lock);
+        out_log += "Registro: no se puede bloquear " + (dir_ / "lock").string() + "\n";
+        return false;
+    }
+    struct Unlock {
+        int fd;
+        ~Unlock() { ::close(fd); }
+    } unlock{ lock };
+#endif
+    if (!load(dir_, true, out_log)) return false;
+
+    {
+        std::ofstream ofs(dir_ / "entries", std::ios::binary | std::ios::app);
+        ofs << entry << "\n";
+        if (!ofs) {
+            out_log += "Registro: no se puede escribir " + (dir_ / "entries").string() + "\n";
+            return false;
+        }
+    }
+    bool ok = append_hash(0, merkle_leaf_hash(entry));
+    // Un tile que se llena sube su raíz al nivel siguiente
+    for (int level = 0; ok && level + 1 < kMaxLevels; ++level) {
+        uint64_t count = level_count(head_.size + 1, level);
+        if (count == 0 || count % kTileWidth != 0) break;
+        std::vector<MerkleHash> tile;
+        uint64_t n = count / kTileWidth - 1;
+        {
+            // El tile recién llenado, con el tamaño nuevo
+            std::ifstream ifs(tile_path(level, n), std::ios::binary);
+            tile.assign(kTileWidth, MerkleHash{});
+            for (auto& h : tile)
+                if (!ifs.read(reinterpret_cast<char*>(h.data()), (std::streamsize)h.size())) ok = false;
+        }
+        ok = ok && append_hash(level + 1, merkle_root(tile));
+    }
+    if (!ok) {
+        out_log += "Registro: no se pueden escribir los tiles de " + dir_.string() + "\n";
+        return false;
+    }
+    index = head_.size;
+    head_.size += 1;
+    entries_bytes_ += entry.size() + 1;
+    tiles_.erase({ 0, index / kTileWidth });
+    head_.root = subtree(0, head_.size);
+    if (tile_error_) {
+        out_log += "Registro: no se pueden leer los tiles de " + dir_.string() + "\n";
+        return false;
+    }
+    return write_head(out_log);
+}
+
+bool TransLog::root_at(uint64_t size, MerkleHash& root, std::string& out_log) {
+    if (size > head_.size) {
+        out_log += "Registro: tamaño " + std::to_string(size) + " mayor que el actual\n";
+        return false;
+    }
+    tile_error_ = false;
+    root = subtree(0, size);
+    if (tile_error_) out_log += "Registro: no se pueden leer los tiles de " + dir_.string() + "\n";
+    return !tile_error_;
+}
+
+bool TransLog::inclusion_proof(uint64_t index, uint64_t size, std::vector<MerkleHash>& proof,
+                               std::string& out_log) {
+    if (index >= size || size > head_.size) {
+        out_log += "Registro: no hay entrada " + std::to_string(index) + " en un árbol de tamaño " +
+                   std::to_string(size) + "\n";
+        return false;
+    }
+    tile_error_ = false;
+    proof = merkle_inclusion_path([this](uint64_t b, uint64_t e) { return subtree(b, e); }, index, size);
+    if (tile_error_) out_log += "Registro: no se pueden leer los tiles de " + dir_.string() + "\n";
+    return !tile_error_;
+}
+
+bool TransLog::consistency_proof(uint64_t m, uint64_t n, std::vector<MerkleHash>& proof, std::string& out_log) {
+    if (m == 0 || m > n || n > head_.size) {
+        out_log += "Registro: no hay prueba de consistencia de " + std::to_string(m) + " a " + std::to_string(n) + "\n";
+        return false;
+    }
+    tile_error_ = false;
+    proof = merkle_consistency_proof([this](uint64_t b, uint64_t e) { return subtree(b, e); }, m, n);
+    if (tile_error_) out_log += "Registro: no se pueden leer los tiles de " + dir_.string() + "\n";
+    return !tile_error_;
+}
+
+bool TransLog::find(const std::string& needle, uint64_t& index, std::string& entry, std::string& out_log) {
+    std::ifstream ifs(dir_ / "entries", std::ios::binary);
+    if (!ifs.is_open()) {
+        out_log += "Registro: no se puede leer " + (dir_ / "entries").string() + "\n";
+        return false;
+    }
+    std::string line;
+    bool found = false;
+    for (uint64_t i = 0; i < head_.size && std::getline(ifs, line); ++i) {
+        if (line.find(needle) == std::string::npos) continue;
+        index = i;
+        entry = line;
+        found = true;
+    }
+    return found;
+}
+
+// "\t<sha256 del documento>\t<archivo>\t<repo>": la entrada sin la hora
+static bool document_key(const fs::path& repo, std::string& key, std::string& out_log) {
+    HashOptions o;
+    o.algo = HashAlgo::Sha256;
+    HashStats st;
+    std::string hex, err;
+    fs::path doc = signed_document(repo);
+    if (!hash_file(doc, o, hex, st, err)) {
+        out_log += "Registro: no se puede leer " + doc.string() + ": " + err + "\n";
+        return false;
+    }
+    std::error_code ec;
+    fs::path abs = fs::absolute(repo, ec).lexically_normal();
+    key = "\t" + hex + "\t" + doc.filename().string() + "\t" + (ec ? repo : abs).string();
+    return true;
+}
+
+bool translog_record(const fs::path& dir, const fs::path& repo, std::string& out_log) {
+    std::string key;
+    if (!document_key(repo, key, out_log)) return false;
+    TransLog log;
+    uint64_t index = 0;
+    if (!log.open(dir, out_log) || !log.append(std::to_string((long long)std::time(nullptr)) + key, index, out_log))
+        return false;
+    out_log += "Registro: entrada #" + std::to_string(index) + " (tamaño " + std::to_string(log.head().size) +
+               ", raíz " + merkle_hex(log.head().root).substr(0, 16) + ")\n";
+    return true;
+}
+
+// ¿Extiende el registro abierto la cabecera 'old'? Prueba de consistencia
+// entre las dos raíces; 'proof_size' para el log
+static bool extends_head(TransLog& log, const TransLogHead& old, size_t& proof_size, std::string& out_log) {
+    const TransLogHead& now = log.head();
+    proof_size = 0;
+    if (old.size == 0) return true; // el árbol vacío es prefijo de cualquiera
+    if (old.size > now.size) {
+        out_log += "Registro: la cabecera guardada tiene " + std::to_string(old.size) + " entradas y el registro " +
+                   std::to_string(now.size) + ": se ha truncado\n";
+        return false;
+    }
+    std::vector<MerkleHash> proof;
+    bool ok = log.consistency_proof(old.size, now.size, proof, out_log) &&
+              merkle_verify_consistency(old.size, now.size, old.root, now.root, proof);
+    proof_size = proof.size();
+    return ok;
+}
+
+bool translog_check(const fs::path& dir, const fs::path& repo, const fs::path& trusted_head, std::string& out_log) {
+    std::string key, entry;
+    uint64_t index = 0;
+    TransLog log;
+    if (!document_key(repo, key, out_log) || !log.open(dir, out_log)) return false;
+    TransLogHead trusted;
+    bool pinned = !trusted_head.empty();
+    if (pinned && !translog_parse_head(read_file(trusted_head), trusted)) {
+        out_log += trusted_head.string() + " no es una cabecera de registro\n";
+        return false;
+    }
+    // La clave va al final de la línea, tras la hora
+    if (!log.find(key, index, entry, out_log) || entry.size() < key.size() ||
+        entry.compare(entry.size() - key.size(), key.size(), key) != 0) {
+        out_log += "Registro: el documento firmado de " + repo.string() + " no está en " + dir.string() + "\n";
+        return false;
+    }
+    // La cabecera de confianza no sale de estos archivos: si se reescribió lo
+    // que ella cubre, la raíz recalculada ya no la extiende
+    size_t consistency_hashes = 0;
+    if (pinned && !extends_head(log, trusted, consistency_hashes, out_log)) {
+        out_log += "Registro: NO es consistente con la cabecera de confianza " + trusted_head.string() + "\n";
+        return false;
+    }
+    std::vector<MerkleHash> proof;
+    if (!log.inclusion_proof(index, log.head().size, proof, out_log)) return false;
+    if (!merkle_verify_inclusion(merkle_leaf_hash(entry), index, log.head().size, proof, log.head().root)) {
+        out_log += "Registro: la prueba de inclusión de la entrada #" + std::to_string(index) + " NO es válida\n";
+        return false;
+    }
+    out_log += "Registro: entrada #" + std::to_string(index) + " incluida en el árbol de tamaño " +
+               std::to_string(log.head().size) + " (" + std::to_string(proof.size()) + " hashes)\n";
+    if (!pinned) {
+        out_log += "Registro: aviso: sin cabecera de confianza; la raíz se recalcula de los mismos archivos, así que "
+                   "solo consta que la entrada está en el registro local, no que este no se haya reescrito\n";
+    } else if (index >= trusted.size) {
+        out_log += "Registro: la entrada es posterior a la cabecera de confianza (" + std::to_string(trusted.size) +
+                   " entradas): el registro la extiende (" + std::to_string(consistency_hashes) +
+                   " hashes), pero la entrada solo la respalda la cabecera actual\n";
+    } else {
+        out_log += "Registro: cubierta por la cabecera de confianza (" + std::to_string(trusted.size) +
+                   " entradas, " + std::to_string(consistency_hashes) + " hashes de consistencia)\n";
+    }
+    return true;
+}
+
+bool translog_audit(const fs::path& dir, const fs::path& old_head, std::string& out_log) {
+    TransLogHead old;
+    if (!translog_parse_head(read_file(old_head), old)) {
+        out_log += old_head.string() + " no es una cabecera de registro\n";
+        return false;
+    }
+    TransLog log;
+    if (!log.open(dir, out_log)) return false;
+    const TransLogHead& now = log.head();
+    size_t proof_size = 0;
+    bool ok = extends_head(log, old, proof_size, out_log);
+    out_log += ok ? "Registro: consistente con la cabecera guardada (" + std::to_string(old.size) + " -> " +
+                        std::to_string(now.size) + ", " + std::to_string(proof_size) + " hashes)\n"
+                  : "Registro: NO es consistente con la cabecera guardada\n";
+    out_log += translog_head_text(now);
+    return ok;
+}
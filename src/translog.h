@@ -0,0 +1,97 @@
+// src/translog.h
+// Registro de transparencia local: cada documento que se firma (hashes.md5 o
+// hashes.tree) se anota como hoja de un árbol de Merkle de solo añadir, al
+// estilo de RFC 6962 (merkle.h). Quien guarde una cabecera antigua (tamaño y
+// raíz) puede comprobar después, con log2(n) hashes, que el registro actual la
+// extiende sin haber reescrito nada (prueba de consistencia), y que una firma
+// concreta está en él (prueba de inclusión).
+//
+// En disco, en <dir>:
+//   entries      una línea por hoja, tal y como se hashea
+//   tile/<L>/<N> tiles de hasta 256 hashes de 32 bytes: en el nivel L, los de
+//                los subárboles completos de 256^L hojas N*256 .. N*256+255
+//   checkpoint   la cabecera actual (tamaño y raíz) y los bytes de entries
+// Todo se escribe añadiendo al final; la cabecera se reemplaza de forma
+// atómica al terminar cada alta, así que lo que quede tras ella en los
+// archivos (un corte a medias, o un alta de otro proceso en curso) no se lee;
+// solo append(), con el cerrojo, lo recorta antes de escribir. Abrir recalcula la raíz
+// desde los tiles más altos, en O(log n); un hash de hoja alterado dentro de
+// un tile ya resumido se detecta en la prueba de inclusión de esa hoja.
+
+#pragma once
+
+#include "merkle.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// $XDG_DATA_HOME/hashnsign/translog (o ~/.local/share/...)
+fs::path translog_default_dir();
+
+struct TransLogHead {
+    uint64_t size = 0;
+    MerkleHash root{};
+};
+
+// "hashnsign-translog v1\nsize <n>\nroot <hex>\n": lo que un auditor guarda
+std::string translog_head_text(const TransLogHead& head);
+bool translog_parse_head(const std::string& text, TransLogHead& head);
+
+class TransLog {
+public:
+    // Abre (o crea) el registro en 'dir' y comprueba la última cabecera. No
+    // toca los archivos: lo escrito tras ella puede ser un alta en curso
+    bool open(const fs::path& dir, std::string& out_log);
+
+    const TransLogHead& head() const { return head_; }
+
+    // Añade una hoja; 'index' es su posición
+    bool append(const std::string& entry, uint64_t& index, std::string& out_log);
+
+    // MTH(D[0:size]) de cualquier tamaño pasado, desde los tiles
+    bool root_at(uint64_t size, MerkleHash& root, std::string& out_log);
+
+    bool inclusion_proof(uint64_t index, uint64_t size, std::vector<MerkleHash>& proof, std::string& out_log);
+    bool consistency_proof(uint64_t m, uint64_t n, std::vector<MerkleHash>& proof, std::string& out_log);
+
+    // Busca la última hoja que contiene 'needle' (recorre entries)
+    bool find(const std::string& needle, uint64_t& index, std::string& entry, std::string& out_log);
+
+private:
+    fs::path tile_path(int level, uint64_t n) const;
+    bool read_tile(int level, uint64_t n, std::vector<MerkleHash>& hashes);
+    bool append_hash(int level, const MerkleHash& h);
+    MerkleHash stored_subtree(int height, uint64_t index);
+    MerkleHash subtree(uint64_t begin, uint64_t end);
+    bool write_head(std::string& out_log);
+    // open(); con 'trim', además recorta lo escrito tras la cabecera (solo
+    // con el cerrojo de append)
+    bool load(const fs::path& dir, bool trim, std::string& out_log);
+
+    fs::path dir_;
+    TransLogHead head_;
+    uint64_t entries_bytes_ = 0;
+    bool tile_error_ = false;
+    std::map<std::pair<int, uint64_t>, std::vector<MerkleHash>> tiles_; // tiles completos ya leídos
+};
+
+// Anota el documento firmado de 'repo' en el registro de 'dir':
+//   "<unix time>\t<sha256 del documento>\t<archivo>\t<ruta absoluta del repo>"
+bool translog_record(const fs::path& dir, const fs::path& repo, std::string& out_log);
+
+// ¿Está el documento firmado actual de 'repo' en el registro de 'dir'?
+// Comprueba su prueba de inclusión contra la cabecera actual. Esa cabecera se
+// recalcula de los mismos archivos, así que por sí sola no prueba nada contra
+// quien los reescriba: con 'trusted_head' (una cabecera guardada antes, como
+// en translog_audit) se exige además que el registro la extienda. Sin ella,
+// el log lo dice.
+bool translog_check(const fs::path& dir, const fs::path& repo, const fs::path& trusted_head, std::string& out_log);
+
+// ¿El registro actual extiende la cabecera 'old_head' (guardada antes)?
+bool translog_audit(const fs::path& dir, const fs::path& old_head, std::string& out_log);
@@ -0,0 +1,137 @@
+// src/tree_sign.cpp
+
+#include "tree_sign.h"
+#include "fleet.h"
+#include "manifest.h"
+#include "process.h"
+
+#include <fstream>
+#include <tuple>
+
+static constexpr const char* kStatementFile = "hashes.tree";
+
+// "git rev-parse --show-object-format" no existe antes de git 2.25: sha1
+static std::string object_format(const fs::path& repo) {
+    std::string f = git_line(repo, "rev-parse --show-object-format");
+    return f.empty() || f.find(' ') != std::string::npos ? "sha1" : f;
+}
+
+// Todo el repo salvo los manifiestos y firmas de hashnsign
+static std::string content_pathspec() {
+    std::string spec = " -- .";
+    for (const char* f : kManifestArtifacts) spec += " " + shell_quote(std::string(":(top,exclude)") + f);
+    return spec;
+}
+
+bool write_tree_statement(const fs::path& repo, std::string& out_log) {
+    std::string commit = git_line(repo, "rev-parse --verify -q HEAD");
+    std::string tree = commit.empty() ? "" : git_line(repo, "rev-parse " + commit + "^{tree}");
+    if (tree.empty()) {
+        out_log += "Modo árbol: " + repo.string() + " no tiene HEAD\n";
+        return false;
+    }
+    auto [rc, dirty] = run_command_stdout(git_cmd(repo) + "status --porcelain --untracked-files=no" + content_pathspec());
+    if (rc != 0) {
+        out_log += "Modo árbol: git status falló en " + repo.string() + "\n";
+        return false;
+    }
+    if (!trim(dirty).empty()) {
+        out_log += "Modo árbol: " + repo.string() + " tiene cambios sin commitear; se firmaría un tree que no es "
+                   "lo que hay en disco\n" + dirty;
+        return false;
+    }
+
+    fs::path out = repo / kStatementFile;
+    std::ofstream ofs(out, std::ios::trunc);
+    if (!ofs.is_open()) {
+        out_log += "Error: no se puede crear " + out.string() + "\n";
+        return false;
+    }
+    ofs << "hashnsign-tree v1\n"
+        << "repo " << fleet_member_name(repo) << "\n"
+        << "object-format " << object_format(repo) << "\n"
+        << "commit " << commit << "\n"
+        << "tree " << tree << "\n";
+    ofs.close();
+    // Un hashes.md5 anterior ya no es lo que se firma
+    std::error_code ec;
+    fs::remove(repo / "hashes.md5", ec);
+    fs::remove(repo / "hashes.verity", ec);
+    out_log += "Generado: " + out.string() + " (commit " + commit.substr(0, 12) + ", tree " + tree.substr(0, 12) + ")\n";
+    return true;
+}
+
+// Archivos cuyo contenido difiere del commit, sin fiarse de ningún stat: un
+// índice temporal sacado del commit no tiene datos de stat, así que el
+// refresh rehashea cada archivo. El índice del usuario no se toca.
+static bool content_diff(const fs::path& repo, const std::string& commit, std::string& diff, std::string& out_log) {
+    std::string git_dir = git_line(repo, "rev-parse --absolute-git-dir");
+    if (git_dir.empty()) {
+        out_log += "git rev-parse falló en " + repo.string() + "\n";
+        return false;
+    }
+    fs::path index = fs::path(git_dir) / "hashnsign-verify.index";
+    std::string env = "GIT_INDEX_FILE=" + shell_quote(index.string()) + " ";
+    auto [rc, out] = run_command_capture(env + git_cmd(repo) + "read-tree " + commit);
+    if (rc == 0) std::tie(rc, out) = run_command_capture(env + git_cmd(repo) + "update-index -q --refresh");
+    if (rc == 0) std::tie(rc, diff) = run_command_stdout(env + git_cmd(repo) + "diff-files --name-only" + content_pathspec());
+    std::error_code ec;
+    fs::remove(index, ec);
+    if (rc != 0) {
+        out_log += "No se pudo comparar el contenido con " + commit.substr(0, 12) + " en " + repo.string() + "\n" + out;
+        return false;
+    }
+    return true;
+}
+
+bool verify_tree_statement(const fs::path& repo, std::string& out_log) {
+    fs::path path = repo / kStatementFile;
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+        out_log += "No existe " + path.string() + "\n";
+        return false;
+    }
+    std::string line, name, format, commit, tree;
+    bool magic = false;
+    while (std::getline(ifs, line)) {
+        if (line == "hashnsign-tree v1") magic = true;
+        else if (line.rfind("repo ", 0) == 0) name = line.substr(5);
+        else if (line.rfind("object-format ", 0) == 0) format = line.substr(14);
+        else if (line.rfind("commit ", 0) == 0) commit = line.substr(7);
+        else if (line.rfind("tree ", 0) == 0) tree = line.substr(5);
+    }
+    auto is_hex = [](const std::string& s) {
+        return (s.size() == 40 || s.size() == 64) && s.find_first_not_of("0123456789abcdef") == std::string::npos;
+    };
+    if (!magic || !is_hex(commit) || !is_hex(tree)) {
+        out_log += path.string() + " mal formado\n";
+        return false;
+    }
+    // Una declaración válida de otro repo no vale para este
+    if (name != fleet_member_name(repo)) {
+        out_log += path.string() + " es de '" + name + "'\n";
+        return false;
+    }
+    if (format != object_format(repo)) {
+        out_log += path.string() + ": formato de objetos " + format + ", el repo usa " + object_format(repo) + "\n";
+        return false;
+    }
+    if (git_line(repo, "rev-parse --verify -q " + commit + "^{tree}") != tree) {
+        out_log += "El commit " + commit.substr(0, 12) + " no existe o no apunta al tree firmado\n";
+        return false;
+    }
+    auto [rc, diff] = run_command_stdout(git_cmd(repo) + "diff --name-only " + commit + content_pathspec());
+    if (rc != 0) {
+        out_log += "git diff falló en " + repo.string() + "\n";
+        return false;
+    }
+    // git diff se fía de la caché de stat del índice: una edición que conserva
+    // tamaño y mtime (y ctime con core.trustctime=false) no se relee
+    if (trim(diff).empty() && !content_diff(repo, commit, diff, out_log)) return false;
+    if (!trim(diff).empty()) {
+        out_log += "Difiere del tree firmado (" + tree.substr(0, 12) + "):\n" + diff;
+        return false;
+    }
+    out_log += "./: OK (tree " + tree.substr(0, 12) + " de " + commit.substr(0, 12) + ")\n";
+    return true;
+}
@@ -0,0 +1,27 @@
+// src/tree_sign.h
+// Modo árbol: en vez de recorrer y hashear el repo se firma una declaración
+// corta (hashes.tree) con el commit HEAD y su tree id. El id del tree ya se
+// compromete con cada byte versionado (SHA-1 o SHA-256 según el formato de
+// objetos del repo), así que firmar cuesta lo mismo sea cual sea el tamaño:
+//   hashnsign-tree v1
+//   repo <nombre>
+//   object-format sha1|sha256
+//   commit <id>
+//   tree <id>
+// Solo cubre lo versionado: con cambios sin commitear no se firma.
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// Escribe hashes.tree para HEAD. Falla si el árbol de trabajo tiene cambios
+// en archivos versionados (los propios manifiestos aparte).
+bool write_tree_statement(const fs::path& repo, std::string& out_log);
+
+// Comprueba una declaración ya verificada en firma: el commit existe y apunta
+// a ese tree (consulta a la base de objetos) y lo versionado en el árbol de
+// trabajo no difiere de él (git diff, que se apoya en el índice).
+bool verify_tree_statement(const fs::path& repo, std::string& out_log);
@@ -0,0 +1,67 @@
+// src/ui_profiler.cpp
+#include "ui_profiler.h"
+
+#include <algorithm>
+
+const char* UiProfiler::section_name(Section s) {
+    switch (s) {
+    case Discovery: return "detección de repos";
+    case RepoList: return "lista de repos";
+    case Buttons: return "botones";
+    case LogRender: return "log";
+    case Windows: return "ventanas";
+    case Render: return "render";
+    default: return "?";
+    }
+}
+
+void UiProfiler::set_enabled(bool on) {
+    if (on && !enabled_) {
+        // Empieza de cero: lo de antes de desactivarlo no es comparable
+        *this = UiProfiler();
+    }
+    enabled_ = on;
+}
+
+void UiProfiler::begin_frame() {
+    if (!enabled_) return;
+    Clock::time_point now = Clock::now();
+    if (started_) {
+        float ms = (float)std::chrono::duration<double, std::milli>(now - frame_start_).count();
+        frames_[next_] = ms;
+        next_ = (next_ + 1) % kFrames;
+        count_ = std::min(count_ + 1, kFrames);
+        // Media móvil exponencial: estable a la vista y sin guardar historia
+        // por sección
+        for (int s = 0; s < kSections; ++s) {
+            last_[s] = (float)current_[s];
+            avg_[s] = count_ == 1 ? last_[s] : avg_[s] * 0.95f + last_[s] * 0.05f;
+        }
+        if (ms > worst_) {
+            worst_ = ms;
+            std::copy(last_, last_ + kSections, worst_sections_);
+        }
+    }
+    std::fill(current_, current_ + kSections, 0.0);
+    frame_start_ = now;
+    started_ = true;
+}
+
+float UiProfiler::average_frame() const {
+    if (!count_) return 0.0f;
+    double sum = 0;
+    for (size_t i = 0; i < count_; ++i) sum += frames_[i];
+    return (float)(sum / (double)count_);
+}
+
+float UiProfiler::max_frame() const {
+    return count_ ? *std::max_element(frames_, frames_ + count_) : 0.0f;
+}
+
+void UiProfiler::histogram(float* counts) const {
+    std::fill(counts, counts + kBucketCount, 0.0f);
+    for (size_t i = 0; i < count_; ++i) {
+        int b = (int)(std::upper_bound(kBuckets, kBuckets + kBucketCount - 1, frames_[i]) - kBuckets);
+        counts[b] += 1.0f;
+    }
+}
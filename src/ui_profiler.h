@@ -0,0 +1,84 @@
+// src/ui_profiler.h
+// Perfil de la interfaz: tiempo de cada frame del bucle principal y lo que
+// cuesta cada sección (detección de repos, lista, botones, log, ventanas,
+// render) para ver los tirones en cuanto aparecen. Los botones ejecutan la
+// operación dentro del frame: un Generar o un Verificar es un frame de
+// segundos y queda como el peor.
+//
+// Las secciones se miden con UiSection (RAII) o, si abarcan medio bucle, con
+// start/stop; desactivado, cada una es una comprobación de un bool. Guarda
+// los últimos kFrames frames.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+class UiProfiler {
+public:
+    enum Section { Discovery, RepoList, Buttons, LogRender, Windows, Render, kSections };
+    static constexpr size_t kFrames = 240;
+    // Límites (ms) de los cubos del histograma; el último cubo es "más"
+    static constexpr float kBuckets[] = { 8.0f, 16.7f, 33.3f, 50.0f, 100.0f, 250.0f };
+    static constexpr int kBucketCount = (int)(sizeof(kBuckets) / sizeof(kBuckets[0])) + 1;
+
+    static const char* section_name(Section s);
+
+    void set_enabled(bool on);
+    bool enabled() const { return enabled_; }
+
+    // Al principio de cada frame: cierra el anterior
+    void begin_frame();
+    void start(Section s) {
+        if (enabled_) section_start_[s] = Clock::now();
+    }
+    void stop(Section s) {
+        if (enabled_) current_[s] += std::chrono::duration<double, std::milli>(Clock::now() - section_start_[s]).count();
+    }
+
+    // Historia de frames (ms), como anillo que empieza en offset()
+    const float* frames() const { return frames_; }
+    size_t count() const { return count_; }
+    size_t offset() const { return count_ < kFrames ? 0 : next_; }
+    float last_frame() const { return count_ ? frames_[(next_ + kFrames - 1) % kFrames] : 0.0f; }
+    float average_frame() const;
+    float max_frame() const;
+
+    // Último frame cerrado y media móvil por sección
+    float last(Section s) const { return last_[s]; }
+    float average(Section s) const { return avg_[s]; }
+
+    // Frames de la historia en cada cubo de kBuckets
+    void histogram(float* counts) const;
+
+    // Desglose del peor frame desde que se activó
+    float worst_frame() const { return worst_; }
+    float worst(Section s) const { return worst_sections_[s]; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    bool enabled_ = false;
+    bool started_ = false;
+    Clock::time_point frame_start_;
+    Clock::time_point section_start_[kSections];
+    float frames_[kFrames] = {};
+    size_t next_ = 0;
+    size_t count_ = 0;
+    double current_[kSections] = {};
+    float last_[kSections] = {};
+    float avg_[kSections] = {};
+    float worst_ = 0.0f;
+    float worst_sections_[kSections] = {};
+};
+
+class UiSection {
+public:
+    UiSection(UiProfiler& p, UiProfiler::Section s) : p_(p), s_(s) { p_.start(s_); }
+    ~UiSection() { p_.stop(s_); }
+    UiSection(const UiSection&) = delete;
+    UiSection& operator=(const UiSection&) = delete;
+
+private:
+    UiProfiler& p_;
+    UiProfiler::Section s_;
+};
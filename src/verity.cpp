@@ -0,0 +1,178 @@
+// src/verity.cpp
+
+#include "verity.h"
+#include "hash_engine.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unordered_map>
+
+#if defined(__linux__) && __has_include(<linux/fsverity.h>)
+#define HASHNSIGN_HAVE_FSVERITY 1
+#include <fcntl.h>
+#include <linux/fsverity.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+bool verity_measure(const fs::path& file, std::string& digest, std::string& err) {
+#ifdef HASHNSIGN_HAVE_FSVERITY
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        err = std::strerror(errno);
+        return false;
+    }
+    // Cabecera + hueco para el digest más largo (SHA-512)
+    alignas(fsverity_digest) unsigned char raw[sizeof(fsverity_digest) + 64];
+    auto* d = reinterpret_cast<fsverity_digest*>(raw);
+    d->digest_size = 64;
+    int rc = ioctl(fd, FS_IOC_MEASURE_VERITY, d);
+    int e = errno;
+    close(fd);
+    if (rc != 0) {
+        // ENODATA: sin sellar; ENOTTY/EOPNOTSUPP: el fs no tiene verity
+        err = std::strerror(e);
+        return false;
+    }
+    const char* algo = d->digest_algorithm == FS_VERITY_HASH_ALG_SHA512 ? "sha512" : "sha256";
+    static const char* hexd = "0123456789abcdef";
+    digest = std::string(algo) + ":";
+    for (unsigned i = 0; i < d->digest_size; ++i) {
+        digest += hexd[d->digest[i] >> 4];
+        digest += hexd[d->digest[i] & 15];
+    }
+    return true;
+#else
+    (void)file; (void)digest;
+    err = "fs-verity no disponible en esta plataforma";
+    return false;
+#endif
+}
+
+bool verity_enable(const fs::path& file, std::string& err) {
+#ifdef HASHNSIGN_HAVE_FSVERITY
+    // Debe abrirse de solo lectura y sin nadie escribiendo (ETXTBSY si no)
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        err = std::strerror(errno);
+        return false;
+    }
+    fsverity_enable_arg arg{};
+    arg.version = 1;
+    arg.hash_algorithm = FS_VERITY_HASH_ALG_SHA256;
+    arg.block_size = 4096;
+    int rc = ioctl(fd, FS_IOC_ENABLE_VERITY, &arg);
+    int e = errno;
+    close(fd);
+    if (rc != 0 && e != EEXIST) {
+        err = std::strerror(e);
+        return false;
+    }
+    return true;
+#else
+    (void)file;
+    err = "fs-verity no disponible en esta plataforma";
+    return false;
+#endif
+}
+
+static bool md5_of(const fs::path& file, std::string& hex) {
+    HashStats st;
+    std::string err;
+    return hash_file(file, HashOptions{}, hex, st, err);
+}
+
+bool write_verity_manifest(const fs::path& repo, VerityMode mode, std::string& out_log) {
+    fs::path hashes = repo / "hashes.md5";
+    fs::path verity = repo / kVerityManifest;
+    const std::string self = std::string("./") + kVerityManifest;
+    std::error_code ec;
+    if (mode == VerityMode::Off && !fs::exists(verity, ec)) return true;
+
+    std::vector<ManifestEntry> entries;
+    if (!read_manifest(hashes, entries, out_log)) return false;
+
+    std::vector<ManifestEntry> sealed;
+    std::vector<ManifestEntry> kept;
+    kept.reserve(entries.size() + 1);
+    size_t newly = 0, failed = 0;
+    for (auto& e : entries) {
+        if (e.path == self) continue;
+        if (mode != VerityMode::Off) {
+            fs::path f = repo / e.path;
+            std::string digest, err;
+            bool ok = verity_measure(f, digest, err);
+            if (!ok && mode == VerityMode::Seal) {
+                if (verity_enable(f, err)) {
+                    ok = verity_measure(f, digest, err);
+                    if (ok) ++newly;
+                } else if (++failed <= 5) {
+                    out_log += "fs-verity: no se pudo sellar " + e.path + ": " + err + "\n";
+                }
+            }
+            if (ok) sealed.push_back(ManifestEntry{digest, e.path});
+        }
+        kept.push_back(std::move(e));
+    }
+
+    if (sealed.empty()) {
+        fs::remove(verity, ec);
+        if (mode != VerityMode::Off) out_log += "fs-verity: ningún archivo sellado en " + repo.string() + "\n";
+    } else {
+        if (!write_manifest(verity, sealed, out_log)) return false;
+        std::string hex;
+        if (!md5_of(verity, hex)) {
+            out_log += "Error: no se puede leer " + verity.string() + "\n";
+            return false;
+        }
+        kept.push_back(ManifestEntry{hex, self});
+        out_log += "fs-verity: " + std::to_string(sealed.size()) + " de " + std::to_string(kept.size() - 1) +
+                   " archivos sellados (" + std::to_string(newly) + " nuevos) en " + verity.string() + "\n";
+    }
+    if (failed > 5) out_log += "fs-verity: " + std::to_string(failed) + " archivos sin sellar en total\n";
+    return write_manifest(hashes, kept, out_log);
+}
+
+size_t verity_prefilter(const fs::path& repo, std::vector<ManifestEntry>& entries, size_t& failed,
+                        std::string& out_log) {
+    fs::path verity = repo / kVerityManifest;
+    const std::string self = std::string("./") + kVerityManifest;
+    std::error_code ec;
+    if (!fs::exists(verity, ec)) return 0;
+
+    // Solo vale si su contenido es el que avala el manifiesto firmado
+    auto it = std::find_if(entries.begin(), entries.end(), [&](const ManifestEntry& e) { return e.path == self; });
+    std::string hex;
+    if (it == entries.end() || !md5_of(verity, hex) || hex != it->digest) {
+        out_log += "fs-verity: " + verity.string() + " no coincide con hashes.md5, se ignora\n";
+        return 0;
+    }
+
+    std::vector<ManifestEntry> measured;
+    if (!read_manifest(verity, measured, out_log)) return 0;
+    std::unordered_map<std::string, std::string> by_path;
+    for (auto& m : measured) by_path[m.path] = m.digest;
+
+    size_t resolved = 0;
+    std::vector<ManifestEntry> rest;
+    rest.reserve(entries.size());
+    for (auto& e : entries) {
+        auto m = by_path.find(e.path);
+        std::string digest, err;
+        // Sin medida (copiado a otro fs, resellado...) se hashea como siempre
+        if (m == by_path.end() || !verity_measure(repo / e.path, digest, err)) {
+            rest.push_back(std::move(e));
+            continue;
+        }
+        ++resolved;
+        if (digest == m->second) {
+            out_log += e.path + ": OK (fs-verity)\n";
+        } else {
+            out_log += e.path + ": FAILED (fs-verity)\n";
+            ++failed;
+        }
+    }
+    entries.swap(rest);
+    return resolved;
+}
@@ -0,0 +1,45 @@
+// src/verity.h
+// Atajo fs-verity (ext4/f2fs/btrfs con la característica "verity"): el kernel
+// mantiene un árbol de Merkle por archivo sellado y da su raíz en O(1) con
+// FS_IOC_MEASURE_VERITY, y además comprueba cada página al leerla. Un archivo
+// sellado cuya medida coincide con la guardada no hace falta leerlo entero.
+//
+// Las medidas van a hashes.verity ("sha256:<hex>  ./ruta", como "fsverity
+// digest"), que a su vez tiene su línea en hashes.md5: la firma de hashes.md5
+// lo cubre y "md5sum -c" lo sigue comprobando.
+
+#pragma once
+
+#include "manifest.h"
+
+#include <string>
+#include <vector>
+
+// Su línea en hashes.md5 es "./hashes.verity"
+inline constexpr const char* kVerityManifest = "hashes.verity";
+
+enum class VerityMode {
+    Off,     // sin hashes.verity (se borra si había uno)
+    Measure, // anota los archivos que ya tienen fs-verity
+    Seal,    // activa fs-verity en los que no lo tienen: quedan de solo lectura
+};
+
+// Medida fs-verity del archivo como "<algoritmo>:<hex>". false si no está
+// sellado o el sistema de ficheros no lo admite.
+bool verity_measure(const fs::path& file, std::string& digest, std::string& err);
+
+// FS_IOC_ENABLE_VERITY (SHA-256, bloques de 4 KiB). Irreversible: el archivo
+// ya no puede modificarse, solo borrarse o reemplazarse.
+bool verity_enable(const fs::path& file, std::string& err);
+
+// Reescribe hashes.verity a partir de las entradas de hashes.md5 y actualiza
+// la línea "./hashes.verity" de este. Llamar tras generar hashes.md5.
+bool write_verity_manifest(const fs::path& repo, VerityMode mode, std::string& out_log);
+
+// Antes de hashear para verificar: si hashes.verity está avalado por su línea
+// (que tiene que seguir en 'entries', aunque se haya filtrado lo demás)
+// en hashes.md5, las entradas selladas se resuelven por su medida y se quitan
+// de 'entries' (escribiendo OK/FAILED en el log). Devuelve cuántas se
+// resolvieron; 'failed' suma las que no coinciden.
+size_t verity_prefilter(const fs::path& repo, std::vector<ManifestEntry>& entries, size_t& failed,
+                        std::string& out_log);